@@ -0,0 +1,282 @@
+#include "CompressedVolumeReader.h"
+
+#include "MappedFile.h"
+#include "ScalarNarrowing.h"
+
+#include <vtk_zlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// Compressed bytes handed to zlib at a time, its counts are 32 bit
+static const size_t sInflateChunkBytes(1 << 20);
+// How far the prefetch thread runs ahead of the inflate
+static const size_t sPrefetchAheadBytes(64 << 20);
+static const size_t sPageBytes(4096);
+
+
+// Touches one byte per page of the compressed data, keeping ahead of the inflate
+static void PrefetchPages(
+	const unsigned char *compressedData,
+	const size_t compressedBytes,
+	const std::atomic<size_t> &inflatePosition,
+	const std::atomic<bool> &finished)
+{
+	volatile unsigned char sink(0);
+
+	for (size_t position = 0; position < compressedBytes && !finished; position += sPageBytes)
+	{
+		while (position > inflatePosition + sPrefetchAheadBytes && !finished)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		sink ^= compressedData[position];
+	}
+}
+
+
+template<typename ScalarType> static void SliceRange(
+	const ScalarType *slice,
+	const size_t sliceValues,
+	double &minValue,
+	double &maxValue)
+{
+	ScalarType lo = slice[0];
+	ScalarType hi = slice[0];
+
+	for (size_t i = 1; i < sliceValues; ++i)
+	{
+		lo = std::min(lo, slice[i]);
+		hi = std::max(hi, slice[i]);
+	}
+
+	minValue = std::min(minValue, static_cast<double>(lo));
+	maxValue = std::max(maxValue, static_cast<double>(hi));
+}
+
+
+// Slices completed by the inflate, for the range thread to scan
+class SliceHandoff
+{
+public:
+	SliceHandoff()
+		: mNReady(0)
+		, mFinished(false)
+	{}
+
+	void Ready(const size_t nReady)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mNReady = nReady;
+		mReady.notify_one();
+	}
+
+	void Finish()
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mFinished = true;
+		mReady.notify_one();
+	}
+
+	// Waits for more than nSeen slices, returns nSeen once there will be no more
+	size_t WaitForMore(const size_t nSeen)
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mReady.wait(lock, [this, nSeen]() { return mNReady > nSeen || mFinished; });
+		return mNReady;
+	}
+
+private:
+	std::mutex mMutex;
+	std::condition_variable mReady;
+	size_t mNReady;
+	bool mFinished;
+};
+
+
+vtkSmartPointer<vtkImageData> CompressedVolumeReader::Read(
+	const RawVolumeLayout &layout,
+	const bool reverseSlices,
+	LoadProgress *progress)
+{
+	std::shared_ptr<MappedFile> mappedFile = MappedFile::Open(layout.dataFile);
+	if (nullptr == mappedFile)
+	{
+		return nullptr;
+	}
+
+	// a MetaImage HeaderSize of -1 can only be followed if the compressed size is known
+	size_t dataOffset;
+	if (layout.dataOffset >= 0)
+	{
+		dataOffset = static_cast<size_t>(layout.dataOffset);
+	}
+	else if (layout.compressedBytes > 0 &&
+		static_cast<size_t>(layout.compressedBytes) <= mappedFile->GetSize())
+	{
+		dataOffset = mappedFile->GetSize() - static_cast<size_t>(layout.compressedBytes);
+	}
+	else
+	{
+		return nullptr;
+	}
+
+	if (dataOffset >= mappedFile->GetSize())
+	{
+		return nullptr;
+	}
+
+	const unsigned char *compressedData = mappedFile->GetData() + dataOffset;
+	const size_t compressedBytes = (layout.compressedBytes > 0)
+		? std::min(static_cast<size_t>(layout.compressedBytes), mappedFile->GetSize() - dataOffset)
+		: mappedFile->GetSize() - dataOffset;
+
+	auto volumeImageData = vtkSmartPointer<vtkImageData>::New();
+	volumeImageData->SetDimensions(layout.dimensions.data());
+	volumeImageData->SetSpacing(layout.spacing.data());
+	volumeImageData->SetOrigin(layout.origin.data());
+	volumeImageData->AllocateScalars(layout.scalarType, layout.nComponents);
+
+	unsigned char *volumeDataPtr = static_cast<unsigned char*>(volumeImageData->GetScalarPointer());
+	if (nullptr == volumeDataPtr)
+	{
+		return nullptr;
+	}
+
+	const size_t nSlices = static_cast<size_t>(layout.dimensions[2]);
+	const size_t sliceBytes = layout.GetDataBytes() / nSlices;
+	const size_t sliceValues =
+		static_cast<size_t>(layout.dimensions[0]) *
+		static_cast<size_t>(layout.dimensions[1]);
+
+	auto slicePointer = [volumeDataPtr, sliceBytes, nSlices, reverseSlices](const size_t iFileSlice)
+	{
+		const size_t z = reverseSlices ? nSlices - 1 - iFileSlice : iFileSlice;
+		return volumeDataPtr + (z * sliceBytes);
+	};
+
+	std::atomic<size_t> inflatePosition(0);
+	std::atomic<bool> finished(false);
+	std::thread prefetchThread(PrefetchPages,
+		compressedData, compressedBytes, std::cref(inflatePosition), std::cref(finished));
+
+	// the range is only of use to ScalarNarrowing, which takes single components
+	const bool scanRange = (1 == layout.nComponents);
+	double minValue = std::numeric_limits<double>::max();
+	double maxValue = std::numeric_limits<double>::lowest();
+	SliceHandoff handoff;
+
+	std::thread rangeThread([&]()
+	{
+		if (!scanRange)
+		{
+			return;
+		}
+
+		for (size_t nSeen = 0, nReady; (nReady = handoff.WaitForMore(nSeen)) > nSeen; nSeen = nReady)
+		{
+			for (size_t iFileSlice = nSeen; iFileSlice < nReady; ++iFileSlice)
+			{
+				void *slice = slicePointer(iFileSlice);
+
+				switch (layout.scalarType)
+				{
+					vtkTemplateMacro(SliceRange(
+						static_cast<const VTK_TT*>(slice), sliceValues, minValue, maxValue));
+				}
+			}
+		}
+	});
+
+	// 15 window bits, plus 32 to take either a zlib or a gzip header
+	z_stream stream = {};
+	bool inflated = (Z_OK == inflateInit2(&stream, 15 + 32));
+	size_t consumed(0);
+
+	auto inflateInto = [&](unsigned char *out, const size_t outBytes) -> bool
+	{
+		stream.next_out = out;
+		stream.avail_out = static_cast<uInt>(outBytes);
+
+		while (stream.avail_out > 0)
+		{
+			if (0 == stream.avail_in)
+			{
+				if (consumed >= compressedBytes)
+				{
+					return false;
+				}
+
+				const size_t chunkBytes = std::min(sInflateChunkBytes, compressedBytes - consumed);
+				stream.next_in = const_cast<Bytef*>(compressedData + consumed);
+				stream.avail_in = static_cast<uInt>(chunkBytes);
+				consumed += chunkBytes;
+				inflatePosition = consumed;
+			}
+
+			const int result = inflate(&stream, Z_NO_FLUSH);
+
+			// the stream ending early means the file is short
+			if ((Z_STREAM_END == result && stream.avail_out > 0) ||
+				(Z_OK != result && Z_STREAM_END != result && Z_BUF_ERROR != result))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	};
+
+	// whatever comes before the voxels in the stream, such as a NIfTI header
+	if (inflated && layout.inflatedOffset > 0)
+	{
+		std::vector<unsigned char> skipped(static_cast<size_t>(layout.inflatedOffset));
+		inflated = inflateInto(skipped.data(), skipped.size());
+	}
+
+	for (size_t iFileSlice = 0; iFileSlice < nSlices && inflated; ++iFileSlice)
+	{
+		inflated = inflateInto(slicePointer(iFileSlice), sliceBytes);
+
+		if (inflated)
+		{
+			handoff.Ready(iFileSlice + 1);
+		}
+
+		if (nullptr != progress)
+		{
+			progress->Report(static_cast<double>(iFileSlice + 1) / nSlices);
+
+			if (progress->IsCancelled())
+			{
+				inflated = false;
+			}
+		}
+	}
+
+	inflateEnd(&stream);
+
+	finished = true;
+	handoff.Finish();
+	prefetchThread.join();
+	rangeThread.join();
+
+	if (!inflated)
+	{
+		return nullptr;
+	}
+
+	if (scanRange)
+	{
+		ScalarNarrowing::AttachScalarRange(volumeImageData, minValue, maxValue);
+	}
+
+	return volumeImageData;
+}
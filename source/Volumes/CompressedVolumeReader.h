@@ -0,0 +1,32 @@
+#pragma once
+
+#include "LoadProgress.h"
+#include "RawVolumeHeader.h"
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+
+/*
+ * Reads a MetaImage, NRRD or NIfTI volume stored as one zlib or gzip stream. A
+ * single deflate stream cannot be split between threads, so the work
+ * around the inflate is overlapped with it instead:
+ * - a prefetch thread faults in the mapped compressed data ahead of the
+ *   inflate, so it never waits on the disk;
+ * - each slice is inflated straight into its place in the volume, reversed
+ *   along z if asked, with no intermediate buffer, copy or flip;
+ * - a range thread scans each slice as it completes, and attaches the range
+ *   for ScalarNarrowing, so narrowing needs no scan of its own.
+ */
+class CompressedVolumeReader
+{
+public:
+	/*
+	 * Returns nullptr if the stream is corrupt or too short, or if the load
+	 * is cancelled.
+	 */
+	static vtkSmartPointer<vtkImageData> Read(
+		const RawVolumeLayout &layout,
+		const bool reverseSlices,
+		LoadProgress *progress = nullptr);
+};
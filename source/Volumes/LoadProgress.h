@@ -0,0 +1,50 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+
+
+/*
+ * Progress and cancellation shared between a loader running on a worker
+ * thread and the threads polling it. Loaders report their own progress as a
+ * 0 to 1 fraction, which is mapped into the range set by the owner, so one
+ * load can be split into stages (e.g. read, then flip).
+ */
+class LoadProgress
+{
+public:
+	LoadProgress()
+		: mFraction(0.0f)
+		, mCancelled(false)
+		, mRangeBegin(0.0f)
+		, mRangeEnd(1.0f)
+	{}
+
+	void SetRange(
+		const float rangeBegin,
+		const float rangeEnd)
+	{
+		mRangeBegin = rangeBegin;
+		mRangeEnd = rangeEnd;
+		mFraction = rangeBegin;
+	}
+
+	void Report(
+		const double stageFraction)
+	{
+		const float clipped = static_cast<float>(
+			std::max(0.0, std::min(1.0, stageFraction)));
+		mFraction = mRangeBegin + (clipped * (mRangeEnd - mRangeBegin));
+	}
+
+	float GetFraction() const { return mFraction; }
+
+	void Cancel() { mCancelled = true; }
+	bool IsCancelled() const { return mCancelled; }
+
+private:
+	std::atomic<float> mFraction;
+	std::atomic<bool> mCancelled;
+	float mRangeBegin;
+	float mRangeEnd;
+};
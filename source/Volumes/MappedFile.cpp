@@ -0,0 +1,136 @@
+#include "MappedFile.h"
+
+#if UNITY_WIN
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+MappedFile::MappedFile()
+#if UNITY_WIN
+	: mFile(INVALID_HANDLE_VALUE)
+	, mMapping(nullptr)
+#else
+	: mFile(-1)
+#endif
+	, mData(nullptr)
+	, mSize(0)
+{}
+
+
+#if UNITY_WIN
+
+std::shared_ptr<MappedFile> MappedFile::Open(
+	const std::string &path)
+{
+	std::shared_ptr<MappedFile> mappedFile(new MappedFile());
+
+	mappedFile->mFile = CreateFileA(
+		path.c_str(),
+		GENERIC_READ,
+		FILE_SHARE_READ,
+		nullptr,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL,
+		nullptr);
+
+	LARGE_INTEGER fileSize;
+	if (INVALID_HANDLE_VALUE == mappedFile->mFile ||
+		!GetFileSizeEx(mappedFile->mFile, &fileSize) ||
+		0 == fileSize.QuadPart)
+	{
+		return nullptr;
+	}
+
+	mappedFile->mMapping = CreateFileMappingA(
+		mappedFile->mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+	if (nullptr == mappedFile->mMapping)
+	{
+		return nullptr;
+	}
+
+	mappedFile->mData = static_cast<const unsigned char*>(
+		MapViewOfFile(mappedFile->mMapping, FILE_MAP_READ, 0, 0, 0));
+	mappedFile->mSize = static_cast<size_t>(fileSize.QuadPart);
+
+	if (nullptr == mappedFile->mData)
+	{
+		return nullptr;
+	}
+
+	return mappedFile;
+}
+
+
+MappedFile::~MappedFile()
+{
+	if (nullptr != mData)
+	{
+		UnmapViewOfFile(mData);
+	}
+
+	if (nullptr != mMapping)
+	{
+		CloseHandle(mMapping);
+	}
+
+	if (INVALID_HANDLE_VALUE != mFile)
+	{
+		CloseHandle(mFile);
+	}
+}
+
+#else
+
+std::shared_ptr<MappedFile> MappedFile::Open(
+	const std::string &path)
+{
+	std::shared_ptr<MappedFile> mappedFile(new MappedFile());
+
+	mappedFile->mFile = open(path.c_str(), O_RDONLY);
+
+	struct stat fileStat;
+	if (mappedFile->mFile < 0 ||
+		0 != fstat(mappedFile->mFile, &fileStat) ||
+		0 == fileStat.st_size)
+	{
+		return nullptr;
+	}
+
+	void *data = mmap(
+		nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_SHARED, mappedFile->mFile, 0);
+
+	if (MAP_FAILED == data)
+	{
+		return nullptr;
+	}
+
+	mappedFile->mData = static_cast<const unsigned char*>(data);
+	mappedFile->mSize = static_cast<size_t>(fileStat.st_size);
+
+	return mappedFile;
+}
+
+
+MappedFile::~MappedFile()
+{
+	if (nullptr != mData)
+	{
+		munmap(const_cast<unsigned char*>(mData), mSize);
+	}
+
+	if (mFile >= 0)
+	{
+		close(mFile);
+	}
+}
+
+#endif
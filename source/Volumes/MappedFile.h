@@ -0,0 +1,42 @@
+#pragma once
+
+#include "../PlatformBase.h"
+
+#include <memory>
+#include <string>
+
+
+/*
+ * A whole file mapped read-only into memory. The pages are shared with the
+ * OS file cache, so mapping a file already cached, or mapped by another
+ * process, costs no reading and no extra memory. The mapping lasts as long
+ * as the object, hence the shared_ptr for anything referencing the data.
+ */
+class MappedFile
+{
+public:
+	/*
+	 * Returns nullptr if the file cannot be opened or is empty.
+	 */
+	static std::shared_ptr<MappedFile> Open(
+		const std::string &path);
+
+	~MappedFile();
+
+	const unsigned char *GetData() const { return mData; }
+	size_t GetSize() const { return mSize; }
+
+private:
+	MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+#if UNITY_WIN
+	void *mFile;
+	void *mMapping;
+#else
+	int mFile;
+#endif
+	const unsigned char *mData;
+	size_t mSize;
+};
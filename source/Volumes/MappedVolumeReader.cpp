@@ -0,0 +1,53 @@
+#include "MappedVolumeReader.h"
+
+#include "VolumeBuffer.h"
+
+
+vtkSmartPointer<vtkImageData> MappedVolumeReader::Read(
+	const VolumeFileFormat format,
+	const std::string &path)
+{
+	RawVolumeLayout layout;
+
+	if (!RawVolumeHeader::Read(format, path, layout) ||
+		layout.compressed)
+	{
+		return nullptr;
+	}
+
+	std::shared_ptr<MappedFile> mappedFile = MappedFile::Open(layout.dataFile);
+	const size_t dataBytes = layout.GetDataBytes();
+
+	if (nullptr == mappedFile ||
+		mappedFile->GetSize() < dataBytes)
+	{
+		return nullptr;
+	}
+
+	// a negative offset puts the data at the end of the file
+	const size_t dataOffset = (layout.dataOffset < 0)
+		? mappedFile->GetSize() - dataBytes
+		: static_cast<size_t>(layout.dataOffset);
+
+	if (dataOffset + dataBytes > mappedFile->GetSize())
+	{
+		return nullptr;
+	}
+
+	return Wrap(mappedFile, dataOffset, layout);
+}
+
+
+vtkSmartPointer<vtkImageData> MappedVolumeReader::Wrap(
+	std::shared_ptr<MappedFile> mappedFile,
+	const size_t dataOffset,
+	const RawVolumeLayout &layout)
+{
+	// VTK only takes a non-const pointer, the pages are read-only and nothing
+	// writes to a volume's scalars in place once it has been loaded. The
+	// release function holds a reference to the mapping until the scalars go
+	return VolumeBuffer::Wrap(
+		const_cast<unsigned char*>(mappedFile->GetData() + dataOffset),
+		layout,
+		[mappedFile]() {});
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "MappedFile.h"
+#include "RawVolumeHeader.h"
+
+#include "../VtkToUnityAPIDefines.h"
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+#include <string>
+
+
+class MappedVolumeReader
+{
+public:
+	/*
+	 * Maps the voxels of an uncompressed MetaImage or NRRD volume read-only,
+	 * and wraps the mapping as the volume's scalars without copying. The
+	 * mapping is released with the scalar array. Slices are left in file
+	 * order, see ReverseVolumeAlongZ. Returns nullptr for any volume that
+	 * cannot be used in place (compressed, big endian, one file per slice,
+	 * short data file) so the caller can fall back to the VTK reader.
+	 */
+	static vtkSmartPointer<vtkImageData> Read(
+		const VolumeFileFormat format,
+		const std::string &path);
+
+	/*
+	 * Wraps the voxels at dataOffset in the mapping as a volume with the
+	 * layout's geometry, keeping the mapping alive as long as the scalars.
+	 */
+	static vtkSmartPointer<vtkImageData> Wrap(
+		std::shared_ptr<MappedFile> mappedFile,
+		const size_t dataOffset,
+		const RawVolumeLayout &layout);
+};
@@ -0,0 +1,221 @@
+#include "PackedVolumeMask.h"
+
+#include "ParallelFor.h"
+
+#include <vtkDataArray.h>
+#include <vtkPointData.h>
+#include <vtkType.h>
+
+#include <algorithm>
+
+
+// Each parallel item packs or expands whole words, so no two threads share one
+static const size_t sWordsPerChunk(4096);
+static const size_t sBitsPerWord(64);
+
+
+template<typename ScalarType> static void PackPadding(
+	const ScalarType *volumeDataPtr,
+	const size_t nComponents,
+	const size_t nVoxels,
+	const double paddingValue,
+	uint64_t *bits,
+	const size_t nWords)
+{
+	const double paddingMin(paddingValue - 0.5);
+	const double paddingMax(paddingValue + 0.5);
+
+	ParallelFor((nWords + sWordsPerChunk - 1) / sWordsPerChunk, [&](const size_t iChunk)
+	{
+		const size_t wordEnd = std::min(nWords, (iChunk + 1) * sWordsPerChunk);
+
+		for (size_t iWord = iChunk * sWordsPerChunk; iWord < wordEnd; ++iWord)
+		{
+			const size_t voxelBegin = iWord * sBitsPerWord;
+			const size_t nWordVoxels = std::min(sBitsPerWord, nVoxels - voxelBegin);
+			uint64_t word(0);
+
+			// branch free, so the compiler vectorises the comparisons
+			for (size_t iBit = 0; iBit < nWordVoxels; ++iBit)
+			{
+				const double value = static_cast<double>(volumeDataPtr[(voxelBegin + iBit) * nComponents]);
+				const uint64_t kept = (value < paddingMin) | (value > paddingMax);
+				word |= kept << iBit;
+			}
+
+			bits[iWord] = word;
+		}
+	});
+}
+
+
+template<typename ScalarType> static void PackPaddingByBrick(
+	const ScalarType *volumeDataPtr,
+	const size_t nComponents,
+	const size_t nVoxels,
+	const int *dimensions,
+	const VolumeBricks &bricks,
+	const double paddingValue,
+	uint64_t *bits,
+	const size_t nWords)
+{
+	const double paddingMin(paddingValue - 0.5);
+	const double paddingMax(paddingValue + 0.5);
+	const size_t rowVoxels = static_cast<size_t>(dimensions[0]);
+	const size_t brickSize = static_cast<size_t>(bricks.GetBrickSize());
+
+	ParallelFor((nWords + sWordsPerChunk - 1) / sWordsPerChunk, [&](const size_t iChunk)
+	{
+		const size_t wordEnd = std::min(nWords, (iChunk + 1) * sWordsPerChunk);
+
+		for (size_t iWord = iChunk * sWordsPerChunk; iWord < wordEnd; ++iWord)
+		{
+			const size_t voxelBegin = iWord * sBitsPerWord;
+			const size_t nWordVoxels = std::min(sBitsPerWord, nVoxels - voxelBegin);
+			uint64_t word(0);
+
+			// a word covers runs of a row each within one brick
+			for (size_t iBit = 0; iBit < nWordVoxels; )
+			{
+				const size_t voxel = voxelBegin + iBit;
+				const size_t x = voxel % rowVoxels;
+				const size_t row = voxel / rowVoxels;
+				const size_t brick = bricks.GetBrickIndex(static_cast<int>(x),
+					static_cast<int>(row % dimensions[1]), static_cast<int>(row / dimensions[1]));
+				const size_t runEnd = iBit + std::min(nWordVoxels - iBit,
+					std::min(brickSize - (x % brickSize), rowVoxels - x));
+
+				if (bricks.GetBrickMin(brick) > paddingMax ||
+					bricks.GetBrickMax(brick) < paddingMin)
+				{
+					for (; iBit < runEnd; ++iBit)
+					{
+						word |= uint64_t(1) << iBit;
+					}
+				}
+				else if (bricks.IsAllPadding(brick))
+				{
+					iBit = runEnd;
+				}
+				else
+				{
+					for (; iBit < runEnd; ++iBit)
+					{
+						const double value = static_cast<double>(volumeDataPtr[(voxelBegin + iBit) * nComponents]);
+						const uint64_t kept = (value < paddingMin) | (value > paddingMax);
+						word |= kept << iBit;
+					}
+				}
+			}
+
+			bits[iWord] = word;
+		}
+	});
+}
+
+
+std::shared_ptr<PackedVolumeMask> PackedVolumeMask::FromPadding(
+	vtkImageData *volumeImageData,
+	const double paddingValue,
+	const VolumeBricks *bricks)
+{
+	vtkDataArray *scalars = volumeImageData->GetPointData()->GetScalars();
+
+	if (nullptr == scalars)
+	{
+		return nullptr;
+	}
+
+	std::shared_ptr<PackedVolumeMask> mask(new PackedVolumeMask());
+	mask->mNVoxels = static_cast<size_t>(scalars->GetNumberOfTuples());
+	mask->mBits.resize((mask->mNVoxels + sBitsPerWord - 1) / sBitsPerWord);
+
+	void *volumeDataPtr = scalars->GetVoidPointer(0);
+	const size_t nComponents = static_cast<size_t>(scalars->GetNumberOfComponents());
+
+	if (nullptr != bricks)
+	{
+		int dimensions[3];
+		volumeImageData->GetDimensions(dimensions);
+
+		switch (scalars->GetDataType())
+		{
+			vtkTemplateMacro(PackPaddingByBrick(
+				static_cast<const VTK_TT*>(volumeDataPtr),
+				nComponents,
+				mask->mNVoxels,
+				dimensions,
+				*bricks,
+				paddingValue,
+				mask->mBits.data(),
+				mask->mBits.size()));
+		default:
+			return nullptr;
+		}
+
+		return mask;
+	}
+
+	switch (scalars->GetDataType())
+	{
+		vtkTemplateMacro(PackPadding(
+			static_cast<const VTK_TT*>(volumeDataPtr),
+			nComponents,
+			mask->mNVoxels,
+			paddingValue,
+			mask->mBits.data(),
+			mask->mBits.size()));
+	default:
+		return nullptr;
+	}
+
+	return mask;
+}
+
+
+vtkSmartPointer<vtkImageData> PackedVolumeMask::Expand(
+	vtkImageData *volumeImageData) const
+{
+	auto maskImageData = vtkSmartPointer<vtkImageData>::New();
+	maskImageData->SetExtent(volumeImageData->GetExtent());
+	maskImageData->SetSpacing(volumeImageData->GetSpacing());
+	maskImageData->SetOrigin(volumeImageData->GetOrigin());
+	maskImageData->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+
+	unsigned char *maskDataPtr = static_cast<unsigned char*>(maskImageData->GetScalarPointer());
+	const uint64_t *bits = mBits.data();
+	const size_t nWords = mBits.size();
+	const size_t nVoxels = mNVoxels;
+
+	ParallelFor((nWords + sWordsPerChunk - 1) / sWordsPerChunk, [&](const size_t iChunk)
+	{
+		const size_t wordEnd = std::min(nWords, (iChunk + 1) * sWordsPerChunk);
+
+		for (size_t iWord = iChunk * sWordsPerChunk; iWord < wordEnd; ++iWord)
+		{
+			const size_t voxelBegin = iWord * sBitsPerWord;
+			const size_t nWordVoxels = std::min(sBitsPerWord, nVoxels - voxelBegin);
+			const uint64_t word = bits[iWord];
+
+			for (size_t iBit = 0; iBit < nWordVoxels; ++iBit)
+			{
+				maskDataPtr[voxelBegin + iBit] =
+					static_cast<unsigned char>(0 - ((word >> iBit) & 1));
+			}
+		}
+	});
+
+	return maskImageData;
+}
+
+
+size_t PackedVolumeMask::GetNVoxels() const
+{
+	return mNVoxels;
+}
+
+
+const std::vector<uint64_t> &PackedVolumeMask::GetBits() const
+{
+	return mBits;
+}
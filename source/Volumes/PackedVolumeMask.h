@@ -0,0 +1,53 @@
+#pragma once
+
+#include "VolumeBricks.h"
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+
+/*
+ * A binary volume mask kept at one bit per voxel, an eighth of the
+ * vtkImageData the GPU mapper takes, which is only made by Expand when the
+ * mask is about to be uploaded. Bits are in voxel order, x fastest.
+ */
+class PackedVolumeMask
+{
+public:
+	/*
+	 * Masks out the voxels within 0.5 of paddingValue, given in stored
+	 * scalar units, keeping all others, as vtkImageThreshold did. Only the
+	 * first component is tested. Returns nullptr if the volume has no
+	 * scalars. Given the volume's bricks, the voxels of bricks whose range
+	 * decides them are not read.
+	 */
+	static std::shared_ptr<PackedVolumeMask> FromPadding(
+		vtkImageData *volumeImageData,
+		const double paddingValue,
+		const VolumeBricks *bricks = nullptr);
+
+	/*
+	 * An unsigned char image on the volume's grid, 255 where the voxel is
+	 * kept and 0 where it is masked out.
+	 */
+	vtkSmartPointer<vtkImageData> Expand(
+		vtkImageData *volumeImageData) const;
+
+	size_t GetNVoxels() const;
+
+	/*
+	 * 64 voxels a word, lowest bit first, set where the voxel is kept.
+	 */
+	const std::vector<uint64_t> &GetBits() const;
+
+private:
+	PackedVolumeMask() = default;
+
+	std::vector<uint64_t> mBits;
+	size_t mNVoxels = 0;
+};
@@ -0,0 +1,452 @@
+#include "ParallelDicomReader.h"
+
+#include "ParallelFor.h"
+#include "VolumePreview.h"
+
+#include <DICOMAppHelper.h>
+#include <DICOMParser.h>
+
+#include <vtkDirectory.h>
+#include <vtkNew.h>
+#include <vtkType.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <string.h>
+#include <vector>
+
+
+struct DicomSliceHeader
+{
+	std::string fileName;
+	bool valid = false;
+	std::array<int, 2> dimensions{ { 0, 0 } };
+	int bitsAllocated = 0;
+	int nComponents = 0;
+	bool isFloat = false;
+	bool isSigned = false;
+	std::array<float, 3> pixelSpacing{ { 1.0f, 1.0f, 1.0f } };
+	std::array<float, 3> position{ { 0.0f, 0.0f, 0.0f } };
+	std::array<float, 6> orientation{ { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f } };
+	int sliceNumber = 0;
+	double sortKey = 0.0;
+};
+
+
+static std::string JoinPath(
+	const std::string &folder,
+	const std::string &fileName)
+{
+	if (folder.empty() ||
+		folder.back() == '/' ||
+		folder.back() == '\\')
+	{
+		return folder + fileName;
+	}
+
+	return folder + "/" + fileName;
+}
+
+
+static std::vector<std::string> ListFolderFiles(
+	const std::string &folder)
+{
+	std::vector<std::string> fileNames;
+
+	vtkNew<vtkDirectory> directory;
+	if (!directory->Open(folder.c_str()))
+	{
+		return fileNames;
+	}
+
+	for (vtkIdType iFile = 0; iFile < directory->GetNumberOfFiles(); ++iFile)
+	{
+		const char *fileName = directory->GetFile(iFile);
+		const std::string filePath = JoinPath(folder, fileName);
+
+		if (0 == strcmp(fileName, ".") ||
+			0 == strcmp(fileName, "..") ||
+			directory->FileIsDirectory(filePath.c_str()))
+		{
+			continue;
+		}
+
+		fileNames.push_back(filePath);
+	}
+
+	// directory order is file system dependent, keep ties in the sort stable
+	std::sort(fileNames.begin(), fileNames.end());
+	return fileNames;
+}
+
+
+static void ReadSliceHeader(
+	DicomSliceHeader &header)
+{
+	DICOMParser parser;
+	DICOMAppHelper appHelper;
+
+	if (!parser.OpenFile(header.fileName))
+	{
+		return;
+	}
+
+	appHelper.Clear();
+	appHelper.RegisterCallbacks(&parser);
+
+	const bool isDicom = parser.ReadHeader();
+	parser.CloseFile();
+
+	if (!isDicom)
+	{
+		return;
+	}
+
+	const int *dimensions = appHelper.GetDimensions();
+	const float *pixelSpacing = appHelper.GetPixelSpacing();
+	const float *position = appHelper.GetImagePositionPatient();
+	const float *orientation = appHelper.GetImageOrientationPatient();
+
+	std::copy(dimensions, dimensions + 2, header.dimensions.begin());
+	std::copy(pixelSpacing, pixelSpacing + 3, header.pixelSpacing.begin());
+	std::copy(position, position + 3, header.position.begin());
+	std::copy(orientation, orientation + 6, header.orientation.begin());
+
+	header.bitsAllocated = appHelper.GetBitsAllocated();
+	header.nComponents = appHelper.GetNumberOfComponents();
+	header.isFloat = appHelper.RescaledImageDataIsFloat();
+	header.isSigned = appHelper.RescaledImageDataIsSigned();
+	header.sliceNumber = appHelper.GetSliceNumber();
+
+	header.valid =
+		header.dimensions[0] > 0 &&
+		header.dimensions[1] > 0 &&
+		header.nComponents > 0;
+}
+
+
+// Slices are ordered along the slice normal when the orientation is known,
+// as vtkDICOMImageReader does, otherwise by their instance number
+static void SortSlices(
+	std::vector<DicomSliceHeader> &headers)
+{
+	const auto &o = headers.front().orientation;
+	const std::array<double, 3> normal{ {
+		(o[1] * o[5]) - (o[2] * o[4]),
+		(o[2] * o[3]) - (o[0] * o[5]),
+		(o[0] * o[4]) - (o[1] * o[3]) } };
+
+	const bool haveNormal =
+		0.0 != normal[0] || 0.0 != normal[1] || 0.0 != normal[2];
+
+	for (auto &header : headers)
+	{
+		header.sortKey = haveNormal
+			? (header.position[0] * normal[0]) +
+				(header.position[1] * normal[1]) +
+				(header.position[2] * normal[2])
+			: static_cast<double>(header.sliceNumber);
+	}
+
+	std::stable_sort(headers.begin(), headers.end(),
+		[](const DicomSliceHeader &a, const DicomSliceHeader &b)
+		{
+			return a.sortKey < b.sortKey;
+		});
+}
+
+
+static int DicomScalarType(
+	const DicomSliceHeader &header)
+{
+	if (header.isFloat)
+	{
+		return VTK_FLOAT;
+	}
+
+	switch (header.bitsAllocated)
+	{
+	case 8:
+		return header.isSigned ? VTK_SIGNED_CHAR : VTK_UNSIGNED_CHAR;
+	case 16:
+		return header.isSigned ? VTK_SHORT : VTK_UNSIGNED_SHORT;
+	case 32:
+		return header.isSigned ? VTK_INT : VTK_UNSIGNED_INT;
+	default:
+		return VTK_VOID;
+	}
+}
+
+
+static bool SameSliceFormat(
+	const DicomSliceHeader &a,
+	const DicomSliceHeader &b)
+{
+	return a.dimensions == b.dimensions &&
+		a.nComponents == b.nComponents &&
+		DicomScalarType(a) == DicomScalarType(b);
+}
+
+
+static bool DecodeSlice(
+	const std::string &fileName,
+	unsigned char *sliceOut,
+	const size_t sliceBytes)
+{
+	DICOMParser parser;
+	DICOMAppHelper appHelper;
+
+	if (!parser.OpenFile(fileName))
+	{
+		return false;
+	}
+
+	appHelper.Clear();
+	appHelper.RegisterCallbacks(&parser);
+	appHelper.RegisterPixelDataCallback(&parser);
+
+	const bool isDicom = parser.ReadHeader();
+	parser.CloseFile();
+
+	if (!isDicom)
+	{
+		return false;
+	}
+
+	// the helper has already applied any rescale slope and intercept
+	void *imageData = nullptr;
+	DICOMParser::VRTypes dataType;
+	unsigned long imageDataLengthInBytes = 0;
+	appHelper.GetImageData(imageData, dataType, imageDataLengthInBytes);
+
+	if (nullptr == imageData ||
+		imageDataLengthInBytes < sliceBytes)
+	{
+		return false;
+	}
+
+	memcpy(sliceOut, imageData, sliceBytes);
+	return true;
+}
+
+
+// Headers are cheap next to the pixel data, give them a small share of the progress
+static const double sHeaderProgressFraction(0.1);
+
+
+static bool IsCancelled(
+	const LoadProgress *progress)
+{
+	return nullptr != progress && progress->IsCancelled();
+}
+
+
+// Parses, orders and checks the headers of the series, false if it is not a usable series
+static bool ReadSeriesHeaders(
+	const std::string &folder,
+	LoadProgress *progress,
+	std::vector<DicomSliceHeader> &headers)
+{
+	for (const auto &fileName : ListFolderFiles(folder))
+	{
+		headers.push_back(DicomSliceHeader());
+		headers.back().fileName = fileName;
+	}
+
+	// Pass 1 - parse the headers only, pixel data is skipped by the parser
+	ParallelFor(headers.size(), [&headers, progress](const size_t iSlice)
+	{
+		if (!IsCancelled(progress))
+		{
+			ReadSliceHeader(headers[iSlice]);
+		}
+	});
+
+	if (IsCancelled(progress))
+	{
+		return false;
+	}
+
+	if (nullptr != progress)
+	{
+		progress->Report(sHeaderProgressFraction);
+	}
+
+	headers.erase(
+		std::remove_if(headers.begin(), headers.end(),
+			[](const DicomSliceHeader &header) { return !header.valid; }),
+		headers.end());
+
+	if (headers.empty())
+	{
+		return false;
+	}
+
+	SortSlices(headers);
+
+	const DicomSliceHeader &first = headers.front();
+
+	return VTK_VOID != DicomScalarType(first) &&
+		std::all_of(headers.begin(), headers.end(),
+			[&first](const DicomSliceHeader &header) { return SameSliceFormat(first, header); });
+}
+
+
+// The volume the series makes, without any scalars
+static vtkSmartPointer<vtkImageData> NewSeriesGeometry(
+	const std::vector<DicomSliceHeader> &headers)
+{
+	const DicomSliceHeader &first = headers.front();
+
+	auto volumeImageData = vtkSmartPointer<vtkImageData>::New();
+	volumeImageData->SetDimensions(
+		first.dimensions[0],
+		first.dimensions[1],
+		static_cast<int>(headers.size()));
+	volumeImageData->SetSpacing(
+		first.pixelSpacing[0],
+		first.pixelSpacing[1],
+		first.pixelSpacing[2]);
+	volumeImageData->SetOrigin(
+		first.position[0],
+		first.position[1],
+		first.position[2]);
+
+	return volumeImageData;
+}
+
+
+vtkSmartPointer<vtkImageData> ParallelDicomReader::Read(
+	const std::string &folder,
+	const bool reverseSlices,
+	LoadProgress *progress)
+{
+	std::vector<DicomSliceHeader> headers;
+	if (!ReadSeriesHeaders(folder, progress, headers))
+	{
+		return nullptr;
+	}
+
+	const DicomSliceHeader &first = headers.front();
+
+	auto volumeImageData = NewSeriesGeometry(headers);
+	volumeImageData->AllocateScalars(DicomScalarType(first), first.nComponents);
+
+	const size_t sliceBytes =
+		static_cast<size_t>(first.dimensions[0]) *
+		static_cast<size_t>(first.dimensions[1]) *
+		static_cast<size_t>(volumeImageData->GetScalarSize() * first.nComponents);
+
+	unsigned char *volumeDataPtr =
+		static_cast<unsigned char*>(volumeImageData->GetScalarPointer());
+
+	// Pass 2 - decode every slice directly into its place in the volume
+	std::atomic<bool> decodeFailed(false);
+	std::atomic<size_t> nDecoded(0);
+	ParallelFor(headers.size(), [&](const size_t iSlice)
+	{
+		if (decodeFailed ||
+			IsCancelled(progress))
+		{
+			return;
+		}
+
+		const size_t iOutSlice = reverseSlices
+			? headers.size() - 1 - iSlice
+			: iSlice;
+
+		if (!DecodeSlice(
+			headers[iSlice].fileName,
+			volumeDataPtr + (iOutSlice * sliceBytes),
+			sliceBytes))
+		{
+			decodeFailed = true;
+		}
+
+		if (nullptr != progress)
+		{
+			progress->Report(sHeaderProgressFraction +
+				((1.0 - sHeaderProgressFraction) * ++nDecoded) / headers.size());
+		}
+	});
+
+	if (decodeFailed ||
+		IsCancelled(progress))
+	{
+		return nullptr;
+	}
+
+	return volumeImageData;
+}
+
+
+vtkSmartPointer<vtkImageData> ParallelDicomReader::ReadPreview(
+	const std::string &folder,
+	const int stride,
+	const bool reverseSlices,
+	vtkSmartPointer<vtkImageData> &fullGeometry)
+{
+	std::vector<DicomSliceHeader> headers;
+	if (!ReadSeriesHeaders(folder, nullptr, headers))
+	{
+		return nullptr;
+	}
+
+	const DicomSliceHeader &first = headers.front();
+	fullGeometry = NewSeriesGeometry(headers);
+
+	const std::array<int, 3> previewDimensions =
+		VolumePreview::PreviewDimensions(fullGeometry->GetDimensions(), stride);
+
+	auto previewImageData = vtkSmartPointer<vtkImageData>::New();
+	previewImageData->SetDimensions(previewDimensions.data());
+	previewImageData->AllocateScalars(DicomScalarType(first), first.nComponents);
+
+	const size_t voxelBytes =
+		static_cast<size_t>(previewImageData->GetScalarSize() * first.nComponents);
+	const size_t sliceBytes =
+		static_cast<size_t>(first.dimensions[0]) *
+		static_cast<size_t>(first.dimensions[1]) *
+		voxelBytes;
+	const size_t previewSliceBytes =
+		static_cast<size_t>(previewDimensions[0]) *
+		static_cast<size_t>(previewDimensions[1]) *
+		voxelBytes;
+	const size_t nPreviewSlices = static_cast<size_t>(previewDimensions[2]);
+
+	unsigned char *previewDataPtr =
+		static_cast<unsigned char*>(previewImageData->GetScalarPointer());
+
+	// only every stride'th slice is decoded, each into a scratch slice first
+	std::atomic<bool> decodeFailed(false);
+	ParallelFor(nPreviewSlices, [&](const size_t iPreviewSlice)
+	{
+		std::vector<unsigned char> slice(sliceBytes);
+
+		if (decodeFailed ||
+			!DecodeSlice(headers[iPreviewSlice * stride].fileName, slice.data(), sliceBytes))
+		{
+			decodeFailed = true;
+			return;
+		}
+
+		const size_t iOutSlice = reverseSlices
+			? nPreviewSlices - 1 - iPreviewSlice
+			: iPreviewSlice;
+
+		VolumePreview::SubsampleSlice(
+			slice.data(),
+			first.dimensions.data(),
+			voxelBytes,
+			stride,
+			previewDataPtr + (iOutSlice * previewSliceBytes));
+	});
+
+	if (decodeFailed)
+	{
+		return nullptr;
+	}
+
+	return previewImageData;
+}
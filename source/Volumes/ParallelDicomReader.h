@@ -0,0 +1,41 @@
+#pragma once
+
+#include "LoadProgress.h"
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+#include <string>
+
+
+class ParallelDicomReader
+{
+public:
+	/*
+	 * Reads the DICOM series in the folder into a single volume. Slice headers
+	 * are parsed and pixel data decoded on all cores, each slice being written
+	 * straight into its place in one preallocated vtkImageData. The output
+	 * matches vtkDICOMImageReader: same slice order, scalar type, rescaling,
+	 * spacing and origin. With reverseSlices the slices are stored last to
+	 * first instead, saving a flip of the whole volume afterwards.
+	 * Returns nullptr if the folder holds no readable series or the slices
+	 * disagree in size or pixel format.
+	 * When given a progress, reports the fraction of slices done and stops
+	 * early, returning nullptr, once it has been cancelled.
+	 */
+	static vtkSmartPointer<vtkImageData> Read(
+		const std::string &folder,
+		const bool reverseSlices,
+		LoadProgress *progress = nullptr);
+
+	/*
+	 * Decodes only every stride'th slice, taking every stride'th pixel of
+	 * each, for a quick preview of the series. fullGeometry is set to the
+	 * dimensions, spacing and origin Read would give, without any scalars.
+	 */
+	static vtkSmartPointer<vtkImageData> ReadPreview(
+		const std::string &folder,
+		const int stride,
+		const bool reverseSlices,
+		vtkSmartPointer<vtkImageData> &fullGeometry);
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+
+/*
+ * Number of worker threads used by the parallel volume kernels, never less
+ * than one even when the hardware concurrency cannot be determined.
+ */
+inline unsigned int ParallelThreadCount()
+{
+	return std::max(1u, std::thread::hardware_concurrency());
+}
+
+
+/*
+ * Calls functor(i) for every i in [0, count) spread over all cores. Items are
+ * handed out one at a time from a shared counter, so uneven work such as file
+ * I/O balances itself. The calling thread takes part in the work.
+ */
+template<typename Functor> void ParallelFor(
+	const size_t count,
+	Functor functor)
+{
+	const size_t nThreads = std::min<size_t>(ParallelThreadCount(), count);
+
+	if (nThreads <= 1)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			functor(i);
+		}
+		return;
+	}
+
+	std::atomic<size_t> next(0);
+	auto worker = [&]()
+	{
+		for (size_t i = next++; i < count; i = next++)
+		{
+			functor(i);
+		}
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(nThreads - 1);
+
+	for (size_t t = 1; t < nThreads; ++t)
+	{
+		threads.emplace_back(worker);
+	}
+
+	worker();
+
+	for (auto &thread : threads)
+	{
+		thread.join();
+	}
+}
@@ -0,0 +1,794 @@
+#include "RawVolumeHeader.h"
+
+#include "../VtkToUnityAPIDefines.h"
+
+#include <vtkType.h>
+#include <vtk_zlib.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+
+static size_t ScalarTypeSize(
+	const int scalarType)
+{
+	switch (scalarType)
+	{
+	case VTK_CHAR:
+	case VTK_SIGNED_CHAR:
+	case VTK_UNSIGNED_CHAR:
+		return 1;
+	case VTK_SHORT:
+	case VTK_UNSIGNED_SHORT:
+		return 2;
+	case VTK_INT:
+	case VTK_UNSIGNED_INT:
+	case VTK_FLOAT:
+		return 4;
+	case VTK_DOUBLE:
+		return 8;
+	default:
+		return 0;
+	}
+}
+
+
+size_t RawVolumeLayout::GetDataBytes() const
+{
+	return static_cast<size_t>(dimensions[0]) *
+		static_cast<size_t>(dimensions[1]) *
+		static_cast<size_t>(dimensions[2]) *
+		static_cast<size_t>(nComponents) *
+		ScalarTypeSize(scalarType);
+}
+
+
+static std::string Trim(
+	const std::string &text)
+{
+	const char *whitespace = " \t\r\n";
+	const size_t first = text.find_first_not_of(whitespace);
+
+	if (std::string::npos == first)
+	{
+		return std::string();
+	}
+
+	return text.substr(first, text.find_last_not_of(whitespace) - first + 1);
+}
+
+
+// Splits "key<separator>value" into its trimmed parts
+static bool SplitField(
+	const std::string &line,
+	const std::string &separator,
+	std::string &key,
+	std::string &value)
+{
+	const size_t separatorPos = line.find(separator);
+	if (std::string::npos == separatorPos)
+	{
+		return false;
+	}
+
+	key = Trim(line.substr(0, separatorPos));
+	value = Trim(line.substr(separatorPos + separator.size()));
+	return true;
+}
+
+
+template<typename T, size_t N> static bool ParseValues(
+	const std::string &text,
+	std::array<T, N> &values)
+{
+	std::istringstream textStream(text);
+
+	for (auto &value : values)
+	{
+		if (!(textStream >> value))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+// Data file names are relative to the folder holding the header
+static std::string ResolveDataFile(
+	const std::string &headerPath,
+	const std::string &dataFile)
+{
+	const bool isAbsolute =
+		(!dataFile.empty() && ('/' == dataFile[0] || '\\' == dataFile[0])) ||
+		(dataFile.size() > 1 && ':' == dataFile[1]);
+
+	const size_t folderEnd = headerPath.find_last_of("/\\");
+
+	if (isAbsolute ||
+		std::string::npos == folderEnd)
+	{
+		return dataFile;
+	}
+
+	return headerPath.substr(0, folderEnd + 1) + dataFile;
+}
+
+
+static int MetaElementScalarType(
+	const std::string &elementType)
+{
+	if ("MET_UCHAR" == elementType) return VTK_UNSIGNED_CHAR;
+	if ("MET_CHAR" == elementType) return VTK_CHAR;
+	if ("MET_USHORT" == elementType) return VTK_UNSIGNED_SHORT;
+	if ("MET_SHORT" == elementType) return VTK_SHORT;
+	if ("MET_UINT" == elementType) return VTK_UNSIGNED_INT;
+	if ("MET_INT" == elementType) return VTK_INT;
+	if ("MET_FLOAT" == elementType) return VTK_FLOAT;
+	if ("MET_DOUBLE" == elementType) return VTK_DOUBLE;
+
+	return VTK_VOID;
+}
+
+
+static int NrrdScalarType(
+	const std::string &type)
+{
+	if ("uchar" == type || "unsigned char" == type || "uint8" == type || "uint8_t" == type)
+	{
+		return VTK_UNSIGNED_CHAR;
+	}
+
+	if ("signed char" == type || "int8" == type || "int8_t" == type)
+	{
+		return VTK_SIGNED_CHAR;
+	}
+
+	if ("ushort" == type || "unsigned short" == type || "unsigned short int" == type ||
+		"uint16" == type || "uint16_t" == type)
+	{
+		return VTK_UNSIGNED_SHORT;
+	}
+
+	if ("short" == type || "short int" == type || "signed short" == type ||
+		"signed short int" == type || "int16" == type || "int16_t" == type)
+	{
+		return VTK_SHORT;
+	}
+
+	if ("uint" == type || "unsigned int" == type || "uint32" == type || "uint32_t" == type)
+	{
+		return VTK_UNSIGNED_INT;
+	}
+
+	if ("int" == type || "signed int" == type || "int32" == type || "int32_t" == type)
+	{
+		return VTK_INT;
+	}
+
+	if ("float" == type)
+	{
+		return VTK_FLOAT;
+	}
+
+	if ("double" == type)
+	{
+		return VTK_DOUBLE;
+	}
+
+	return VTK_VOID;
+}
+
+
+bool RawVolumeHeader::Read(
+	const int format,
+	const std::string &path,
+	RawVolumeLayout &layout)
+{
+	switch (format)
+	{
+	case VolumeFileMhd:
+		return ReadMhd(path, layout);
+	case VolumeFileNrrd:
+		return ReadNrrd(path, layout);
+	case VolumeFileNifti:
+		return ReadNifti(path, layout);
+	default:
+		return false;
+	}
+}
+
+
+bool RawVolumeHeader::ReadMhd(
+	const std::string &mhdPath,
+	RawVolumeLayout &layout)
+{
+	std::ifstream mhdFile(mhdPath, std::ios::binary);
+	if (!mhdFile)
+	{
+		return false;
+	}
+
+	bool haveSpacing(false);
+	std::string line;
+	std::string key;
+	std::string value;
+
+	while (std::getline(mhdFile, line))
+	{
+		if (!SplitField(line, "=", key, value))
+		{
+			continue;
+		}
+
+		if ("NDims" == key)
+		{
+			if ("3" != value)
+			{
+				return false;
+			}
+		}
+		else if ("DimSize" == key)
+		{
+			if (!ParseValues(value, layout.dimensions))
+			{
+				return false;
+			}
+		}
+		else if ("ElementSpacing" == key)
+		{
+			haveSpacing = ParseValues(value, layout.spacing);
+		}
+		else if ("ElementSize" == key && !haveSpacing)
+		{
+			ParseValues(value, layout.spacing);
+		}
+		else if ("Offset" == key || "Origin" == key || "Position" == key)
+		{
+			ParseValues(value, layout.origin);
+		}
+		else if ("ElementType" == key)
+		{
+			layout.scalarType = MetaElementScalarType(value);
+		}
+		else if ("ElementNumberOfChannels" == key)
+		{
+			layout.nComponents = atoi(value.c_str());
+		}
+		else if ("CompressedData" == key)
+		{
+			layout.compressed = ("True" == value || "true" == value);
+		}
+		else if ("CompressedDataSize" == key)
+		{
+			layout.compressedBytes = atoll(value.c_str());
+		}
+		else if ("BinaryDataByteOrderMSB" == key ||
+			"ElementByteOrderMSB" == key)
+		{
+			if ("True" == value || "true" == value)
+			{
+				return false;
+			}
+		}
+		else if ("HeaderSize" == key)
+		{
+			layout.dataOffset = atoll(value.c_str());
+		}
+		else if ("ElementDataFile" == key)
+		{
+			// always the last field, the data may follow straight on
+			if ("LOCAL" == value || "Local" == value)
+			{
+				layout.dataFile = mhdPath;
+				layout.dataOffset = static_cast<long long>(mhdFile.tellg());
+			}
+			else if ("LIST" == value ||
+				std::string::npos != value.find('%') ||
+				std::string::npos != value.find(' '))
+			{
+				// one file per slice
+				return false;
+			}
+			else
+			{
+				layout.dataFile = ResolveDataFile(mhdPath, value);
+			}
+
+			break;
+		}
+	}
+
+	return !layout.dataFile.empty() &&
+		layout.nComponents > 0 &&
+		0 != ScalarTypeSize(layout.scalarType) &&
+		layout.dimensions[0] > 0 &&
+		layout.dimensions[1] > 0 &&
+		layout.dimensions[2] > 0;
+}
+
+
+bool RawVolumeHeader::ReadNrrd(
+	const std::string &nrrdPath,
+	RawVolumeLayout &layout)
+{
+	std::ifstream nrrdFile(nrrdPath, std::ios::binary);
+	std::string line;
+
+	if (!std::getline(nrrdFile, line) ||
+		0 != line.compare(0, 4, "NRRD"))
+	{
+		return false;
+	}
+
+	std::string key;
+	std::string value;
+	int dimension(0);
+	bool knownEncoding(false);
+	bool bigEndian(false);
+	long long byteSkip(0);
+
+	while (std::getline(nrrdFile, line))
+	{
+		line = Trim(line);
+
+		// an empty line ends the header, attached data follows it
+		if (line.empty())
+		{
+			break;
+		}
+
+		if ('#' == line[0] ||
+			std::string::npos != line.find(":="))
+		{
+			continue;
+		}
+
+		if (!SplitField(line, ":", key, value))
+		{
+			continue;
+		}
+
+		if ("type" == key)
+		{
+			layout.scalarType = NrrdScalarType(value);
+		}
+		else if ("dimension" == key)
+		{
+			dimension = atoi(value.c_str());
+		}
+		else if ("sizes" == key)
+		{
+			ParseValues(value, layout.dimensions);
+		}
+		else if ("spacings" == key)
+		{
+			ParseValues(value, layout.spacing);
+		}
+		else if ("space directions" == key)
+		{
+			// one vector per axis, the spacing is its length
+			for (auto &c : value)
+			{
+				if ('(' == c || ')' == c || ',' == c)
+				{
+					c = ' ';
+				}
+			}
+
+			std::array<double, 9> directions;
+			if (ParseValues(value, directions))
+			{
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					layout.spacing[axis] = std::sqrt(
+						(directions[3 * axis] * directions[3 * axis]) +
+						(directions[(3 * axis) + 1] * directions[(3 * axis) + 1]) +
+						(directions[(3 * axis) + 2] * directions[(3 * axis) + 2]));
+				}
+			}
+		}
+		else if ("space origin" == key)
+		{
+			for (auto &c : value)
+			{
+				if ('(' == c || ')' == c || ',' == c)
+				{
+					c = ' ';
+				}
+			}
+
+			ParseValues(value, layout.origin);
+		}
+		else if ("encoding" == key)
+		{
+			knownEncoding = ("raw" == value || "gzip" == value || "gz" == value);
+			layout.compressed = ("gzip" == value || "gz" == value);
+		}
+		else if ("endian" == key)
+		{
+			bigEndian = ("big" == value);
+		}
+		else if ("byte skip" == key || "byteskip" == key)
+		{
+			byteSkip = atoll(value.c_str());
+			layout.dataOffset = byteSkip;
+		}
+		else if ("line skip" == key || "lineskip" == key)
+		{
+			if (0 != atoi(value.c_str()))
+			{
+				return false;
+			}
+		}
+		else if ("data file" == key || "datafile" == key)
+		{
+			if (0 == value.compare(0, 4, "LIST") ||
+				std::string::npos != value.find('%') ||
+				std::string::npos != value.find(' '))
+			{
+				return false;
+			}
+
+			layout.dataFile = ResolveDataFile(nrrdPath, value);
+		}
+	}
+
+	if (layout.dataFile.empty())
+	{
+		// attached data starts after the header and any byte skip
+		const long long headerEnd = static_cast<long long>(nrrdFile.tellg());
+		if (headerEnd < 0)
+		{
+			return false;
+		}
+
+		layout.dataFile = nrrdPath;
+
+		if (layout.dataOffset >= 0)
+		{
+			layout.dataOffset += headerEnd;
+		}
+	}
+
+	// a byte skip of compressed data applies after it is inflated
+	if (layout.compressed)
+	{
+		layout.dataOffset -= byteSkip;
+		layout.inflatedOffset = byteSkip;
+	}
+
+	return 3 == dimension &&
+		knownEncoding &&
+		!(layout.compressed && byteSkip < 0) &&
+		!(bigEndian && ScalarTypeSize(layout.scalarType) > 1) &&
+		0 != ScalarTypeSize(layout.scalarType) &&
+		layout.dimensions[0] > 0 &&
+		layout.dimensions[1] > 0 &&
+		layout.dimensions[2] > 0;
+}
+
+
+// an off-axis component of a voxel axis, relative to its on-axis one, taken as rounding
+static const double sNiftiAxisTolerance(1.0e-3);
+
+// NIfTI-1 header fields, at their offsets in the 348 byte header
+static const size_t sNiftiHeaderBytes(348);
+static const size_t sNiftiDimOffset(40);
+static const size_t sNiftiDatatypeOffset(70);
+static const size_t sNiftiPixdimOffset(76);
+static const size_t sNiftiVoxOffsetOffset(108);
+static const size_t sNiftiSclSlopeOffset(112);
+static const size_t sNiftiSclInterOffset(116);
+static const size_t sNiftiXyztUnitsOffset(123);
+static const size_t sNiftiQformCodeOffset(252);
+static const size_t sNiftiSformCodeOffset(254);
+static const size_t sNiftiQuaternOffset(256);
+static const size_t sNiftiQoffsetOffset(268);
+static const size_t sNiftiSrowOffset(280);
+static const size_t sNiftiMagicOffset(344);
+
+
+template<typename T> static T NiftiField(
+	const unsigned char *header,
+	const size_t offset)
+{
+	T value;
+	memcpy(&value, header + offset, sizeof(T));
+	return value;
+}
+
+
+static bool IsGzipFile(
+	const std::string &path)
+{
+	std::ifstream file(path, std::ios::binary);
+	unsigned char magic[2] = { 0, 0 };
+	file.read(reinterpret_cast<char*>(magic), sizeof(magic));
+
+	return file && 0x1f == magic[0] && 0x8b == magic[1];
+}
+
+
+// The first nBytes of a file, inflated if it is gzipped
+static bool ReadFilePrefix(
+	const std::string &path,
+	const bool compressed,
+	unsigned char *prefix,
+	const size_t nBytes)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+
+	if (!compressed)
+	{
+		file.read(reinterpret_cast<char*>(prefix), static_cast<std::streamsize>(nBytes));
+		return static_cast<bool>(file);
+	}
+
+	z_stream stream = {};
+	if (Z_OK != inflateInit2(&stream, 15 + 32))
+	{
+		return false;
+	}
+
+	std::vector<unsigned char> inBuffer(4096);
+	stream.next_out = prefix;
+	stream.avail_out = static_cast<uInt>(nBytes);
+	int result(Z_OK);
+
+	while (stream.avail_out > 0 && Z_OK == result)
+	{
+		if (0 == stream.avail_in)
+		{
+			file.read(reinterpret_cast<char*>(inBuffer.data()), static_cast<std::streamsize>(inBuffer.size()));
+			stream.next_in = inBuffer.data();
+			stream.avail_in = static_cast<uInt>(file.gcount());
+
+			if (0 == stream.avail_in)
+			{
+				break;
+			}
+		}
+
+		result = inflate(&stream, Z_NO_FLUSH);
+	}
+
+	inflateEnd(&stream);
+
+	return 0 == stream.avail_out;
+}
+
+
+static int NiftiScalarType(
+	const int16_t datatype,
+	int &nComponents)
+{
+	nComponents = 1;
+
+	switch (datatype)
+	{
+	case 2: return VTK_UNSIGNED_CHAR;
+	case 4: return VTK_SHORT;
+	case 8: return VTK_INT;
+	case 16: return VTK_FLOAT;
+	case 64: return VTK_DOUBLE;
+	case 256: return VTK_SIGNED_CHAR;
+	case 512: return VTK_UNSIGNED_SHORT;
+	case 768: return VTK_UNSIGNED_INT;
+	case 128: nComponents = 3; return VTK_UNSIGNED_CHAR;
+	case 2304: nComponents = 4; return VTK_UNSIGNED_CHAR;
+	default: return VTK_VOID;
+	}
+}
+
+
+double RawVolumeHeader::NiftiUnitsToMm(
+	const int xyztUnits)
+{
+	switch (xyztUnits & 0x07)
+	{
+	case 1: return 1000.0;
+	case 3: return 0.001;
+	default: return 1.0;
+	}
+}
+
+
+bool RawVolumeHeader::ReadNifti(
+	const std::string &niftiPath,
+	RawVolumeLayout &layout)
+{
+	const bool headerCompressed = IsGzipFile(niftiPath);
+	unsigned char header[sNiftiHeaderBytes];
+
+	// a big endian header reads as the wrong size, and is left to the VTK reader
+	if (!ReadFilePrefix(niftiPath, headerCompressed, header, sNiftiHeaderBytes) ||
+		static_cast<int32_t>(sNiftiHeaderBytes) != NiftiField<int32_t>(header, 0))
+	{
+		return false;
+	}
+
+	const char *magic = reinterpret_cast<const char*>(header + sNiftiMagicOffset);
+	const bool singleFile = (0 == memcmp(magic, "n+1", 4));
+
+	if (!singleFile &&
+		0 != memcmp(magic, "ni1", 4))
+	{
+		return false;
+	}
+
+	// dimensions past the third must all be 1, a 4D file is a series
+	const int16_t nDims = NiftiField<int16_t>(header, sNiftiDimOffset);
+	if (nDims < 3 || nDims > 7)
+	{
+		return false;
+	}
+
+	for (int axis = 0; axis < nDims; ++axis)
+	{
+		const int16_t dim = NiftiField<int16_t>(header, sNiftiDimOffset + (2 * (axis + 1)));
+
+		if (axis < 3)
+		{
+			layout.dimensions[axis] = dim;
+		}
+		else if (1 != dim)
+		{
+			return false;
+		}
+	}
+
+	layout.scalarType = NiftiScalarType(
+		NiftiField<int16_t>(header, sNiftiDatatypeOffset), layout.nComponents);
+
+	const double unitsToMm = NiftiUnitsToMm(header[sNiftiXyztUnitsOffset]);
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		const float pixdim = NiftiField<float>(header, sNiftiPixdimOffset + (4 * (axis + 1)));
+		layout.spacing[axis] = (0.0f != pixdim) ? std::fabs(pixdim) * unitsToMm : 1.0;
+	}
+
+	// the sform is the more general, the qform the scanner's
+	std::array<float, 3> rasOrigin{ { 0.0f, 0.0f, 0.0f } };
+	double rasAxes[3][3] = { { 1.0, 0.0, 0.0 }, { 0.0, 1.0, 0.0 }, { 0.0, 0.0, 1.0 } };
+
+	if (NiftiField<int16_t>(header, sNiftiSformCodeOffset) > 0)
+	{
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			rasOrigin[axis] = NiftiField<float>(header, sNiftiSrowOffset + (16 * axis) + 12);
+
+			for (int column = 0; column < 3; ++column)
+			{
+				rasAxes[axis][column] = NiftiField<float>(header, sNiftiSrowOffset + (16 * axis) + (4 * column));
+			}
+		}
+	}
+	else if (NiftiField<int16_t>(header, sNiftiQformCodeOffset) > 0)
+	{
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			rasOrigin[axis] = NiftiField<float>(header, sNiftiQoffsetOffset + (4 * axis));
+		}
+
+		// the rotation of the unit quaternion (a, b, c, d), with z negated for a qfac of -1
+		const double b = NiftiField<float>(header, sNiftiQuaternOffset);
+		const double c = NiftiField<float>(header, sNiftiQuaternOffset + 4);
+		const double d = NiftiField<float>(header, sNiftiQuaternOffset + 8);
+		const double a = std::sqrt(std::max(0.0, 1.0 - ((b * b) + (c * c) + (d * d))));
+		const double qfac = (NiftiField<float>(header, sNiftiPixdimOffset) < 0.0f) ? -1.0 : 1.0;
+
+		const double rotation[3][3] = {
+			{ (a * a) + (b * b) - (c * c) - (d * d), 2.0 * ((b * c) - (a * d)), 2.0 * ((b * d) + (a * c)) },
+			{ 2.0 * ((b * c) + (a * d)), (a * a) + (c * c) - (b * b) - (d * d), 2.0 * ((c * d) - (a * b)) },
+			{ 2.0 * ((b * d) - (a * c)), 2.0 * ((c * d) + (a * b)), (a * a) + (d * d) - (b * b) - (c * c) } };
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			for (int column = 0; column < 3; ++column)
+			{
+				rasAxes[axis][column] = rotation[axis][column] * ((2 == column) ? qfac : 1.0);
+			}
+		}
+	}
+
+	// voxel axes reversed or rotated against LPS would need the voxels moving, left to the VTK reader
+	std::array<bool, 3> flipAxes;
+	if (!NiftiAxesToLps(rasAxes, flipAxes) ||
+		flipAxes[0] || flipAxes[1] || flipAxes[2])
+	{
+		return false;
+	}
+
+	layout.origin[0] = -rasOrigin[0] * unitsToMm;
+	layout.origin[1] = -rasOrigin[1] * unitsToMm;
+	layout.origin[2] = rasOrigin[2] * unitsToMm;
+
+	// a zero slope means the values are not scaled
+	const float sclSlope = NiftiField<float>(header, sNiftiSclSlopeOffset);
+	if (0.0f != sclSlope &&
+		std::isfinite(sclSlope))
+	{
+		layout.rescaleSlope = sclSlope;
+		layout.rescaleIntercept = NiftiField<float>(header, sNiftiSclInterOffset);
+	}
+
+	const long long voxOffset = static_cast<long long>(NiftiField<float>(header, sNiftiVoxOffsetOffset));
+
+	if (singleFile)
+	{
+		layout.dataFile = niftiPath;
+	}
+	else
+	{
+		// the .img of a .hdr, keeping any .gz
+		const size_t extensionPos = niftiPath.rfind(".hdr");
+		if (std::string::npos == extensionPos)
+		{
+			return false;
+		}
+
+		layout.dataFile = niftiPath;
+		layout.dataFile.replace(extensionPos, 4, ".img");
+	}
+
+	layout.compressed = IsGzipFile(layout.dataFile);
+
+	if (layout.compressed)
+	{
+		layout.dataOffset = 0;
+		layout.inflatedOffset = voxOffset;
+	}
+	else
+	{
+		layout.dataOffset = voxOffset;
+	}
+
+	return voxOffset >= 0 &&
+		0 != ScalarTypeSize(layout.scalarType) &&
+		layout.dimensions[0] > 0 &&
+		layout.dimensions[1] > 0 &&
+		layout.dimensions[2] > 0;
+}
+
+
+bool RawVolumeHeader::NiftiAxesToLps(
+	const double rasAxes[3][3],
+	std::array<bool, 3> &flipAxes)
+{
+	bool alongAxes(true);
+
+	for (int column = 0; column < 3; ++column)
+	{
+		// RAS to LPS negates x and y
+		double lpsAxis[3];
+		lpsAxis[0] = -rasAxes[0][column];
+		lpsAxis[1] = -rasAxes[1][column];
+		lpsAxis[2] = rasAxes[2][column];
+
+		flipAxes[column] = (lpsAxis[column] < 0.0);
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			if (axis != column &&
+				std::fabs(lpsAxis[axis]) > sNiftiAxisTolerance * std::fabs(lpsAxis[column]))
+			{
+				alongAxes = false;
+			}
+		}
+	}
+
+	return alongAxes;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <string>
+
+
+/*
+ * Where and how the voxels of a volume are laid out on disk, as read from a
+ * MetaImage, NRRD or NIfTI header.
+ */
+struct RawVolumeLayout
+{
+	RawVolumeLayout()
+		: dataOffset(0)
+		, compressed(false)
+		, compressedBytes(-1)
+		, inflatedOffset(0)
+		, scalarType(0)
+		, nComponents(1)
+		, rescaleSlope(1.0)
+		, rescaleIntercept(0.0)
+		, dimensions{ { 0, 0, 0 } }
+		, spacing{ { 1.0, 1.0, 1.0 } }
+		, origin{ { 0.0, 0.0, 0.0 } }
+	{}
+
+	std::string dataFile;
+	// negative if the data is at the end of the file, as for a MetaImage HeaderSize of -1
+	long long dataOffset;
+	// a zlib or gzip stream, of compressedBytes if the header gives its size
+	bool compressed;
+	long long compressedBytes;
+	// bytes of the inflated stream before the voxels, as for the header of a .nii.gz
+	long long inflatedOffset;
+	int scalarType;
+	int nComponents;
+	// a stored scalar s stands for (s * rescaleSlope) + rescaleIntercept, as for NIfTI scl_slope
+	double rescaleSlope;
+	double rescaleIntercept;
+	std::array<int, 3> dimensions;
+	std::array<double, 3> spacing;
+	std::array<double, 3> origin;
+
+	size_t GetDataBytes() const;
+};
+
+
+/*
+ * Minimal MetaImage (.mhd), NRRD and NIfTI-1 header readers, handling only
+ * what can be read without the VTK readers: a single 3D block of little
+ * endian voxels, uncompressed or as one zlib or gzip stream, in the header
+ * file itself or a separate data file. Anything else returns false, leaving
+ * the file to the VTK readers. Geometry is read the way vtkMetaImageReader
+ * and vtkNrrdReader read it, see ReadNifti for NIfTI.
+ */
+class RawVolumeHeader
+{
+public:
+	/*
+	 * Reads the header of a VolumeFileMhd, VolumeFileNrrd or VolumeFileNifti file.
+	 */
+	static bool Read(
+		const int format,
+		const std::string &path,
+		RawVolumeLayout &layout);
+
+	static bool ReadMhd(
+		const std::string &mhdPath,
+		RawVolumeLayout &layout);
+
+	static bool ReadNrrd(
+		const std::string &nrrdPath,
+		RawVolumeLayout &layout);
+
+	/*
+	 * Reads a .nii, .nii.gz or .hdr/.img pair. Spacing is converted to mm,
+	 * and the origin, from the sform or else the qform, from NIfTI's RAS to
+	 * the LPS of the other formats, so the volumes can be mixed. Only files
+	 * whose voxel axes already run along LPS x, y and z are read, the rest
+	 * need their voxels flipping and are left to the VTK reader.
+	 */
+	static bool ReadNifti(
+		const std::string &niftiPath,
+		RawVolumeLayout &layout);
+
+	/*
+	 * The scale from the spatial units in a NIfTI xyzt_units to mm, unknown
+	 * units are taken as mm.
+	 */
+	static double NiftiUnitsToMm(
+		const int xyztUnits);
+
+	/*
+	 * Takes the RAS direction of each voxel axis, the columns of rasAxes, and
+	 * sets which axes run against LPS and need flipping. Returns false if
+	 * the axes are rotated off the LPS axes, flipAxes is still set then, by
+	 * the sign of each axis' own component.
+	 */
+	static bool NiftiAxesToLps(
+		const double rasAxes[3][3],
+		std::array<bool, 3> &flipAxes);
+};
@@ -0,0 +1,114 @@
+#include "ResidentMemorySampler.h"
+
+#include <chrono>
+
+#if UNITY_WIN
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#elif UNITY_OSX
+#include <mach/mach.h>
+#else
+#include <cstdio>
+#include <unistd.h>
+#endif
+
+
+static const std::chrono::milliseconds sSampleInterval(1);
+
+
+ResidentMemorySampler::ResidentMemorySampler()
+	: mSampling(false)
+	, mPeakBytes(0)
+{}
+
+
+ResidentMemorySampler::~ResidentMemorySampler()
+{
+	Stop();
+}
+
+
+unsigned long long ResidentMemorySampler::GetResidentBytes()
+{
+#if UNITY_WIN
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		return 0;
+	}
+
+	return static_cast<unsigned long long>(counters.WorkingSetSize);
+#elif UNITY_OSX
+	mach_task_basic_info_data_t info;
+	mach_msg_type_number_t infoCount = MACH_TASK_BASIC_INFO_COUNT;
+	if (KERN_SUCCESS != task_info(mach_task_self(), MACH_TASK_BASIC_INFO,
+		reinterpret_cast<task_info_t>(&info), &infoCount))
+	{
+		return 0;
+	}
+
+	return static_cast<unsigned long long>(info.resident_size);
+#else
+	// the second field of statm is the resident pages
+	FILE *statmFile = fopen("/proc/self/statm", "r");
+	if (nullptr == statmFile)
+	{
+		return 0;
+	}
+
+	unsigned long long totalPages(0);
+	unsigned long long residentPages(0);
+	const bool read = (2 == fscanf(statmFile, "%llu %llu", &totalPages, &residentPages));
+	fclose(statmFile);
+
+	return read
+		? residentPages * static_cast<unsigned long long>(sysconf(_SC_PAGESIZE))
+		: 0;
+#endif
+}
+
+
+void ResidentMemorySampler::Start()
+{
+	Stop();
+
+	mPeakBytes = GetResidentBytes();
+	mSampling = true;
+
+	mThread = std::thread([this]()
+	{
+		while (mSampling)
+		{
+			const unsigned long long residentBytes = GetResidentBytes();
+			if (residentBytes > mPeakBytes)
+			{
+				mPeakBytes = residentBytes;
+			}
+
+			std::this_thread::sleep_for(sSampleInterval);
+		}
+	});
+}
+
+
+unsigned long long ResidentMemorySampler::Stop()
+{
+	mSampling = false;
+
+	if (mThread.joinable())
+	{
+		mThread.join();
+
+		// the end of the load, in case it peaked after the last sample
+		const unsigned long long residentBytes = GetResidentBytes();
+		if (residentBytes > mPeakBytes)
+		{
+			mPeakBytes = residentBytes;
+		}
+	}
+
+	return mPeakBytes;
+}
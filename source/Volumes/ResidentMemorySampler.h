@@ -0,0 +1,41 @@
+#pragma once
+
+#include "../PlatformBase.h"
+
+#include <atomic>
+#include <thread>
+
+
+/*
+ * Finds the peak resident memory of the process while a load runs, for the
+ * memory benchmarks. The OS only keeps a peak over the whole life of the
+ * process, so the resident size is sampled on a thread every millisecond
+ * from Start to Stop instead. A volume's voxels are filled as they are read,
+ * well over a millisecond per gigabyte, so no copy can slip between samples.
+ */
+class ResidentMemorySampler
+{
+public:
+	ResidentMemorySampler();
+	~ResidentMemorySampler();
+
+	/*
+	 * Bytes resident now, 0 where the OS cannot say.
+	 */
+	static unsigned long long GetResidentBytes();
+
+	void Start();
+
+	/*
+	 * Returns the most bytes resident at any sample since Start.
+	 */
+	unsigned long long Stop();
+
+private:
+	ResidentMemorySampler(const ResidentMemorySampler&) = delete;
+	ResidentMemorySampler& operator=(const ResidentMemorySampler&) = delete;
+
+	std::thread mThread;
+	std::atomic<bool> mSampling;
+	std::atomic<unsigned long long> mPeakBytes;
+};
@@ -0,0 +1,217 @@
+#include "ScalarNarrowing.h"
+
+#include "ParallelFor.h"
+
+#include <vtkDataArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkFieldData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+#include <vtkType.h>
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+
+static const char *sScalarRangeName("ScalarNarrowingRange");
+
+
+template<typename InType> static void ScalarRange(
+	const InType *volumeDataPtr,
+	const size_t sliceValues,
+	const size_t nSlices,
+	double &minValue,
+	double &maxValue)
+{
+	std::vector<InType> sliceMin(nSlices);
+	std::vector<InType> sliceMax(nSlices);
+
+	ParallelFor(nSlices, [&](const size_t z)
+	{
+		const InType *slice = volumeDataPtr + (z * sliceValues);
+		InType lo = slice[0];
+		InType hi = slice[0];
+
+		// branch free, so the compiler vectorises it
+		for (size_t i = 1; i < sliceValues; ++i)
+		{
+			lo = std::min(lo, slice[i]);
+			hi = std::max(hi, slice[i]);
+		}
+
+		sliceMin[z] = lo;
+		sliceMax[z] = hi;
+	});
+
+	minValue = static_cast<double>(*std::min_element(sliceMin.begin(), sliceMin.end()));
+	maxValue = static_cast<double>(*std::max_element(sliceMax.begin(), sliceMax.end()));
+}
+
+
+template<typename InType, typename OutType> static void Requantise(
+	const InType *volumeDataPtr,
+	OutType *narrowDataPtr,
+	const size_t sliceValues,
+	const size_t nSlices,
+	const bool reverseSlices,
+	const double slope,
+	const double intercept)
+{
+	// the same float arithmetic for every voxel, with rounding folded into the offset
+	const float scale = static_cast<float>(1.0 / slope);
+	const float offset = static_cast<float>((-intercept / slope) + 0.5);
+	const float maxStored = static_cast<float>(std::numeric_limits<OutType>::max());
+
+	ParallelFor(nSlices, [&](const size_t z)
+	{
+		const size_t zIn = reverseSlices ? (nSlices - 1 - z) : z;
+		const InType *inSlice = volumeDataPtr + (zIn * sliceValues);
+		OutType *outSlice = narrowDataPtr + (z * sliceValues);
+
+		for (size_t i = 0; i < sliceValues; ++i)
+		{
+			const float stored = (static_cast<float>(inSlice[i]) * scale) + offset;
+			outSlice[i] = static_cast<OutType>(std::min(std::max(stored, 0.0f), maxStored));
+		}
+	});
+}
+
+
+template<typename InType> static void NarrowScalars(
+	const InType *volumeDataPtr,
+	void *narrowDataPtr,
+	const int scalarType,
+	const size_t sliceValues,
+	const size_t nSlices,
+	const bool reverseSlices,
+	const double *knownRange,
+	double &slope,
+	double &intercept)
+{
+	double minValue;
+	double maxValue;
+
+	if (nullptr != knownRange)
+	{
+		minValue = knownRange[0];
+		maxValue = knownRange[1];
+	}
+	else
+	{
+		ScalarRange(volumeDataPtr, sliceValues, nSlices, minValue, maxValue);
+	}
+
+	const double maxStored = (VTK_UNSIGNED_CHAR == scalarType)
+		? static_cast<double>(std::numeric_limits<unsigned char>::max())
+		: static_cast<double>(std::numeric_limits<unsigned short>::max());
+
+	intercept = minValue;
+	slope = 1.0;
+
+	// integers that fit are kept exactly, everything else is spread over the stored range
+	if (!std::is_integral<InType>::value ||
+		(maxValue - minValue) > maxStored)
+	{
+		slope = (maxValue > minValue) ? (maxValue - minValue) / maxStored : 1.0;
+	}
+
+	if (VTK_UNSIGNED_CHAR == scalarType)
+	{
+		Requantise(volumeDataPtr, static_cast<unsigned char*>(narrowDataPtr),
+			sliceValues, nSlices, reverseSlices, slope, intercept);
+	}
+	else
+	{
+		Requantise(volumeDataPtr, static_cast<unsigned short*>(narrowDataPtr),
+			sliceValues, nSlices, reverseSlices, slope, intercept);
+	}
+}
+
+
+bool ScalarNarrowing::Narrow(
+	vtkImageData *volumeImageData,
+	const int scalarType,
+	const bool reverseSlices,
+	double &slope,
+	double &intercept)
+{
+	vtkDataArray *scalars = volumeImageData->GetPointData()->GetScalars();
+
+	if (nullptr == scalars ||
+		1 != scalars->GetNumberOfComponents() ||
+		(VTK_UNSIGNED_CHAR != scalarType && VTK_UNSIGNED_SHORT != scalarType))
+	{
+		return false;
+	}
+
+	vtkSmartPointer<vtkDataArray> narrowScalars =
+		vtkSmartPointer<vtkDataArray>::Take(vtkDataArray::CreateDataArray(scalarType));
+
+	if (scalars->GetDataTypeSize() <= narrowScalars->GetDataTypeSize())
+	{
+		return false;
+	}
+
+	std::array<int, 3> dimensions;
+	volumeImageData->GetDimensions(dimensions.data());
+
+	const size_t sliceValues =
+		static_cast<size_t>(dimensions[0]) *
+		static_cast<size_t>(dimensions[1]);
+	const size_t nSlices = static_cast<size_t>(dimensions[2]);
+
+	if (0 == sliceValues * nSlices)
+	{
+		return false;
+	}
+
+	narrowScalars->SetNumberOfComponents(1);
+	narrowScalars->SetNumberOfTuples(static_cast<vtkIdType>(sliceValues * nSlices));
+	narrowScalars->SetName(scalars->GetName());
+
+	void *volumeDataPtr = scalars->GetVoidPointer(0);
+	void *narrowDataPtr = narrowScalars->GetVoidPointer(0);
+
+	vtkFieldData *fieldData = volumeImageData->GetFieldData();
+	vtkDoubleArray *rangeArray = vtkDoubleArray::SafeDownCast(fieldData->GetArray(sScalarRangeName));
+	const double *knownRange = (nullptr != rangeArray) ? rangeArray->GetPointer(0) : nullptr;
+
+	switch (scalars->GetDataType())
+	{
+		vtkTemplateMacro(NarrowScalars(
+			static_cast<const VTK_TT*>(volumeDataPtr),
+			narrowDataPtr,
+			scalarType,
+			sliceValues,
+			nSlices,
+			reverseSlices,
+			knownRange,
+			slope,
+			intercept));
+	default:
+		return false;
+	}
+
+	// drops the wide scalars, or the file mapping they came from
+	volumeImageData->GetPointData()->SetScalars(narrowScalars);
+	fieldData->RemoveArray(sScalarRangeName);
+	return true;
+}
+
+
+void ScalarNarrowing::AttachScalarRange(
+	vtkImageData *volumeImageData,
+	const double minValue,
+	const double maxValue)
+{
+	vtkNew<vtkDoubleArray> rangeArray;
+	rangeArray->SetName(sScalarRangeName);
+	rangeArray->InsertNextValue(minValue);
+	rangeArray->InsertNextValue(maxValue);
+
+	volumeImageData->GetFieldData()->AddArray(rangeArray.GetPointer());
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vtkImageData.h>
+
+
+/*
+ * Requantises a volume's scalars to unsigned 8 or 16 bit, so it takes a half
+ * or a quarter of the memory on the CPU and in the GPU mapper's 3D texture.
+ * A stored value s stands for the original value (s * slope) + intercept.
+ * Integer data whose range fits the narrower type is only shifted, so it is
+ * unchanged apart from the intercept; anything else is scaled over the full
+ * range of the narrower type.
+ */
+class ScalarNarrowing
+{
+public:
+	/*
+	 * Replaces the scalars of the volume, reversing its slices along z if
+	 * reverseSlices is set. Returns false, leaving the volume as it is, if
+	 * it is multi-component or its scalars are no wider than scalarType
+	 * (VTK_UNSIGNED_CHAR or VTK_UNSIGNED_SHORT).
+	 */
+	static bool Narrow(
+		vtkImageData *volumeImageData,
+		const int scalarType,
+		const bool reverseSlices,
+		double &slope,
+		double &intercept);
+
+	/*
+	 * Records the range of single component scalars, found while they were
+	 * decoded, so Narrow need not scan them again. Narrow removes it.
+	 */
+	static void AttachScalarRange(
+		vtkImageData *volumeImageData,
+		const double minValue,
+		const double maxValue);
+};
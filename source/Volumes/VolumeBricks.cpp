@@ -0,0 +1,181 @@
+#include "VolumeBricks.h"
+
+#include <vtkDataArray.h>
+#include <vtkPointData.h>
+#include <vtkType.h>
+
+#include <algorithm>
+#include <limits>
+
+
+template<typename ScalarType> static void BrickRanges(
+	const ScalarType *volumeDataPtr,
+	const size_t nComponents,
+	const std::array<int, 3> &dimensions,
+	const VolumeBricks &bricks,
+	double *mins,
+	double *maxs)
+{
+	const size_t rowVoxels = static_cast<size_t>(dimensions[0]);
+	const size_t sliceVoxels = rowVoxels * dimensions[1];
+
+	bricks.ForEachBrick([&](const size_t brick, const std::array<int, 6> &extent)
+	{
+		double brickMin = std::numeric_limits<double>::max();
+		double brickMax = std::numeric_limits<double>::lowest();
+
+		for (int z = extent[4]; z <= extent[5]; ++z)
+		{
+			for (int y = extent[2]; y <= extent[3]; ++y)
+			{
+				const ScalarType *row = volumeDataPtr +
+					((z * sliceVoxels) + (y * rowVoxels) + extent[0]) * nComponents;
+
+				for (int x = 0; x <= extent[1] - extent[0]; ++x)
+				{
+					const double value = static_cast<double>(row[x * nComponents]);
+					brickMin = std::min(brickMin, value);
+					brickMax = std::max(brickMax, value);
+				}
+			}
+		}
+
+		mins[brick] = brickMin;
+		maxs[brick] = brickMax;
+	});
+}
+
+
+std::shared_ptr<VolumeBricks> VolumeBricks::Build(
+	vtkImageData *volumeImageData,
+	const int brickSize)
+{
+	vtkDataArray *scalars = volumeImageData->GetPointData()->GetScalars();
+
+	if (nullptr == scalars ||
+		brickSize < 1)
+	{
+		return nullptr;
+	}
+
+	std::shared_ptr<VolumeBricks> bricks(new VolumeBricks());
+	bricks->mBrickSize = brickSize;
+	volumeImageData->GetDimensions(bricks->mDimensions.data());
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		bricks->mBrickCounts[axis] = (bricks->mDimensions[axis] + brickSize - 1) / brickSize;
+	}
+
+	const size_t nBricks = bricks->GetNBricks();
+	bricks->mMins.resize(nBricks);
+	bricks->mMaxs.resize(nBricks);
+	bricks->mAllPadding.assign(nBricks, 0);
+
+	void *volumeDataPtr = scalars->GetVoidPointer(0);
+
+	switch (scalars->GetDataType())
+	{
+		vtkTemplateMacro(BrickRanges(
+			static_cast<const VTK_TT*>(volumeDataPtr),
+			static_cast<size_t>(scalars->GetNumberOfComponents()),
+			bricks->mDimensions,
+			*bricks,
+			bricks->mMins.data(),
+			bricks->mMaxs.data()));
+	default:
+		return nullptr;
+	}
+
+	return bricks;
+}
+
+
+int VolumeBricks::GetBrickSize() const
+{
+	return mBrickSize;
+}
+
+
+const std::array<int, 3> &VolumeBricks::GetBrickCounts() const
+{
+	return mBrickCounts;
+}
+
+
+size_t VolumeBricks::GetNBricks() const
+{
+	return static_cast<size_t>(mBrickCounts[0]) * mBrickCounts[1] * mBrickCounts[2];
+}
+
+
+size_t VolumeBricks::GetBrickIndex(
+	const int x,
+	const int y,
+	const int z) const
+{
+	return (((static_cast<size_t>(z / mBrickSize) * mBrickCounts[1]) + (y / mBrickSize)) * mBrickCounts[0]) +
+		(x / mBrickSize);
+}
+
+
+std::array<int, 6> VolumeBricks::GetBrickExtent(
+	const size_t brick) const
+{
+	const int brickX = static_cast<int>(brick % mBrickCounts[0]);
+	const int brickY = static_cast<int>((brick / mBrickCounts[0]) % mBrickCounts[1]);
+	const int brickZ = static_cast<int>(brick / (static_cast<size_t>(mBrickCounts[0]) * mBrickCounts[1]));
+
+	const std::array<int, 6> extent = { {
+		brickX * mBrickSize, std::min(mDimensions[0], (brickX + 1) * mBrickSize) - 1,
+		brickY * mBrickSize, std::min(mDimensions[1], (brickY + 1) * mBrickSize) - 1,
+		brickZ * mBrickSize, std::min(mDimensions[2], (brickZ + 1) * mBrickSize) - 1 } };
+
+	return extent;
+}
+
+
+double VolumeBricks::GetBrickMin(
+	const size_t brick) const
+{
+	return mMins[brick];
+}
+
+
+double VolumeBricks::GetBrickMax(
+	const size_t brick) const
+{
+	return mMaxs[brick];
+}
+
+
+void VolumeBricks::SetPaddingValue(
+	const double paddingValue)
+{
+	for (size_t brick = 0; brick < mAllPadding.size(); ++brick)
+	{
+		mAllPadding[brick] =
+			(mMins[brick] >= (paddingValue - 0.5)) &&
+			(mMaxs[brick] <= (paddingValue + 0.5));
+	}
+}
+
+
+bool VolumeBricks::IsAllPadding(
+	const size_t brick) const
+{
+	return 0 != mAllPadding[brick];
+}
+
+
+size_t VolumeBricks::GetNPaddingBricks() const
+{
+	return static_cast<size_t>(std::count(mAllPadding.begin(), mAllPadding.end(), 1));
+}
+
+
+unsigned long long VolumeBricks::GetBytes() const
+{
+	return static_cast<unsigned long long>(GetNBricks()) *
+		((2 * sizeof(double)) + sizeof(uint8_t));
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "ParallelFor.h"
+
+#include <vtkImageData.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+
+/*
+ * A volume split into cubic bricks, brickSize voxels a side bar the last
+ * along each axis, with the range of the first component in each and which
+ * are wholly padding. The voxels stay in the volume's linear array, a brick
+ * is a box of it; kernels walking brick by brick read short runs of rows that
+ * stay in cache, and skip the bricks their ranges rule out. Built once the
+ * volume is in the order it is shown, and dropped when its scalars change.
+ */
+class VolumeBricks
+{
+public:
+	static const int sDefaultBrickSize = 32;
+
+	/*
+	 * Returns nullptr if the volume has no scalars.
+	 */
+	static std::shared_ptr<VolumeBricks> Build(
+		vtkImageData *volumeImageData,
+		const int brickSize);
+
+	int GetBrickSize() const;
+	const std::array<int, 3> &GetBrickCounts() const;
+	size_t GetNBricks() const;
+	size_t GetBrickIndex(
+		const int x,
+		const int y,
+		const int z) const;
+
+	/*
+	 * The voxels of the brick, as an inclusive x, y, z min/max extent from 0.
+	 */
+	std::array<int, 6> GetBrickExtent(
+		const size_t brick) const;
+
+	double GetBrickMin(
+		const size_t brick) const;
+	double GetBrickMax(
+		const size_t brick) const;
+
+	/*
+	 * Flags the bricks every voxel of which is within 0.5 of paddingValue, in
+	 * stored scalar units, as PackedVolumeMask masks them out.
+	 */
+	void SetPaddingValue(
+		const double paddingValue);
+	bool IsAllPadding(
+		const size_t brick) const;
+	size_t GetNPaddingBricks() const;
+
+	/*
+	 * Calls functor(brick, extent) for every brick, spread over all cores,
+	 * skipping the all padding bricks if asked.
+	 */
+	template<typename Functor> void ForEachBrick(
+		Functor functor,
+		const bool skipPadding = false) const
+	{
+		ParallelFor(GetNBricks(), [&](const size_t brick)
+		{
+			if (!skipPadding ||
+				!IsAllPadding(brick))
+			{
+				functor(brick, GetBrickExtent(brick));
+			}
+		});
+	}
+
+	unsigned long long GetBytes() const;
+
+private:
+	VolumeBricks() = default;
+
+	int mBrickSize = sDefaultBrickSize;
+	std::array<int, 3> mDimensions;
+	std::array<int, 3> mBrickCounts;
+	std::vector<double> mMins;
+	std::vector<double> mMaxs;
+	std::vector<uint8_t> mAllPadding;
+};
@@ -0,0 +1,125 @@
+#include "VolumeBuffer.h"
+
+#include "ParallelFor.h"
+
+#include <vtkCallbackCommand.h>
+#include <vtkCommand.h>
+#include <vtkDataArray.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+
+#include <cstring>
+
+
+// The array holds the release function until the array itself is deleted
+static void CallRelease(
+	vtkObject *caller,
+	unsigned long eventId,
+	void *clientData,
+	void *callData)
+{
+	auto release = static_cast<VolumeBuffer::ReleaseFunction*>(clientData);
+
+	if (*release)
+	{
+		(*release)();
+	}
+
+	delete release;
+}
+
+
+static bool IsValidLayout(
+	const RawVolumeLayout &layout)
+{
+	return layout.nComponents > 0 &&
+		layout.dimensions[0] > 0 &&
+		layout.dimensions[1] > 0 &&
+		layout.dimensions[2] > 0 &&
+		0 != layout.GetDataBytes();
+}
+
+
+static vtkSmartPointer<vtkImageData> NewVolume(
+	const RawVolumeLayout &layout)
+{
+	auto volumeImageData = vtkSmartPointer<vtkImageData>::New();
+	volumeImageData->SetDimensions(layout.dimensions.data());
+	volumeImageData->SetSpacing(layout.spacing.data());
+	volumeImageData->SetOrigin(layout.origin.data());
+
+	return volumeImageData;
+}
+
+
+vtkSmartPointer<vtkImageData> VolumeBuffer::Wrap(
+	void *buffer,
+	const RawVolumeLayout &layout,
+	ReleaseFunction release)
+{
+	if (nullptr == buffer ||
+		!IsValidLayout(layout))
+	{
+		return nullptr;
+	}
+
+	auto scalars = vtkSmartPointer<vtkDataArray>::Take(
+		vtkDataArray::CreateDataArray(layout.scalarType));
+
+	if (nullptr == scalars)
+	{
+		return nullptr;
+	}
+
+	// save = 1, the array never frees the buffer itself
+	scalars->SetNumberOfComponents(layout.nComponents);
+	scalars->SetVoidArray(
+		buffer,
+		static_cast<vtkIdType>(layout.GetDataBytes() / scalars->GetDataTypeSize()),
+		1);
+
+	vtkNew<vtkCallbackCommand> releaseCallback;
+	releaseCallback->SetCallback(CallRelease);
+	releaseCallback->SetClientData(new ReleaseFunction(release));
+	scalars->AddObserver(vtkCommand::DeleteEvent, releaseCallback.GetPointer());
+
+	vtkSmartPointer<vtkImageData> volumeImageData = NewVolume(layout);
+	volumeImageData->GetPointData()->SetScalars(scalars);
+
+	return volumeImageData;
+}
+
+
+vtkSmartPointer<vtkImageData> VolumeBuffer::Copy(
+	const void *buffer,
+	const RawVolumeLayout &layout,
+	const bool reverseSlices)
+{
+	if (nullptr == buffer ||
+		!IsValidLayout(layout))
+	{
+		return nullptr;
+	}
+
+	vtkSmartPointer<vtkImageData> volumeImageData = NewVolume(layout);
+	volumeImageData->AllocateScalars(layout.scalarType, layout.nComponents);
+
+	unsigned char *volumeDataPtr = static_cast<unsigned char*>(volumeImageData->GetScalarPointer());
+	if (nullptr == volumeDataPtr)
+	{
+		return nullptr;
+	}
+
+	const unsigned char *bufferPtr = static_cast<const unsigned char*>(buffer);
+	const size_t nSlices = static_cast<size_t>(layout.dimensions[2]);
+	const size_t sliceBytes = layout.GetDataBytes() / nSlices;
+
+	// a slice at a time, so reversing costs nothing more than the copy
+	ParallelFor(nSlices, [&](const size_t iSlice)
+	{
+		const size_t z = reverseSlices ? nSlices - 1 - iSlice : iSlice;
+		memcpy(volumeDataPtr + (z * sliceBytes), bufferPtr + (iSlice * sliceBytes), sliceBytes);
+	});
+
+	return volumeImageData;
+}
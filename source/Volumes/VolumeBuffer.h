@@ -0,0 +1,41 @@
+#pragma once
+
+#include "RawVolumeHeader.h"
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+#include <functional>
+
+
+/*
+ * Volumes made from voxels already in memory, with the layout's geometry.
+ * Slices are taken in the order given, file loaders leave theirs in file
+ * order for ReverseVolumeAlongZ.
+ */
+class VolumeBuffer
+{
+public:
+	typedef std::function<void()> ReleaseFunction;
+
+	/*
+	 * Uses the buffer as the volume's scalars without copying it. release
+	 * is called, on whichever thread drops the last reference, once the
+	 * scalars are deleted, and holds whatever keeps the buffer alive until
+	 * then. Nothing writes to the buffer. Returns nullptr, without calling
+	 * release, for an unsupported layout.
+	 */
+	static vtkSmartPointer<vtkImageData> Wrap(
+		void *buffer,
+		const RawVolumeLayout &layout,
+		ReleaseFunction release);
+
+	/*
+	 * Copies the buffer into a new volume, reversing the slices on the way
+	 * if asked, so the caller may free it straight away.
+	 */
+	static vtkSmartPointer<vtkImageData> Copy(
+		const void *buffer,
+		const RawVolumeLayout &layout,
+		const bool reverseSlices);
+};
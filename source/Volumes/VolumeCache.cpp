@@ -0,0 +1,354 @@
+#include "VolumeCache.h"
+
+#include "MappedFile.h"
+#include "MappedVolumeReader.h"
+
+#include <vtkDirectory.h>
+#include <vtkNew.h>
+#include <vtksys/SystemTools.hxx>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <string.h>
+#include <vector>
+
+
+static const char sCacheMagic[8] = { 'V', 'T', 'U', 'V', 'O', 'L', '0', '2' };
+static const std::string sCacheExtension(".vtuvol");
+// page aligned, so the voxels can be mapped straight from the entry
+static const uint64_t sCacheDataAlignment(4096);
+
+// Entries are written and trimmed by both the render and loader threads
+static std::mutex sCacheMutex;
+
+
+struct VolumeCacheHeader
+{
+	char magic[8];
+	uint64_t sourceBytes;
+	int64_t sourceTime;
+	uint64_t dataOffset;
+	uint64_t dataBytes;
+	int32_t scalarType;
+	int32_t nComponents;
+	int32_t dimensions[3];
+	uint32_t sourcePathBytes;
+	double spacing[3];
+	double origin[3];
+	double rescaleSlope;
+	double rescaleIntercept;
+};
+
+
+// The size and modification time of the source, totalled over the files of a folder
+static bool GetSourceStamp(
+	const std::string &sourcePath,
+	uint64_t &sourceBytes,
+	int64_t &sourceTime)
+{
+	if (!vtksys::SystemTools::FileExists(sourcePath))
+	{
+		return false;
+	}
+
+	sourceBytes = 0;
+	sourceTime = 0;
+
+	if (!vtksys::SystemTools::FileIsDirectory(sourcePath))
+	{
+		sourceBytes = vtksys::SystemTools::FileLength(sourcePath);
+		sourceTime = vtksys::SystemTools::ModifiedTime(sourcePath);
+		return true;
+	}
+
+	vtkNew<vtkDirectory> directory;
+	if (!directory->Open(sourcePath.c_str()))
+	{
+		return false;
+	}
+
+	for (vtkIdType iFile = 0; iFile < directory->GetNumberOfFiles(); ++iFile)
+	{
+		const std::string filePath = sourcePath + "/" + directory->GetFile(iFile);
+
+		if (!vtksys::SystemTools::FileIsDirectory(filePath))
+		{
+			sourceBytes += vtksys::SystemTools::FileLength(filePath);
+			sourceTime = std::max<int64_t>(sourceTime, vtksys::SystemTools::ModifiedTime(filePath));
+		}
+	}
+
+	return true;
+}
+
+
+// FNV-1a of the full source path names the entry
+static std::string CacheEntryPath(
+	const std::string &cacheFolder,
+	const std::string &fullSourcePath)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	for (const char c : fullSourcePath)
+	{
+		hash ^= static_cast<unsigned char>(c);
+		hash *= 1099511628211ULL;
+	}
+
+	char hashText[17];
+	snprintf(hashText, sizeof(hashText), "%016llx", static_cast<unsigned long long>(hash));
+
+	return cacheFolder + "/" + hashText + sCacheExtension;
+}
+
+
+static std::vector<std::string> ListCacheEntries(
+	const std::string &cacheFolder)
+{
+	std::vector<std::string> entryPaths;
+
+	vtkNew<vtkDirectory> directory;
+	if (!directory->Open(cacheFolder.c_str()))
+	{
+		return entryPaths;
+	}
+
+	for (vtkIdType iFile = 0; iFile < directory->GetNumberOfFiles(); ++iFile)
+	{
+		const std::string fileName = directory->GetFile(iFile);
+
+		if (fileName.size() > sCacheExtension.size() &&
+			0 == fileName.compare(fileName.size() - sCacheExtension.size(), std::string::npos, sCacheExtension))
+		{
+			entryPaths.push_back(cacheFolder + "/" + fileName);
+		}
+	}
+
+	return entryPaths;
+}
+
+
+// Removes the least recently used entries until the folder fits in maxBytes
+static void TrimCache(
+	const std::string &cacheFolder,
+	const unsigned long long maxBytes)
+{
+	struct CacheEntry
+	{
+		std::string path;
+		unsigned long long bytes;
+		long int time;
+	};
+
+	std::vector<CacheEntry> entries;
+	unsigned long long totalBytes(0);
+
+	for (const auto &entryPath : ListCacheEntries(cacheFolder))
+	{
+		CacheEntry entry;
+		entry.path = entryPath;
+		entry.bytes = vtksys::SystemTools::FileLength(entryPath);
+		entry.time = vtksys::SystemTools::ModifiedTime(entryPath);
+
+		totalBytes += entry.bytes;
+		entries.push_back(entry);
+	}
+
+	std::sort(entries.begin(), entries.end(),
+		[](const CacheEntry &a, const CacheEntry &b) { return a.time < b.time; });
+
+	for (const auto &entry : entries)
+	{
+		if (totalBytes <= maxBytes)
+		{
+			break;
+		}
+
+		// an entry still mapped by a loaded volume cannot be removed on Windows
+		if (vtksys::SystemTools::RemoveFile(entry.path))
+		{
+			totalBytes -= entry.bytes;
+		}
+	}
+}
+
+
+vtkSmartPointer<vtkImageData> VolumeCache::Find(
+	const std::string &cacheFolder,
+	const std::string &sourcePath,
+	double &rescaleSlope,
+	double &rescaleIntercept)
+{
+	uint64_t sourceBytes;
+	int64_t sourceTime;
+	if (!GetSourceStamp(sourcePath, sourceBytes, sourceTime))
+	{
+		return nullptr;
+	}
+
+	const std::string fullSourcePath = vtksys::SystemTools::CollapseFullPath(sourcePath);
+	const std::string entryPath = CacheEntryPath(cacheFolder, fullSourcePath);
+
+	if (!vtksys::SystemTools::FileExists(entryPath))
+	{
+		return nullptr;
+	}
+
+	std::shared_ptr<MappedFile> mappedFile = MappedFile::Open(entryPath);
+	if (nullptr == mappedFile ||
+		mappedFile->GetSize() < sizeof(VolumeCacheHeader))
+	{
+		return nullptr;
+	}
+
+	VolumeCacheHeader header;
+	memcpy(&header, mappedFile->GetData(), sizeof(header));
+
+	const char *entrySourcePath =
+		reinterpret_cast<const char*>(mappedFile->GetData() + sizeof(header));
+
+	if (0 != memcmp(header.magic, sCacheMagic, sizeof(sCacheMagic)) ||
+		header.sourceBytes != sourceBytes ||
+		header.sourceTime != sourceTime ||
+		header.sourcePathBytes != fullSourcePath.size() ||
+		sizeof(header) + header.sourcePathBytes > mappedFile->GetSize() ||
+		0 != fullSourcePath.compare(0, std::string::npos, entrySourcePath, header.sourcePathBytes) ||
+		header.dataOffset + header.dataBytes > mappedFile->GetSize())
+	{
+		return nullptr;
+	}
+
+	RawVolumeLayout layout;
+	layout.scalarType = header.scalarType;
+	layout.nComponents = header.nComponents;
+	std::copy(header.dimensions, header.dimensions + 3, layout.dimensions.begin());
+	std::copy(header.spacing, header.spacing + 3, layout.spacing.begin());
+	std::copy(header.origin, header.origin + 3, layout.origin.begin());
+
+	if (layout.GetDataBytes() != header.dataBytes)
+	{
+		return nullptr;
+	}
+
+	// mark the entry as recently used
+	vtksys::SystemTools::Touch(entryPath, false);
+
+	rescaleSlope = header.rescaleSlope;
+	rescaleIntercept = header.rescaleIntercept;
+
+	return MappedVolumeReader::Wrap(
+		mappedFile, static_cast<size_t>(header.dataOffset), layout);
+}
+
+
+bool VolumeCache::Store(
+	const std::string &cacheFolder,
+	const unsigned long long maxBytes,
+	const std::string &sourcePath,
+	vtkImageData *volumeImageData,
+	const bool reverseSlices,
+	const double rescaleSlope,
+	const double rescaleIntercept)
+{
+	std::lock_guard<std::mutex> lock(sCacheMutex);
+
+	VolumeCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, sCacheMagic, sizeof(sCacheMagic));
+
+	if (nullptr == volumeImageData->GetScalarPointer() ||
+		!GetSourceStamp(sourcePath, header.sourceBytes, header.sourceTime) ||
+		!vtksys::SystemTools::MakeDirectory(cacheFolder))
+	{
+		return false;
+	}
+
+	const std::string fullSourcePath = vtksys::SystemTools::CollapseFullPath(sourcePath);
+	const std::string entryPath = CacheEntryPath(cacheFolder, fullSourcePath);
+	const std::string writePath = entryPath + ".tmp";
+
+	volumeImageData->GetDimensions(header.dimensions);
+	volumeImageData->GetSpacing(header.spacing);
+	volumeImageData->GetOrigin(header.origin);
+	header.scalarType = volumeImageData->GetScalarType();
+	header.nComponents = volumeImageData->GetNumberOfScalarComponents();
+	header.sourcePathBytes = static_cast<uint32_t>(fullSourcePath.size());
+	header.rescaleSlope = rescaleSlope;
+	header.rescaleIntercept = rescaleIntercept;
+
+	const uint64_t sliceBytes =
+		static_cast<uint64_t>(header.dimensions[0]) *
+		static_cast<uint64_t>(header.dimensions[1]) *
+		static_cast<uint64_t>(volumeImageData->GetScalarSize() * header.nComponents);
+	const uint64_t nSlices = static_cast<uint64_t>(header.dimensions[2]);
+
+	header.dataBytes = sliceBytes * nSlices;
+	header.dataOffset =
+		((sizeof(header) + header.sourcePathBytes + sCacheDataAlignment - 1) / sCacheDataAlignment) *
+		sCacheDataAlignment;
+
+	{
+		std::ofstream entryFile(writePath, std::ios::binary | std::ios::trunc);
+
+		const std::vector<char> padding(
+			static_cast<size_t>(header.dataOffset - sizeof(header) - header.sourcePathBytes), 0);
+
+		entryFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		entryFile.write(fullSourcePath.data(), fullSourcePath.size());
+		entryFile.write(padding.data(), padding.size());
+
+		const char *volumeDataPtr = static_cast<const char*>(volumeImageData->GetScalarPointer());
+		for (uint64_t z = 0; z < nSlices && entryFile; ++z)
+		{
+			const uint64_t zIn = reverseSlices ? (nSlices - 1 - z) : z;
+			entryFile.write(volumeDataPtr + (zIn * sliceBytes), static_cast<std::streamsize>(sliceBytes));
+		}
+
+		if (!entryFile)
+		{
+			entryFile.close();
+			vtksys::SystemTools::RemoveFile(writePath);
+			return false;
+		}
+	}
+
+	// write then rename, so a half written entry is never found
+	vtksys::SystemTools::RemoveFile(entryPath);
+	if (!vtksys::SystemTools::RenameFile(writePath, entryPath))
+	{
+		vtksys::SystemTools::RemoveFile(writePath);
+		return false;
+	}
+
+	TrimCache(cacheFolder, maxBytes);
+	return true;
+}
+
+
+void VolumeCache::Clear(
+	const std::string &cacheFolder)
+{
+	std::lock_guard<std::mutex> lock(sCacheMutex);
+
+	for (const auto &entryPath : ListCacheEntries(cacheFolder))
+	{
+		vtksys::SystemTools::RemoveFile(entryPath);
+	}
+}
+
+
+std::string VolumeCache::DefaultFolder()
+{
+	std::string tempFolder;
+
+	if (!vtksys::SystemTools::GetEnv("TEMP", tempFolder) &&
+		!vtksys::SystemTools::GetEnv("TMP", tempFolder) &&
+		!vtksys::SystemTools::GetEnv("TMPDIR", tempFolder))
+	{
+		tempFolder = "/tmp";
+	}
+
+	return tempFolder + "/VtkToUnityVolumeCache";
+}
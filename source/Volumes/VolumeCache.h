@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+#include <string>
+
+
+/*
+ * On-disk cache of loaded volumes, already reversed along z, so reopening a
+ * study maps one file rather than parsing and decoding the source again.
+ * Entries are keyed on the source path, size and modification time (for a
+ * DICOM folder the total size and latest time of its files), so a changed
+ * source is simply read again. The voxels are stored page aligned after a
+ * small header and are memory mapped on a hit. The spacing and origin are
+ * stored as read: converting them to metres and re-centring depend on the
+ * first volume of the session and cost nothing. The source's rescale of its
+ * values is stored with them, whichever reader it came from.
+ * The least recently used entries are removed once the folder is over its
+ * size limit.
+ */
+class VolumeCache
+{
+public:
+	/*
+	 * Returns nullptr if there is no up to date entry for the source, the
+	 * rescale is only set for an entry found.
+	 */
+	static vtkSmartPointer<vtkImageData> Find(
+		const std::string &cacheFolder,
+		const std::string &sourcePath,
+		double &rescaleSlope,
+		double &rescaleIntercept);
+
+	/*
+	 * Writes the entry for the source, with its slices in reverse order if
+	 * reverseSlices is set, then trims the folder to maxBytes.
+	 */
+	static bool Store(
+		const std::string &cacheFolder,
+		const unsigned long long maxBytes,
+		const std::string &sourcePath,
+		vtkImageData *volumeImageData,
+		const bool reverseSlices,
+		const double rescaleSlope,
+		const double rescaleIntercept);
+
+	static void Clear(
+		const std::string &cacheFolder);
+
+	/*
+	 * A folder in the user's temporary files.
+	 */
+	static std::string DefaultFolder();
+};
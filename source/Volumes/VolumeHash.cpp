@@ -0,0 +1,178 @@
+#include "VolumeHash.h"
+
+#include "ParallelFor.h"
+
+#include <vtkDataArray.h>
+#include <vtkPointData.h>
+
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+
+static const uint64_t sPrime1(0x9E3779B185EBCA87ULL);
+static const uint64_t sPrime2(0xC2B2AE3D27D4EB4FULL);
+static const uint64_t sPrime3(0x165667B19E3779F9ULL);
+
+
+static inline uint64_t RotateLeft(
+	const uint64_t value,
+	const int bits)
+{
+	return (value << bits) | (value >> (64 - bits));
+}
+
+
+static inline uint64_t Round(
+	const uint64_t lane,
+	const uint64_t word)
+{
+	return RotateLeft(lane + (word * sPrime2), 31) * sPrime1;
+}
+
+
+// Spreads every input bit over the whole result
+static inline uint64_t Avalanche(
+	uint64_t hash)
+{
+	hash ^= hash >> 33;
+	hash *= sPrime2;
+	hash ^= hash >> 29;
+	hash *= sPrime3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+
+static uint64_t HashBytes(
+	const unsigned char *bytes,
+	const size_t nBytes)
+{
+	// four lanes of independent multiplies keep the pipeline full
+	uint64_t lanes[4] = { sPrime1 + sPrime2, sPrime2, 0, 0 - sPrime1 };
+	const size_t nBlocks = nBytes / 32;
+
+	for (size_t iBlock = 0; iBlock < nBlocks; ++iBlock)
+	{
+		for (int iLane = 0; iLane < 4; ++iLane)
+		{
+			uint64_t word;
+			memcpy(&word, bytes + (32 * iBlock) + (8 * iLane), sizeof(word));
+			lanes[iLane] = Round(lanes[iLane], word);
+		}
+	}
+
+	uint64_t hash = RotateLeft(lanes[0], 1) + RotateLeft(lanes[1], 7) +
+		RotateLeft(lanes[2], 12) + RotateLeft(lanes[3], 18) + nBytes;
+
+	for (size_t i = 32 * nBlocks; i < nBytes; ++i)
+	{
+		hash = RotateLeft(hash ^ (bytes[i] * sPrime3), 11) * sPrime1;
+	}
+
+	return Avalanche(hash);
+}
+
+
+static bool SliceLayout(
+	vtkImageData *volumeImageData,
+	const unsigned char *&volumeDataPtr,
+	size_t &nSlices,
+	size_t &sliceBytes)
+{
+	vtkDataArray *scalars = volumeImageData->GetPointData()->GetScalars();
+
+	if (nullptr == scalars)
+	{
+		return false;
+	}
+
+	const int *dimensions = volumeImageData->GetDimensions();
+	volumeDataPtr = static_cast<const unsigned char*>(scalars->GetVoidPointer(0));
+	nSlices = static_cast<size_t>(dimensions[2]);
+	sliceBytes =
+		static_cast<size_t>(dimensions[0]) *
+		static_cast<size_t>(dimensions[1]) *
+		static_cast<size_t>(scalars->GetNumberOfComponents()) *
+		static_cast<size_t>(scalars->GetDataTypeSize());
+
+	return true;
+}
+
+
+uint64_t VolumeHash::Compute(
+	vtkImageData *volumeImageData,
+	const bool reverseSlices)
+{
+	const unsigned char *volumeDataPtr;
+	size_t nSlices;
+	size_t sliceBytes;
+
+	if (!SliceLayout(volumeImageData, volumeDataPtr, nSlices, sliceBytes))
+	{
+		return 0;
+	}
+
+	// slice hashes in the order shown, whatever the order in memory
+	std::vector<uint64_t> sliceHashes(nSlices);
+	ParallelFor(nSlices, [&](const size_t z)
+	{
+		const size_t shownZ = reverseSlices ? nSlices - 1 - z : z;
+		sliceHashes[shownZ] = HashBytes(volumeDataPtr + (z * sliceBytes), sliceBytes);
+	});
+
+	vtkDataArray *scalars = volumeImageData->GetPointData()->GetScalars();
+	uint64_t hash = Round(sPrime3, static_cast<uint64_t>(scalars->GetDataType()));
+	hash = Round(hash, static_cast<uint64_t>(scalars->GetNumberOfComponents()));
+
+	for (const uint64_t sliceHash : sliceHashes)
+	{
+		hash = Round(hash, sliceHash);
+	}
+
+	hash = Avalanche(hash);
+	return (0 == hash) ? 1 : hash;
+}
+
+
+bool VolumeHash::SameScalars(
+	vtkImageData *volumeA,
+	const bool reverseSlicesA,
+	vtkImageData *volumeB,
+	const bool reverseSlicesB)
+{
+	const unsigned char *volumeDataPtrA;
+	const unsigned char *volumeDataPtrB;
+	size_t nSlicesA;
+	size_t nSlicesB;
+	size_t sliceBytesA;
+	size_t sliceBytesB;
+
+	if (!SliceLayout(volumeA, volumeDataPtrA, nSlicesA, sliceBytesA) ||
+		!SliceLayout(volumeB, volumeDataPtrB, nSlicesB, sliceBytesB) ||
+		nSlicesA != nSlicesB ||
+		sliceBytesA != sliceBytesB ||
+		volumeA->GetScalarType() != volumeB->GetScalarType())
+	{
+		return false;
+	}
+
+	std::atomic<bool> same(true);
+	ParallelFor(nSlicesA, [&](const size_t z)
+	{
+		if (!same)
+		{
+			return;
+		}
+
+		// slice z of A against the slice of B shown at the same place
+		const size_t zB = (reverseSlicesA != reverseSlicesB) ? nSlicesA - 1 - z : z;
+
+		if (0 != memcmp(volumeDataPtrA + (z * sliceBytesA), volumeDataPtrB + (zB * sliceBytesB), sliceBytesA))
+		{
+			same = false;
+		}
+	});
+
+	return same;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vtkImageData.h>
+
+#include <cstdint>
+
+
+/*
+ * Content hashes for finding volumes loaded more than once. The hash covers
+ * the scalar type, components and bytes of the volume in the order it is
+ * shown, so a volume still in file order (see VolumeRecord::reversePending)
+ * hashes the same as its reversed copy. Slices are hashed in parallel, each
+ * with a 64 bit multiply-rotate hash over 4 independent lanes, then combined
+ * in order. Not for anything security related.
+ */
+class VolumeHash
+{
+public:
+	/*
+	 * Never 0, which is left to mean a volume that has not been hashed.
+	 * Returns 0 if the volume has no scalars.
+	 */
+	static uint64_t Compute(
+		vtkImageData *volumeImageData,
+		const bool reverseSlices);
+
+	/*
+	 * Whether two volumes on the same grid hold the same scalars, each in
+	 * the order it is shown, for when their hashes match.
+	 */
+	static bool SameScalars(
+		vtkImageData *volumeA,
+		const bool reverseSlicesA,
+		vtkImageData *volumeB,
+		const bool reverseSlicesB);
+};
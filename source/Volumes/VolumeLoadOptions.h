@@ -0,0 +1,52 @@
+#pragma once
+
+#include "VolumeCache.h"
+
+#include <vtkType.h>
+
+#include <string>
+
+
+/*
+ * How volumes are read, copied by value into each load so a background load
+ * is not affected by later changes.
+ */
+struct VolumeLoadOptions
+{
+	VolumeLoadOptions()
+		: parallelDicom(true)
+		, memoryMapped(false)
+		, pipelinedInflate(true)
+		, cacheEnabled(false)
+		, cacheFolder(VolumeCache::DefaultFolder())
+		, cacheMaxBytes(8ULL << 30)
+		, progressive(false)
+		, previewStride(4)
+		, narrowScalarType(VTK_VOID)
+	{}
+
+	// Decode DICOM series on all cores rather than with vtkDICOMImageReader
+	bool parallelDicom;
+
+	// Map uncompressed MetaImage and NRRD data rather than reading it
+	bool memoryMapped;
+
+	// Decode compressed MetaImage, NRRD and NIfTI data with the
+	// CompressedVolumeReader rather than the VTK readers
+	bool pipelinedInflate;
+
+	// Keep loaded volumes in a VolumeCache, and look there first. Off by default,
+	// the entries are large, written as the volume is loaded, and unencrypted
+	bool cacheEnabled;
+	std::string cacheFolder;
+	unsigned long long cacheMaxBytes;
+
+	// Show a VolumePreview, taking every previewStride'th voxel, while a
+	// background load reads the full volume
+	bool progressive;
+	int previewStride;
+
+	// VTK_UNSIGNED_CHAR or VTK_UNSIGNED_SHORT to requantise wider scalars
+	// with ScalarNarrowing, VTK_VOID to keep them as read
+	int narrowScalarType;
+};
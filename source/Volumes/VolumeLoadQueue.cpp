@@ -0,0 +1,224 @@
+#include "VolumeLoadQueue.h"
+
+#include <algorithm>
+
+
+VolumeLoadQueue::VolumeLoadQueue()
+	: mNextTicket(0)
+	, mWorkers(1)
+{}
+
+
+VolumeLoadQueue::~VolumeLoadQueue()
+{
+	CancelAll();
+}
+
+
+int VolumeLoadQueue::Enqueue(
+	LoadFunction load)
+{
+	auto task = std::make_shared<Task>();
+	task->load = std::move(load);
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		task->ticket = mNextTicket++;
+		mTasks[task->ticket] = task;
+	}
+
+	mWorkers.Enqueue([this, task]() { Run(task); });
+
+	return task->ticket;
+}
+
+
+float VolumeLoadQueue::GetProgress(
+	const int ticket)
+{
+	auto task = FindTask(ticket);
+	if (nullptr == task)
+	{
+		return 0.0f;
+	}
+
+	if (VolumeLoadComplete == task->status)
+	{
+		return 1.0f;
+	}
+
+	// hold back the last bit until the volume has been committed
+	return std::min(task->progress.GetFraction(), 0.99f);
+}
+
+
+VolumeLoadStatus VolumeLoadQueue::GetStatus(
+	const int ticket)
+{
+	auto task = FindTask(ticket);
+	if (nullptr == task)
+	{
+		return VolumeLoadUnknown;
+	}
+
+	return static_cast<VolumeLoadStatus>(task->status.load());
+}
+
+
+int VolumeLoadQueue::GetVolumeIndex(
+	const int ticket)
+{
+	auto task = FindTask(ticket);
+	if (nullptr == task ||
+		(VolumeLoadComplete != task->status && VolumeLoadPreviewing != task->status))
+	{
+		return -1;
+	}
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	return task->volumeIndex;
+}
+
+
+void VolumeLoadQueue::Cancel(
+	const int ticket)
+{
+	auto task = FindTask(ticket);
+	if (nullptr != task)
+	{
+		task->progress.Cancel();
+	}
+}
+
+
+void VolumeLoadQueue::CancelAll()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	for (auto &ticketTask : mTasks)
+	{
+		ticketTask.second->progress.Cancel();
+	}
+}
+
+
+void VolumeLoadQueue::CommitLoaded(
+	CommitPreviewFunction commitPreview,
+	CommitFunction commit)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	for (auto &ticketTask : mTasks)
+	{
+		auto &task = ticketTask.second;
+
+		if (task->loaded)
+		{
+			auto volume = task->volume;
+			const VolumeRecord record = task->record;
+			task->volume = nullptr;
+			task->loaded = false;
+
+			if (task->progress.IsCancelled())
+			{
+				task->status = VolumeLoadCancelled;
+				continue;
+			}
+
+			// commit touches the renderer, don't hold up the polling threads
+			lock.unlock();
+			const int volumeIndex = commit(volume, record, task->volumeIndex);
+			lock.lock();
+
+			task->volumeIndex = volumeIndex;
+			task->status = (volumeIndex < 0) ? VolumeLoadFailed : VolumeLoadComplete;
+			continue;
+		}
+
+		if (nullptr != task->preview &&
+			!task->progress.IsCancelled())
+		{
+			auto preview = task->preview;
+			auto previewGeometry = task->previewGeometry;
+			task->preview = nullptr;
+			task->previewGeometry = nullptr;
+
+			lock.unlock();
+			const int previewIndex = commitPreview(preview, previewGeometry);
+			lock.lock();
+
+			// the load may have failed meanwhile, the preview stays either way
+			task->volumeIndex = previewIndex;
+			if (previewIndex >= 0 &&
+				VolumeLoadLoading == task->status)
+			{
+				task->status = VolumeLoadPreviewing;
+			}
+		}
+
+		const int status = task->status;
+		if (task->volumeIndex < 0 &&
+			(VolumeLoadQueued == status || VolumeLoadLoading == status))
+		{
+			// keep the volumes in ticket order
+			break;
+		}
+	}
+}
+
+
+void VolumeLoadQueue::Run(
+	std::shared_ptr<Task> task)
+{
+	if (task->progress.IsCancelled())
+	{
+		task->status = VolumeLoadCancelled;
+		return;
+	}
+
+	task->status = VolumeLoadLoading;
+
+	const PreviewFunction publishPreview =
+		[this, task](vtkSmartPointer<vtkImageData> preview, vtkSmartPointer<vtkImageData> previewGeometry)
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			task->preview = preview;
+			task->previewGeometry = previewGeometry;
+		};
+
+	VolumeRecord record;
+	vtkSmartPointer<vtkImageData> volume = task->load(task->progress, record, publishPreview);
+
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	if (task->progress.IsCancelled())
+	{
+		task->status = VolumeLoadCancelled;
+	}
+	else if (nullptr == volume)
+	{
+		task->status = VolumeLoadFailed;
+	}
+	else
+	{
+		// status stays as it is until the render thread has committed it
+		task->volume = volume;
+		task->record = record;
+		task->loaded = true;
+	}
+}
+
+
+std::shared_ptr<VolumeLoadQueue::Task> VolumeLoadQueue::FindTask(
+	const int ticket)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	auto iter = mTasks.find(ticket);
+	if (mTasks.end() == iter)
+	{
+		return nullptr;
+	}
+
+	return iter->second;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "LoadProgress.h"
+#include "VolumeRecord.h"
+#include "WorkerPool.h"
+
+#include "../VtkToUnityAPIDefines.h"
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+
+
+/*
+ * Runs volume loads on a background thread and tracks them by ticket. The
+ * load function does all of the heavy work (read, copy, flip); the loaded
+ * volume is then handed back to the render thread by CommitLoaded, so that
+ * the volume vector is only ever modified there. Volumes are committed in
+ * ticket order, so a series loaded asynchronously keeps its frame order.
+ */
+class VolumeLoadQueue
+{
+public:
+	// Lets a load show a preview, with the geometry of the full volume, before it finishes
+	typedef std::function<void(vtkSmartPointer<vtkImageData>, vtkSmartPointer<vtkImageData>)> PreviewFunction;
+
+	typedef std::function<vtkSmartPointer<vtkImageData>(
+		LoadProgress&, VolumeRecord&, const PreviewFunction&)> LoadFunction;
+
+	// Adds the preview, returning its index, or -1 if it was rejected
+	typedef std::function<int(vtkSmartPointer<vtkImageData>, vtkSmartPointer<vtkImageData>)> CommitPreviewFunction;
+
+	// Adds the volume, or replaces the preview at the index given (-1 if there
+	// was none), returning its index, or -1 if it was rejected
+	typedef std::function<int(vtkSmartPointer<vtkImageData>, const VolumeRecord&, int)> CommitFunction;
+
+	VolumeLoadQueue();
+	~VolumeLoadQueue();
+
+	/*
+	 * Queues a load and returns its ticket.
+	 */
+	int Enqueue(
+		LoadFunction load);
+
+	/*
+	 * Fraction of the load done, 1 once the volume has been committed.
+	 */
+	float GetProgress(
+		const int ticket);
+
+	VolumeLoadStatus GetStatus(
+		const int ticket);
+
+	/*
+	 * The index of the committed volume, or of its preview, otherwise -1.
+	 */
+	int GetVolumeIndex(
+		const int ticket);
+
+	/*
+	 * Requests cancellation, the loader stops at its next progress check.
+	 */
+	void Cancel(
+		const int ticket);
+
+	void CancelAll();
+
+	/*
+	 * Must be called from the render thread. Commits every loaded volume, or
+	 * preview, whose earlier tickets have all finished or been previewed.
+	 * A preview stays in place if its load then fails or is cancelled.
+	 */
+	void CommitLoaded(
+		CommitPreviewFunction commitPreview,
+		CommitFunction commit);
+
+private:
+	struct Task
+	{
+		Task()
+			: ticket(-1)
+			, status(VolumeLoadQueued)
+			, loaded(false)
+			, volumeIndex(-1)
+		{}
+
+		int ticket;
+		LoadFunction load;
+		LoadProgress progress;
+		std::atomic<int> status;
+		bool loaded;
+		vtkSmartPointer<vtkImageData> volume;
+		VolumeRecord record;
+		vtkSmartPointer<vtkImageData> preview;
+		vtkSmartPointer<vtkImageData> previewGeometry;
+		int volumeIndex;
+	};
+
+	void Run(
+		std::shared_ptr<Task> task);
+
+	std::shared_ptr<Task> FindTask(
+		const int ticket);
+
+	std::mutex mMutex;
+	std::map<int, std::shared_ptr<Task>> mTasks;
+	int mNextTicket;
+
+	// Each load is itself multi-threaded, so one loader thread is enough
+	WorkerPool mWorkers;
+};
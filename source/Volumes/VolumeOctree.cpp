@@ -0,0 +1,343 @@
+#include "VolumeOctree.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+
+std::shared_ptr<VolumeOctree> VolumeOctree::Build(
+	const VolumeBricks &bricks)
+{
+	std::shared_ptr<VolumeOctree> octree(new VolumeOctree());
+	octree->mBrickSize = bricks.GetBrickSize();
+
+	const std::array<int, 3> &brickCounts = bricks.GetBrickCounts();
+	const std::array<int, 6> lastBrickExtent = bricks.GetBrickExtent(bricks.GetNBricks() - 1);
+	octree->mDimensions = { { lastBrickExtent[1] + 1, lastBrickExtent[3] + 1, lastBrickExtent[5] + 1 } };
+
+	Level leaves;
+	leaves.nodeCounts = brickCounts;
+	leaves.nodeBricks = 1;
+	leaves.mins.resize(bricks.GetNBricks());
+	leaves.maxs.resize(bricks.GetNBricks());
+	leaves.allPadding.resize(bricks.GetNBricks());
+
+	for (size_t brick = 0; brick < bricks.GetNBricks(); ++brick)
+	{
+		leaves.mins[brick] = bricks.GetBrickMin(brick);
+		leaves.maxs[brick] = bricks.GetBrickMax(brick);
+		leaves.allPadding[brick] = bricks.IsAllPadding(brick);
+	}
+
+	octree->mLevels.push_back(leaves);
+
+	// each level halves the one below, rounding up, until a single node is left
+	while (octree->mLevels.back().mins.size() > 1)
+	{
+		const Level &below = octree->mLevels.back();
+		Level above;
+		above.nodeBricks = below.nodeBricks * 2;
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			above.nodeCounts[axis] = (below.nodeCounts[axis] + 1) / 2;
+		}
+
+		const size_t nNodes = static_cast<size_t>(above.nodeCounts[0]) * above.nodeCounts[1] * above.nodeCounts[2];
+		above.mins.assign(nNodes, std::numeric_limits<double>::max());
+		above.maxs.assign(nNodes, std::numeric_limits<double>::lowest());
+		above.allPadding.assign(nNodes, 1);
+
+		for (int z = 0; z < below.nodeCounts[2]; ++z)
+		{
+			for (int y = 0; y < below.nodeCounts[1]; ++y)
+			{
+				for (int x = 0; x < below.nodeCounts[0]; ++x)
+				{
+					const size_t child = octree->GetNodeIndex(below, x, y, z);
+					const size_t node = octree->GetNodeIndex(above, x / 2, y / 2, z / 2);
+
+					above.mins[node] = std::min(above.mins[node], below.mins[child]);
+					above.maxs[node] = std::max(above.maxs[node], below.maxs[child]);
+					above.allPadding[node] &= below.allPadding[child];
+				}
+			}
+		}
+
+		octree->mLevels.push_back(above);
+	}
+
+	return octree;
+}
+
+
+void VolumeOctree::UpdatePadding(
+	const VolumeBricks &bricks)
+{
+	Level &leaves = mLevels.front();
+
+	for (size_t brick = 0; brick < leaves.allPadding.size(); ++brick)
+	{
+		leaves.allPadding[brick] = bricks.IsAllPadding(brick);
+	}
+
+	for (size_t iLevel = 1; iLevel < mLevels.size(); ++iLevel)
+	{
+		const Level &below = mLevels[iLevel - 1];
+		Level &above = mLevels[iLevel];
+		std::fill(above.allPadding.begin(), above.allPadding.end(), 1);
+
+		for (int z = 0; z < below.nodeCounts[2]; ++z)
+		{
+			for (int y = 0; y < below.nodeCounts[1]; ++y)
+			{
+				for (int x = 0; x < below.nodeCounts[0]; ++x)
+				{
+					above.allPadding[GetNodeIndex(above, x / 2, y / 2, z / 2)] &=
+						below.allPadding[GetNodeIndex(below, x, y, z)];
+				}
+			}
+		}
+	}
+}
+
+
+int VolumeOctree::GetNLevels() const
+{
+	return static_cast<int>(mLevels.size());
+}
+
+
+bool VolumeOctree::GetVisibleExtent(
+	const ScalarIntervals &visibleScalars,
+	const bool skipPadding,
+	std::array<int, 6> &extent) const
+{
+	extent = { { mDimensions[0], -1, mDimensions[1], -1, mDimensions[2], -1 } };
+
+	// descend from the root only into the nodes that could be visible
+	std::vector<std::pair<int, std::array<int, 3>>> nodes;
+	nodes.push_back(std::make_pair(GetNLevels() - 1, std::array<int, 3>{ { 0, 0, 0 } }));
+
+	while (!nodes.empty())
+	{
+		const int iLevel = nodes.back().first;
+		const std::array<int, 3> position = nodes.back().second;
+		nodes.pop_back();
+
+		const Level &level = mLevels[iLevel];
+		if (!IsNodeVisible(level, GetNodeIndex(level, position[0], position[1], position[2]),
+			visibleScalars, skipPadding))
+		{
+			continue;
+		}
+
+		if (0 == iLevel)
+		{
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				extent[2 * axis] = std::min(extent[2 * axis], position[axis] * mBrickSize);
+				extent[(2 * axis) + 1] = std::max(extent[(2 * axis) + 1],
+					std::min(mDimensions[axis], (position[axis] + 1) * mBrickSize) - 1);
+			}
+			continue;
+		}
+
+		const Level &below = mLevels[iLevel - 1];
+		for (int z = 2 * position[2]; z < std::min(below.nodeCounts[2], (2 * position[2]) + 2); ++z)
+		{
+			for (int y = 2 * position[1]; y < std::min(below.nodeCounts[1], (2 * position[1]) + 2); ++y)
+			{
+				for (int x = 2 * position[0]; x < std::min(below.nodeCounts[0], (2 * position[0]) + 2); ++x)
+				{
+					nodes.push_back(std::make_pair(iLevel - 1, std::array<int, 3>{ { x, y, z } }));
+				}
+			}
+		}
+	}
+
+	if (extent[1] < extent[0])
+	{
+		return false;
+	}
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		extent[2 * axis] = std::max(0, extent[2 * axis] - 1);
+		extent[(2 * axis) + 1] = std::min(mDimensions[axis] - 1, extent[(2 * axis) + 1] + 1);
+	}
+
+	return true;
+}
+
+
+bool VolumeOctree::IsBrickVisible(
+	const size_t brick,
+	const ScalarIntervals &visibleScalars,
+	const bool skipPadding) const
+{
+	return IsNodeVisible(mLevels.front(), brick, visibleScalars, skipPadding);
+}
+
+
+bool VolumeOctree::CastRay(
+	vtkImageData *volumeImageData,
+	const std::array<double, 3> &origin,
+	const std::array<double, 3> &direction,
+	const ScalarIntervals &visibleScalars,
+	const bool skipPadding,
+	double &hitT) const
+{
+	const double length = std::sqrt(
+		(direction[0] * direction[0]) + (direction[1] * direction[1]) + (direction[2] * direction[2]));
+
+	if (length <= 0.0)
+	{
+		return false;
+	}
+
+	// where the ray is within a box of voxel centres, grown by half a voxel
+	auto clipToBox = [&](const std::array<int, 3> &boxMin, const std::array<int, 3> &boxMax,
+		double &tEnter, double &tExit)
+	{
+		tEnter = 0.0;
+		tExit = std::numeric_limits<double>::max();
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			const double low = boxMin[axis] - 0.5;
+			const double high = boxMax[axis] + 0.5;
+
+			if (0.0 == direction[axis])
+			{
+				if (origin[axis] < low || origin[axis] >= high)
+				{
+					tExit = -1.0;
+				}
+				continue;
+			}
+
+			const double tLow = (low - origin[axis]) / direction[axis];
+			const double tHigh = (high - origin[axis]) / direction[axis];
+			tEnter = std::max(tEnter, std::min(tLow, tHigh));
+			tExit = std::min(tExit, std::max(tLow, tHigh));
+		}
+	};
+
+	double t(0.0);
+	double tEnd(0.0);
+	clipToBox({ { 0, 0, 0 } }, { { mDimensions[0] - 1, mDimensions[1] - 1, mDimensions[2] - 1 } }, t, tEnd);
+
+	const double step = 0.5 / length;
+	int *extent = volumeImageData->GetExtent();
+
+	while (t < tEnd)
+	{
+		std::array<int, 3> voxel;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			voxel[axis] = std::min(mDimensions[axis] - 1,
+				std::max(0, static_cast<int>(std::floor(origin[axis] + (t * direction[axis]) + 0.5))));
+		}
+
+		// the largest node around the sample that could not be visible
+		int skipLevel(-1);
+		for (int iLevel = 0; iLevel < GetNLevels(); ++iLevel)
+		{
+			const Level &level = mLevels[iLevel];
+			const int nodeVoxels = level.nodeBricks * mBrickSize;
+
+			if (IsNodeVisible(level, GetNodeIndex(level,
+				voxel[0] / nodeVoxels, voxel[1] / nodeVoxels, voxel[2] / nodeVoxels), visibleScalars, skipPadding))
+			{
+				break;
+			}
+
+			skipLevel = iLevel;
+		}
+
+		if (skipLevel >= 0)
+		{
+			const int nodeVoxels = mLevels[skipLevel].nodeBricks * mBrickSize;
+			std::array<int, 3> nodeMin;
+			std::array<int, 3> nodeMax;
+
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				nodeMin[axis] = (voxel[axis] / nodeVoxels) * nodeVoxels;
+				nodeMax[axis] = std::min(mDimensions[axis], nodeMin[axis] + nodeVoxels) - 1;
+			}
+
+			double nodeEnter(0.0);
+			double nodeExit(0.0);
+			clipToBox(nodeMin, nodeMax, nodeEnter, nodeExit);
+			t = std::max(t + (step * 1e-3), nodeExit + (step * 1e-3));
+			continue;
+		}
+
+		const double value = volumeImageData->GetScalarComponentAsDouble(
+			extent[0] + voxel[0], extent[2] + voxel[1], extent[4] + voxel[2], 0);
+
+		if (IsVisibleScalar(value, visibleScalars))
+		{
+			hitT = t;
+			return true;
+		}
+
+		t += step;
+	}
+
+	return false;
+}
+
+
+bool VolumeOctree::IsVisibleScalar(
+	const double value,
+	const ScalarIntervals &visibleScalars)
+{
+	for (const auto &interval : visibleScalars)
+	{
+		if (value >= interval.first &&
+			value <= interval.second)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+size_t VolumeOctree::GetNodeIndex(
+	const Level &level,
+	const int x,
+	const int y,
+	const int z) const
+{
+	return (((static_cast<size_t>(z) * level.nodeCounts[1]) + y) * level.nodeCounts[0]) + x;
+}
+
+
+bool VolumeOctree::IsNodeVisible(
+	const Level &level,
+	const size_t node,
+	const ScalarIntervals &visibleScalars,
+	const bool skipPadding) const
+{
+	if (skipPadding &&
+		0 != level.allPadding[node])
+	{
+		return false;
+	}
+
+	for (const auto &interval : visibleScalars)
+	{
+		if (level.mins[node] <= interval.second &&
+			level.maxs[node] >= interval.first)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "VolumeBricks.h"
+
+#include <vtkImageData.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+
+/*
+ * A min-max tree over a volume's bricks: the leaves are the bricks, and each
+ * node above holds the range of, and whether it is all padding like, the
+ * up to 8 below it, up to a single root. A node whose range misses every
+ * visible scalar interval is skipped whole, so queries only read the voxels
+ * of bricks that could be seen. Values are in stored scalar units.
+ */
+class VolumeOctree
+{
+public:
+	// Sorted, disjoint [low, high] intervals of the scalars that are not transparent
+	typedef std::vector<std::pair<double, double>> ScalarIntervals;
+
+	static std::shared_ptr<VolumeOctree> Build(
+		const VolumeBricks &bricks);
+
+	/*
+	 * Takes the padding flags of the bricks again, once they are set.
+	 */
+	void UpdatePadding(
+		const VolumeBricks &bricks);
+
+	int GetNLevels() const;
+
+	/*
+	 * The voxels, as an inclusive extent from 0, bounding every brick that
+	 * could be visible, grown by a voxel for interpolation across its faces.
+	 * Returns false if none could be.
+	 */
+	bool GetVisibleExtent(
+		const ScalarIntervals &visibleScalars,
+		const bool skipPadding,
+		std::array<int, 6> &extent) const;
+
+	bool IsBrickVisible(
+		const size_t brick,
+		const ScalarIntervals &visibleScalars,
+		const bool skipPadding) const;
+
+	/*
+	 * Marches the ray, in voxel coordinates from 0, through the volume half a
+	 * voxel at a time, jumping over the largest node at each step that could
+	 * not be visible. Returns false if it leaves the volume without meeting
+	 * a visible voxel, else the ray parameter of the first, nearest sampled.
+	 */
+	bool CastRay(
+		vtkImageData *volumeImageData,
+		const std::array<double, 3> &origin,
+		const std::array<double, 3> &direction,
+		const ScalarIntervals &visibleScalars,
+		const bool skipPadding,
+		double &hitT) const;
+
+	static bool IsVisibleScalar(
+		const double value,
+		const ScalarIntervals &visibleScalars);
+
+private:
+	VolumeOctree() = default;
+
+	struct Level
+	{
+		std::array<int, 3> nodeCounts;
+		// bricks along each axis covered by a node
+		int nodeBricks;
+		std::vector<double> mins;
+		std::vector<double> maxs;
+		std::vector<uint8_t> allPadding;
+	};
+
+	size_t GetNodeIndex(
+		const Level &level,
+		const int x,
+		const int y,
+		const int z) const;
+
+	bool IsNodeVisible(
+		const Level &level,
+		const size_t node,
+		const ScalarIntervals &visibleScalars,
+		const bool skipPadding) const;
+
+	int mBrickSize = VolumeBricks::sDefaultBrickSize;
+	std::array<int, 3> mDimensions;
+	std::vector<Level> mLevels;
+};
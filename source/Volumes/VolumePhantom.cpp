@@ -0,0 +1,862 @@
+#include "VolumePhantom.h"
+
+#include "ParallelFor.h"
+
+#include <vtkDataArray.h>
+#include <vtkPointData.h>
+#include <vtkType.h>
+#include <vtk_zlib.h>
+#include <vtksys/SystemTools.hxx>
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+
+static const double sPi(3.14159265358979323846);
+
+
+// Voxel centres mapped to [-1, 1] along each axis
+struct PhantomGrid
+{
+	std::array<int, 3> dimensions;
+
+	double Coordinate(const int axis, const int i) const
+	{
+		return ((2.0 * (i + 0.5)) / dimensions[axis]) - 1.0;
+	}
+};
+
+
+// A 3 x 3 x 3 lattice of spheres, each brighter than the last
+struct SpheresShape
+{
+	double operator()(const double x, const double y, const double z) const
+	{
+		const double radius(0.2);
+		const int ix = static_cast<int>(std::floor((x + 1.0) * 1.5));
+		const int iy = static_cast<int>(std::floor((y + 1.0) * 1.5));
+		const int iz = static_cast<int>(std::floor((z + 1.0) * 1.5));
+
+		const double dx = x - (((ix + 0.5) / 1.5) - 1.0);
+		const double dy = y - (((iy + 0.5) / 1.5) - 1.0);
+		const double dz = z - (((iz + 0.5) / 1.5) - 1.0);
+
+		if ((dx * dx) + (dy * dy) + (dz * dz) > radius * radius)
+		{
+			return 0.0;
+		}
+
+		const int iSphere = (9 * std::min(iz, 2)) + (3 * std::min(iy, 2)) + std::min(ix, 2);
+		return (iSphere + 1) / 27.0;
+	}
+};
+
+
+// The modified 3D Shepp-Logan head, ten rotated ellipsoids whose values add up
+struct SheppLoganShape
+{
+	struct Ellipsoid
+	{
+		double a, b, c;
+		double x0, y0, z0;
+		double phiDegrees;
+		double value;
+	};
+
+	double operator()(const double x, const double y, const double z) const
+	{
+		static const Ellipsoid sEllipsoids[] = {
+			{ 0.6900, 0.920, 0.810, 0.00, 0.0000, 0.00, 0.0, 1.0 },
+			{ 0.6624, 0.874, 0.780, 0.00, -0.0184, 0.00, 0.0, -0.8 },
+			{ 0.1100, 0.310, 0.220, 0.22, 0.0000, 0.00, -18.0, -0.2 },
+			{ 0.1600, 0.410, 0.280, -0.22, 0.0000, 0.00, 18.0, -0.2 },
+			{ 0.2100, 0.250, 0.410, 0.00, 0.3500, -0.15, 0.0, 0.1 },
+			{ 0.0460, 0.046, 0.050, 0.00, 0.1000, 0.25, 0.0, 0.1 },
+			{ 0.0460, 0.046, 0.050, 0.00, -0.1000, 0.25, 0.0, 0.1 },
+			{ 0.0460, 0.023, 0.050, -0.08, -0.6050, 0.00, 0.0, 0.1 },
+			{ 0.0230, 0.023, 0.020, 0.00, -0.6060, 0.00, 0.0, 0.1 },
+			{ 0.0230, 0.046, 0.020, 0.06, -0.6050, 0.00, 0.0, 0.1 } };
+
+		double value(0.0);
+
+		for (const auto &e : sEllipsoids)
+		{
+			const double phi = e.phiDegrees * sPi / 180.0;
+			const double dx = x - e.x0;
+			const double dy = y - e.y0;
+			const double dz = z - e.z0;
+			const double u = ((dx * std::cos(phi)) + (dy * std::sin(phi))) / e.a;
+			const double v = ((dy * std::cos(phi)) - (dx * std::sin(phi))) / e.b;
+			const double w = dz / e.c;
+
+			if ((u * u) + (v * v) + (w * w) <= 1.0)
+			{
+				value += e.value;
+			}
+		}
+
+		return std::max(0.0, std::min(1.0, value));
+	}
+};
+
+
+// Three octaves of value noise, interpolated between hashed lattice values
+struct NoiseShape
+{
+	uint32_t seed;
+
+	double Lattice(const int ix, const int iy, const int iz) const
+	{
+		uint32_t h = seed;
+		h ^= static_cast<uint32_t>(ix) * 0x8da6b343u;
+		h ^= static_cast<uint32_t>(iy) * 0xd8163841u;
+		h ^= static_cast<uint32_t>(iz) * 0xcb1ab31fu;
+		h ^= h >> 15;
+		h *= 0x2c1b3c6du;
+		h ^= h >> 12;
+		h *= 0x297a2d39u;
+		h ^= h >> 15;
+		return (h & 0xffffff) / static_cast<double>(0x1000000);
+	}
+
+	double Octave(const double x, const double y, const double z) const
+	{
+		const double fx = std::floor(x);
+		const double fy = std::floor(y);
+		const double fz = std::floor(z);
+		const int ix = static_cast<int>(fx);
+		const int iy = static_cast<int>(fy);
+		const int iz = static_cast<int>(fz);
+		const double tx = x - fx;
+		const double ty = y - fy;
+		const double tz = z - fz;
+
+		auto lerp = [](const double a, const double b, const double t) { return a + ((b - a) * t); };
+
+		return lerp(
+			lerp(
+				lerp(Lattice(ix, iy, iz), Lattice(ix + 1, iy, iz), tx),
+				lerp(Lattice(ix, iy + 1, iz), Lattice(ix + 1, iy + 1, iz), tx),
+				ty),
+			lerp(
+				lerp(Lattice(ix, iy, iz + 1), Lattice(ix + 1, iy, iz + 1), tx),
+				lerp(Lattice(ix, iy + 1, iz + 1), Lattice(ix + 1, iy + 1, iz + 1), tx),
+				ty),
+			tz);
+	}
+
+	double operator()(const double x, const double y, const double z) const
+	{
+		double value(0.0);
+		double frequency(4.0);
+		double amplitude(0.5);
+
+		for (int octave = 0; octave < 3; ++octave)
+		{
+			value += amplitude * Octave(x * frequency, y * frequency, z * frequency);
+			frequency *= 2.0;
+			amplitude *= 0.5;
+		}
+
+		return value / 0.875;
+	}
+};
+
+
+// A contracting shell around a blood pool, with a small sphere circling it
+struct BeatingHeartShape
+{
+	double phase;
+
+	double operator()(const double x, const double y, const double z) const
+	{
+		const double outerRadius = 0.55 + (0.12 * std::sin(phase));
+		const double wallThickness = 0.12 - (0.04 * std::sin(phase));
+		const double r = std::sqrt((x * x) + (y * y) + (z * z));
+
+		const double ox = x - (0.8 * std::cos(phase));
+		const double oy = y - (0.8 * std::sin(phase));
+
+		if ((ox * ox) + (oy * oy) + (z * z) < 0.01)
+		{
+			return 1.0;
+		}
+
+		if (r < outerRadius - wallThickness)
+		{
+			return 0.4;
+		}
+
+		if (r < outerRadius)
+		{
+			return 0.8;
+		}
+
+		return (r < 0.95) ? 0.05 : 0.0;
+	}
+};
+
+
+template<typename ScalarType, typename Shape> static void FillPhantom(
+	ScalarType *volumeDataPtr,
+	const PhantomGrid &grid,
+	const double maxValue,
+	const Shape &shape)
+{
+	const size_t sliceValues =
+		static_cast<size_t>(grid.dimensions[0]) *
+		static_cast<size_t>(grid.dimensions[1]);
+
+	ParallelFor(static_cast<size_t>(grid.dimensions[2]), [&](const size_t z)
+	{
+		ScalarType *voxel = volumeDataPtr + (z * sliceValues);
+		const double zc = grid.Coordinate(2, static_cast<int>(z));
+
+		for (int y = 0; y < grid.dimensions[1]; ++y)
+		{
+			const double yc = grid.Coordinate(1, y);
+
+			for (int x = 0; x < grid.dimensions[0]; ++x)
+			{
+				*voxel++ = static_cast<ScalarType>(
+					(shape(grid.Coordinate(0, x), yc, zc) * maxValue) + 0.5);
+			}
+		}
+	});
+}
+
+
+template<typename ScalarType> static void FillPhantomOfType(
+	ScalarType *volumeDataPtr,
+	const PhantomGrid &grid,
+	const double maxValue,
+	const VolumePhantomType type,
+	const int frame,
+	const int nFrames)
+{
+	switch (type)
+	{
+	case VolumePhantomSpheres:
+		FillPhantom(volumeDataPtr, grid, maxValue, SpheresShape());
+		break;
+	case VolumePhantomSheppLogan:
+		FillPhantom(volumeDataPtr, grid, maxValue, SheppLoganShape());
+		break;
+	case VolumePhantomNoise:
+	{
+		NoiseShape noise;
+		noise.seed = 0x9e3779b9u + static_cast<uint32_t>(frame);
+		FillPhantom(volumeDataPtr, grid, maxValue, noise);
+		break;
+	}
+	case VolumePhantomBeatingHeart:
+	{
+		BeatingHeartShape heart;
+		heart.phase = (2.0 * sPi * frame) / std::max(1, nFrames);
+		FillPhantom(volumeDataPtr, grid, maxValue, heart);
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+
+vtkSmartPointer<vtkImageData> VolumePhantom::Generate(
+	const VolumePhantomType type,
+	const int *dimensions,
+	const int scalarType,
+	const int frame,
+	const int nFrames)
+{
+	if (type < 0 ||
+		type >= NVolumePhantomType ||
+		dimensions[0] <= 0 ||
+		dimensions[1] <= 0 ||
+		dimensions[2] <= 0)
+	{
+		return nullptr;
+	}
+
+	PhantomGrid grid;
+	std::copy(dimensions, dimensions + 3, grid.dimensions.begin());
+
+	auto volumeImageData = vtkSmartPointer<vtkImageData>::New();
+	volumeImageData->SetDimensions(dimensions);
+	volumeImageData->SetSpacing(1.0, 1.0, 1.0);
+	volumeImageData->SetOrigin(0.0, 0.0, 0.0);
+	volumeImageData->AllocateScalars(scalarType, 1);
+
+	void *volumeDataPtr = volumeImageData->GetScalarPointer();
+	if (nullptr == volumeDataPtr)
+	{
+		return nullptr;
+	}
+
+	const double maxValue =
+		(VTK_UNSIGNED_CHAR == scalarType) ? 255.0 :
+		(VTK_CHAR == scalarType || VTK_SIGNED_CHAR == scalarType) ? 127.0 :
+		4095.0;
+
+	switch (scalarType)
+	{
+		vtkTemplateMacro(FillPhantomOfType(
+			static_cast<VTK_TT*>(volumeDataPtr), grid, maxValue, type, frame, nFrames));
+	default:
+		return nullptr;
+	}
+
+	return volumeImageData;
+}
+
+
+static const char *MetaElementType(
+	const int scalarType)
+{
+	switch (scalarType)
+	{
+	case VTK_UNSIGNED_CHAR: return "MET_UCHAR";
+	case VTK_CHAR: return "MET_CHAR";
+	case VTK_SIGNED_CHAR: return "MET_CHAR";
+	case VTK_UNSIGNED_SHORT: return "MET_USHORT";
+	case VTK_SHORT: return "MET_SHORT";
+	case VTK_UNSIGNED_INT: return "MET_UINT";
+	case VTK_INT: return "MET_INT";
+	case VTK_FLOAT: return "MET_FLOAT";
+	case VTK_DOUBLE: return "MET_DOUBLE";
+	default: return nullptr;
+	}
+}
+
+
+static const char *NrrdType(
+	const int scalarType)
+{
+	switch (scalarType)
+	{
+	case VTK_UNSIGNED_CHAR: return "uchar";
+	case VTK_CHAR: return "signed char";
+	case VTK_SIGNED_CHAR: return "signed char";
+	case VTK_UNSIGNED_SHORT: return "ushort";
+	case VTK_SHORT: return "short";
+	case VTK_UNSIGNED_INT: return "uint";
+	case VTK_INT: return "int";
+	case VTK_FLOAT: return "float";
+	case VTK_DOUBLE: return "double";
+	default: return nullptr;
+	}
+}
+
+
+// The loaders reverse the slices they read, so they are written last first
+static bool WriteSlicesReversed(
+	std::ofstream &dataFile,
+	vtkImageData *volumeImageData)
+{
+	const int *dimensions = volumeImageData->GetDimensions();
+	const size_t sliceBytes =
+		static_cast<size_t>(dimensions[0]) *
+		static_cast<size_t>(dimensions[1]) *
+		static_cast<size_t>(volumeImageData->GetScalarSize());
+	const char *volumeDataPtr = static_cast<const char*>(volumeImageData->GetScalarPointer());
+
+	for (int z = dimensions[2] - 1; z >= 0 && dataFile; --z)
+	{
+		dataFile.write(volumeDataPtr + (static_cast<size_t>(z) * sliceBytes),
+			static_cast<std::streamsize>(sliceBytes));
+	}
+
+	return static_cast<bool>(dataFile);
+}
+
+
+// As WriteSlicesReversed, through a zlib (15 window bits) or gzip (31) stream,
+// after any header that is to be in the stream too
+static bool DeflateSlicesReversed(
+	std::ofstream &dataFile,
+	vtkImageData *volumeImageData,
+	const int windowBits,
+	long long &compressedBytes,
+	const std::string &streamHeader = std::string())
+{
+	const int *dimensions = volumeImageData->GetDimensions();
+	const size_t sliceBytes =
+		static_cast<size_t>(dimensions[0]) *
+		static_cast<size_t>(dimensions[1]) *
+		static_cast<size_t>(volumeImageData->GetScalarSize());
+	const unsigned char *volumeDataPtr =
+		static_cast<const unsigned char*>(volumeImageData->GetScalarPointer());
+
+	z_stream stream = {};
+	if (Z_OK != deflateInit2(&stream, Z_BEST_SPEED, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY))
+	{
+		return false;
+	}
+
+	std::vector<unsigned char> outBuffer(1 << 20);
+	bool deflated(true);
+	compressedBytes = 0;
+
+	for (int z = dimensions[2]; z >= 0 && deflated; --z)
+	{
+		const int flush = (0 == z) ? Z_FINISH : Z_NO_FLUSH;
+
+		if (dimensions[2] == z)
+		{
+			stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(streamHeader.data()));
+			stream.avail_in = static_cast<uInt>(streamHeader.size());
+		}
+		else
+		{
+			stream.next_in = const_cast<Bytef*>(volumeDataPtr + (static_cast<size_t>(z) * sliceBytes));
+			stream.avail_in = static_cast<uInt>(sliceBytes);
+		}
+
+		// until the slice is taken, and on the last slice until the stream ends
+		int result;
+		do
+		{
+			stream.next_out = outBuffer.data();
+			stream.avail_out = static_cast<uInt>(outBuffer.size());
+			result = deflate(&stream, flush);
+
+			const size_t nOut = outBuffer.size() - stream.avail_out;
+			dataFile.write(reinterpret_cast<const char*>(outBuffer.data()),
+				static_cast<std::streamsize>(nOut));
+			compressedBytes += static_cast<long long>(nOut);
+
+			deflated = dataFile && (Z_OK == result || Z_STREAM_END == result || Z_BUF_ERROR == result);
+		} while (deflated &&
+			(stream.avail_in > 0 || (Z_FINISH == flush && Z_STREAM_END != result)));
+	}
+
+	deflateEnd(&stream);
+
+	return deflated;
+}
+
+
+static bool WriteMhd(
+	vtkImageData *volumeImageData,
+	const std::string &mhdPath,
+	const bool compressed)
+{
+	const char *elementType = MetaElementType(volumeImageData->GetScalarType());
+	if (nullptr == elementType)
+	{
+		return false;
+	}
+
+	const std::string rawName =
+		vtksys::SystemTools::GetFilenameWithoutLastExtension(mhdPath) + (compressed ? ".zraw" : ".raw");
+	const std::string rawFolder = vtksys::SystemTools::GetFilenamePath(mhdPath);
+	const std::string rawPath = rawFolder.empty() ? rawName : rawFolder + "/" + rawName;
+
+	const int *dimensions = volumeImageData->GetDimensions();
+	const double *spacing = volumeImageData->GetSpacing();
+	const double *origin = volumeImageData->GetOrigin();
+
+	// the data goes first, the header needs its compressed size
+	std::ofstream rawFile(rawPath, std::ios::binary | std::ios::trunc);
+	long long compressedBytes(0);
+	const bool dataWritten = compressed
+		? DeflateSlicesReversed(rawFile, volumeImageData, 15, compressedBytes)
+		: WriteSlicesReversed(rawFile, volumeImageData);
+
+	if (!dataWritten)
+	{
+		return false;
+	}
+
+	std::ofstream mhdFile(mhdPath, std::ios::binary | std::ios::trunc);
+	mhdFile.precision(17);
+	mhdFile << "ObjectType = Image\n"
+		<< "NDims = 3\n"
+		<< "BinaryData = True\n"
+		<< "BinaryDataByteOrderMSB = False\n"
+		<< "CompressedData = " << (compressed ? "True" : "False") << "\n";
+
+	if (compressed)
+	{
+		mhdFile << "CompressedDataSize = " << compressedBytes << "\n";
+	}
+
+	mhdFile << "Offset = " << origin[0] << " " << origin[1] << " " << origin[2] << "\n"
+		<< "ElementSpacing = " << spacing[0] << " " << spacing[1] << " " << spacing[2] << "\n"
+		<< "DimSize = " << dimensions[0] << " " << dimensions[1] << " " << dimensions[2] << "\n"
+		<< "ElementType = " << elementType << "\n"
+		<< "ElementDataFile = " << rawName << "\n";
+
+	return static_cast<bool>(mhdFile);
+}
+
+
+static bool WriteNrrd(
+	vtkImageData *volumeImageData,
+	const std::string &nrrdPath,
+	const bool compressed)
+{
+	const char *type = NrrdType(volumeImageData->GetScalarType());
+	if (nullptr == type)
+	{
+		return false;
+	}
+
+	const int *dimensions = volumeImageData->GetDimensions();
+	const double *spacing = volumeImageData->GetSpacing();
+	const double *origin = volumeImageData->GetOrigin();
+
+	std::ofstream nrrdFile(nrrdPath, std::ios::binary | std::ios::trunc);
+	nrrdFile.precision(17);
+	nrrdFile << "NRRD0004\n"
+		<< "type: " << type << "\n"
+		<< "dimension: 3\n"
+		<< "space: left-posterior-superior\n"
+		<< "sizes: " << dimensions[0] << " " << dimensions[1] << " " << dimensions[2] << "\n"
+		<< "space directions: (" << spacing[0] << ",0,0) (0," << spacing[1] << ",0) (0,0," << spacing[2] << ")\n"
+		<< "space origin: (" << origin[0] << "," << origin[1] << "," << origin[2] << ")\n"
+		<< "encoding: " << (compressed ? "gzip" : "raw") << "\n"
+		<< "endian: little\n"
+		<< "\n";
+
+	long long compressedBytes(0);
+	return compressed
+		? DeflateSlicesReversed(nrrdFile, volumeImageData, 31, compressedBytes)
+		: WriteSlicesReversed(nrrdFile, volumeImageData);
+}
+
+
+static int16_t NiftiDatatype(
+	const int scalarType)
+{
+	switch (scalarType)
+	{
+	case VTK_UNSIGNED_CHAR: return 2;
+	case VTK_SHORT: return 4;
+	case VTK_INT: return 8;
+	case VTK_FLOAT: return 16;
+	case VTK_DOUBLE: return 64;
+	case VTK_CHAR: return 256;
+	case VTK_SIGNED_CHAR: return 256;
+	case VTK_UNSIGNED_SHORT: return 512;
+	case VTK_UNSIGNED_INT: return 768;
+	default: return 0;
+	}
+}
+
+
+template<typename T> static void SetNiftiField(
+	std::string &header,
+	const size_t offset,
+	const T value)
+{
+	memcpy(&header[offset], &value, sizeof(T));
+}
+
+
+// A single file NIfTI-1, the origin in the sform, LPS to NIfTI's RAS
+static bool WriteNifti(
+	vtkImageData *volumeImageData,
+	const std::string &niftiPath,
+	const bool compressed)
+{
+	const int16_t datatype = NiftiDatatype(volumeImageData->GetScalarType());
+	if (0 == datatype)
+	{
+		return false;
+	}
+
+	const int *dimensions = volumeImageData->GetDimensions();
+	const double *spacing = volumeImageData->GetSpacing();
+	const double *origin = volumeImageData->GetOrigin();
+
+	// the 348 byte header, then an empty extension flag, the voxels start at 352
+	std::string header(352, '\0');
+	SetNiftiField<int32_t>(header, 0, 348);
+	SetNiftiField<int16_t>(header, 40, 3);
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		SetNiftiField<int16_t>(header, 42 + (2 * axis), static_cast<int16_t>(dimensions[axis]));
+		SetNiftiField<float>(header, 80 + (4 * axis), static_cast<float>(spacing[axis]));
+	}
+
+	for (int axis = 3; axis < 8; ++axis)
+	{
+		SetNiftiField<int16_t>(header, 40 + (2 * axis), 1);
+	}
+
+	SetNiftiField<int16_t>(header, 70, datatype);
+	SetNiftiField<int16_t>(header, 72, static_cast<int16_t>(8 * volumeImageData->GetScalarSize()));
+	SetNiftiField<float>(header, 76, 1.0f);
+	SetNiftiField<float>(header, 108, 352.0f);
+	// spatial units of mm
+	header[123] = 2;
+	SetNiftiField<int16_t>(header, 254, 1);
+
+	const double lpsToRas[3] = { -1.0, -1.0, 1.0 };
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		SetNiftiField<float>(header, 280 + (16 * axis) + (4 * axis),
+			static_cast<float>(lpsToRas[axis] * spacing[axis]));
+		SetNiftiField<float>(header, 280 + (16 * axis) + 12,
+			static_cast<float>(lpsToRas[axis] * origin[axis]));
+	}
+
+	memcpy(&header[344], "n+1", 4);
+
+	std::ofstream niftiFile(niftiPath, std::ios::binary | std::ios::trunc);
+
+	if (compressed)
+	{
+		long long compressedBytes(0);
+		return DeflateSlicesReversed(niftiFile, volumeImageData, 31, compressedBytes, header);
+	}
+
+	niftiFile.write(header.data(), static_cast<std::streamsize>(header.size()));
+	return WriteSlicesReversed(niftiFile, volumeImageData);
+}
+
+
+// Explicit VR little endian data elements, just enough for DICOMParser
+class DicomElementWriter
+{
+public:
+	void String(const uint16_t group, const uint16_t element, const char *vr, std::string value)
+	{
+		// UIDs are padded with a null, everything else with a space
+		if (0 != (value.size() & 1))
+		{
+			value.push_back(('U' == vr[0] && 'I' == vr[1]) ? '\0' : ' ');
+		}
+
+		Header(group, element, vr, static_cast<uint32_t>(value.size()));
+		mBytes.insert(mBytes.end(), value.begin(), value.end());
+	}
+
+	void UnsignedShort(const uint16_t group, const uint16_t element, const uint16_t value)
+	{
+		Header(group, element, "US", 2);
+		Append(value);
+	}
+
+	void UnsignedLong(const uint16_t group, const uint16_t element, const uint32_t value)
+	{
+		Header(group, element, "UL", 4);
+		Append(value);
+	}
+
+	void Binary(const uint16_t group, const uint16_t element, const char *vr, const char *data, const uint32_t nBytes)
+	{
+		Header(group, element, vr, nBytes);
+		mBytes.insert(mBytes.end(), data, data + nBytes);
+
+		if (0 != (nBytes & 1))
+		{
+			mBytes.push_back('\0');
+		}
+	}
+
+	const std::vector<char> &GetBytes() const { return mBytes; }
+
+private:
+	template<typename T> void Append(const T value)
+	{
+		for (size_t iByte = 0; iByte < sizeof(T); ++iByte)
+		{
+			mBytes.push_back(static_cast<char>((value >> (8 * iByte)) & 0xff));
+		}
+	}
+
+	void Header(const uint16_t group, const uint16_t element, const char *vr, const uint32_t length)
+	{
+		Append(group);
+		Append(element);
+		mBytes.push_back(vr[0]);
+		mBytes.push_back(vr[1]);
+
+		const std::string longVr(vr, 2);
+		if ("OB" == longVr || "OW" == longVr || "UN" == longVr)
+		{
+			Append(static_cast<uint16_t>(0));
+			Append(length + (length & 1));
+		}
+		else
+		{
+			Append(static_cast<uint16_t>(length + (length & 1)));
+		}
+	}
+
+	std::vector<char> mBytes;
+};
+
+
+static bool WriteDicomSeries(
+	vtkImageData *volumeImageData,
+	const std::string &folder)
+{
+	const int scalarType = volumeImageData->GetScalarType();
+	const bool isSigned = (VTK_SHORT == scalarType || VTK_SIGNED_CHAR == scalarType || VTK_CHAR == scalarType);
+	const int bitsAllocated = 8 * volumeImageData->GetScalarSize();
+
+	if ((8 != bitsAllocated && 16 != bitsAllocated) ||
+		(VTK_UNSIGNED_CHAR != scalarType && VTK_UNSIGNED_SHORT != scalarType && !isSigned) ||
+		!vtksys::SystemTools::MakeDirectory(folder))
+	{
+		return false;
+	}
+
+	const int *dimensions = volumeImageData->GetDimensions();
+	const double *spacing = volumeImageData->GetSpacing();
+	const double *origin = volumeImageData->GetOrigin();
+	const uint32_t sliceBytes = static_cast<uint32_t>(
+		dimensions[0] * dimensions[1] * volumeImageData->GetScalarSize());
+	const char *volumeDataPtr = static_cast<const char*>(volumeImageData->GetScalarPointer());
+
+	// "2.25." UIDs, made from the geometry so the same phantom gets the same UIDs
+	std::ostringstream uidRoot;
+	uidRoot << "2.25." << (static_cast<unsigned long long>(dimensions[0]) * 1000003ULL +
+		static_cast<unsigned long long>(dimensions[1]) * 1009ULL +
+		static_cast<unsigned long long>(dimensions[2]) * 7ULL +
+		static_cast<unsigned long long>(scalarType));
+	const std::string studyUid = uidRoot.str() + "1";
+	const std::string seriesUid = uidRoot.str() + "2";
+	const std::string sopClassUid = "1.2.840.10008.5.1.4.1.1.7"; // secondary capture
+	const std::string transferSyntaxUid = "1.2.840.10008.1.2.1"; // explicit VR little endian
+
+	std::ostringstream pixelSpacing;
+	pixelSpacing << spacing[1] << "\\" << spacing[0];
+
+	for (int iFile = 0; iFile < dimensions[2]; ++iFile)
+	{
+		// file i is the slice at position i, the reader reverses them
+		const int z = dimensions[2] - 1 - iFile;
+		const std::string sopInstanceUid = uidRoot.str() + "3" + std::to_string(iFile);
+
+		std::ostringstream position;
+		position << origin[0] << "\\" << origin[1] << "\\" << (origin[2] + (iFile * spacing[2]));
+
+		DicomElementWriter meta;
+		meta.Binary(0x0002, 0x0001, "OB", "\0\1", 2);
+		meta.String(0x0002, 0x0002, "UI", sopClassUid);
+		meta.String(0x0002, 0x0003, "UI", sopInstanceUid);
+		meta.String(0x0002, 0x0010, "UI", transferSyntaxUid);
+		meta.String(0x0002, 0x0012, "UI", "2.25.1");
+
+		DicomElementWriter metaLength;
+		metaLength.UnsignedLong(0x0002, 0x0000, static_cast<uint32_t>(meta.GetBytes().size()));
+
+		DicomElementWriter data;
+		data.String(0x0008, 0x0008, "CS", "DERIVED\\SECONDARY");
+		data.String(0x0008, 0x0016, "UI", sopClassUid);
+		data.String(0x0008, 0x0018, "UI", sopInstanceUid);
+		data.String(0x0008, 0x0060, "CS", "OT");
+		data.String(0x0010, 0x0010, "PN", "Phantom");
+		data.String(0x0018, 0x0050, "DS", std::to_string(spacing[2]));
+		data.String(0x0020, 0x000D, "UI", studyUid);
+		data.String(0x0020, 0x000E, "UI", seriesUid);
+		data.String(0x0020, 0x0011, "IS", "1");
+		data.String(0x0020, 0x0013, "IS", std::to_string(iFile + 1));
+		data.String(0x0020, 0x0032, "DS", position.str());
+		data.String(0x0020, 0x0037, "DS", "1\\0\\0\\0\\1\\0");
+		data.UnsignedShort(0x0028, 0x0002, 1);
+		data.String(0x0028, 0x0004, "CS", "MONOCHROME2");
+		data.UnsignedShort(0x0028, 0x0010, static_cast<uint16_t>(dimensions[1]));
+		data.UnsignedShort(0x0028, 0x0011, static_cast<uint16_t>(dimensions[0]));
+		data.String(0x0028, 0x0030, "DS", pixelSpacing.str());
+		data.UnsignedShort(0x0028, 0x0100, static_cast<uint16_t>(bitsAllocated));
+		data.UnsignedShort(0x0028, 0x0101, static_cast<uint16_t>(bitsAllocated));
+		data.UnsignedShort(0x0028, 0x0102, static_cast<uint16_t>(bitsAllocated - 1));
+		data.UnsignedShort(0x0028, 0x0103, isSigned ? 1 : 0);
+		data.Binary(0x7FE0, 0x0010, (8 == bitsAllocated) ? "OB" : "OW",
+			volumeDataPtr + (static_cast<size_t>(z) * sliceBytes), sliceBytes);
+
+		char fileName[32];
+		snprintf(fileName, sizeof(fileName), "/slice%05d.dcm", iFile);
+
+		std::ofstream dicomFile(folder + fileName, std::ios::binary | std::ios::trunc);
+		const std::vector<char> preamble(128, '\0');
+		dicomFile.write(preamble.data(), preamble.size());
+		dicomFile.write("DICM", 4);
+
+		for (const DicomElementWriter *elements : { &metaLength, &meta, &data })
+		{
+			dicomFile.write(elements->GetBytes().data(), elements->GetBytes().size());
+		}
+
+		if (!dicomFile)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+std::string VolumePhantom::FramePath(
+	const std::string &path,
+	const int frame,
+	const int nFrames)
+{
+	if (nFrames <= 1)
+	{
+		return path;
+	}
+
+	char frameSuffix[16];
+	snprintf(frameSuffix, sizeof(frameSuffix), "_%03d", frame);
+
+	// before the extension of a file, .nii of a .nii.gz, at the end of a folder
+	size_t extensionPos = path.find_last_of('.');
+	const size_t namePos = path.find_last_of("/\\");
+
+	if (std::string::npos != extensionPos &&
+		0 == path.compare(extensionPos, std::string::npos, ".gz") &&
+		extensionPos > 0)
+	{
+		extensionPos = path.find_last_of('.', extensionPos - 1);
+	}
+
+	if (std::string::npos == extensionPos ||
+		(std::string::npos != namePos && extensionPos < namePos))
+	{
+		return path + frameSuffix;
+	}
+
+	return path.substr(0, extensionPos) + frameSuffix + path.substr(extensionPos);
+}
+
+
+bool VolumePhantom::Write(
+	vtkImageData *volumeImageData,
+	const VolumeFileFormat format,
+	const std::string &path,
+	const bool compressed)
+{
+	if (nullptr == volumeImageData->GetScalarPointer() ||
+		1 != volumeImageData->GetNumberOfScalarComponents())
+	{
+		return false;
+	}
+
+	switch (format)
+	{
+	case VolumeFileDicomFolder:
+		return WriteDicomSeries(volumeImageData, path);
+	case VolumeFileMhd:
+		return WriteMhd(volumeImageData, path, compressed);
+	case VolumeFileNrrd:
+		return WriteNrrd(volumeImageData, path, compressed);
+	case VolumeFileNifti:
+		return WriteNifti(volumeImageData, path, compressed);
+	default:
+		return false;
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "../VtkToUnityAPIDefines.h"
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+#include <string>
+
+
+/*
+ * Procedural test volumes, so loaders and renderers can be benchmarked at
+ * any size without patient data. The same arguments always give the same
+ * voxels. Values run from 0 to 255 for 8 bit scalars and 0 to 4095, as for
+ * 12 bit CT, for anything wider. Voxels are 1 mm cubes with the origin at
+ * zero, the volume is in the slice order the loaders produce.
+ */
+class VolumePhantom
+{
+public:
+	/*
+	 * frame and nFrames set the phase of VolumePhantomBeatingHeart, and the
+	 * seed of VolumePhantomNoise, the other phantoms are static. Returns
+	 * nullptr for an unknown type or a non-positive dimension.
+	 */
+	static vtkSmartPointer<vtkImageData> Generate(
+		const VolumePhantomType type,
+		const int *dimensions,
+		const int scalarType,
+		const int frame,
+		const int nFrames);
+
+	/*
+	 * Writes the volume as a MetaImage (.mhd with a .raw alongside), a
+	 * single file NRRD or NIfTI-1, or a DICOM series of one file per slice
+	 * in the folder path, such that loading it gives the same volume back.
+	 * DICOM is only written for 8 and 16 bit integer scalars. compressed
+	 * writes MetaImage data as a zlib .zraw, NRRD data gzip encoded and
+	 * NIfTI as a .nii.gz, DICOM is always uncompressed.
+	 */
+	static bool Write(
+		vtkImageData *volumeImageData,
+		const VolumeFileFormat format,
+		const std::string &path,
+		const bool compressed = false);
+
+	/*
+	 * The path to write a frame of a series to, with a _000 style suffix
+	 * before the extension, or after a folder name, that VolumeSeries sorts
+	 * back into order.
+	 */
+	static std::string FramePath(
+		const std::string &path,
+		const int frame,
+		const int nFrames);
+};
@@ -0,0 +1,171 @@
+#include "VolumePreview.h"
+
+#include "MappedFile.h"
+#include "ParallelDicomReader.h"
+#include "ParallelFor.h"
+#include "RawVolumeHeader.h"
+
+#include <algorithm>
+#include <string.h>
+
+
+static vtkSmartPointer<vtkImageData> ReadRawPreview(
+	const VolumeFileFormat format,
+	const std::string &path,
+	const int stride,
+	vtkSmartPointer<vtkImageData> &fullGeometry)
+{
+	RawVolumeLayout layout;
+
+	// a compressed stream cannot be sampled without inflating all of it
+	if (!RawVolumeHeader::Read(format, path, layout) ||
+		layout.compressed)
+	{
+		return nullptr;
+	}
+
+	std::shared_ptr<MappedFile> mappedFile = MappedFile::Open(layout.dataFile);
+	const size_t dataBytes = layout.GetDataBytes();
+
+	if (nullptr == mappedFile ||
+		mappedFile->GetSize() < dataBytes)
+	{
+		return nullptr;
+	}
+
+	const size_t dataOffset = (layout.dataOffset < 0)
+		? mappedFile->GetSize() - dataBytes
+		: static_cast<size_t>(layout.dataOffset);
+
+	if (dataOffset + dataBytes > mappedFile->GetSize())
+	{
+		return nullptr;
+	}
+
+	fullGeometry = vtkSmartPointer<vtkImageData>::New();
+	fullGeometry->SetDimensions(layout.dimensions.data());
+	fullGeometry->SetSpacing(layout.spacing.data());
+	fullGeometry->SetOrigin(layout.origin.data());
+
+	const std::array<int, 3> previewDimensions =
+		VolumePreview::PreviewDimensions(layout.dimensions.data(), stride);
+
+	auto previewImageData = vtkSmartPointer<vtkImageData>::New();
+	previewImageData->SetDimensions(previewDimensions.data());
+	previewImageData->AllocateScalars(layout.scalarType, layout.nComponents);
+
+	const size_t voxelBytes = dataBytes /
+		(static_cast<size_t>(layout.dimensions[0]) *
+		static_cast<size_t>(layout.dimensions[1]) *
+		static_cast<size_t>(layout.dimensions[2]));
+	const size_t sliceBytes =
+		static_cast<size_t>(layout.dimensions[0]) *
+		static_cast<size_t>(layout.dimensions[1]) *
+		voxelBytes;
+	const size_t previewSliceBytes =
+		static_cast<size_t>(previewDimensions[0]) *
+		static_cast<size_t>(previewDimensions[1]) *
+		voxelBytes;
+	const size_t nPreviewSlices = static_cast<size_t>(previewDimensions[2]);
+
+	const unsigned char *dataPtr = mappedFile->GetData() + dataOffset;
+	unsigned char *previewDataPtr =
+		static_cast<unsigned char*>(previewImageData->GetScalarPointer());
+
+	// only the pages of the sampled slices are read from disk
+	ParallelFor(nPreviewSlices, [&](const size_t iPreviewSlice)
+	{
+		VolumePreview::SubsampleSlice(
+			dataPtr + (iPreviewSlice * stride * sliceBytes),
+			layout.dimensions.data(),
+			voxelBytes,
+			stride,
+			previewDataPtr + ((nPreviewSlices - 1 - iPreviewSlice) * previewSliceBytes));
+	});
+
+	return previewImageData;
+}
+
+
+vtkSmartPointer<vtkImageData> VolumePreview::Read(
+	const VolumeFileFormat format,
+	const std::string &path,
+	const int stride,
+	vtkSmartPointer<vtkImageData> &fullGeometry)
+{
+	switch (format)
+	{
+	case VolumeFileDicomFolder:
+		return ParallelDicomReader::ReadPreview(path, stride, true, fullGeometry);
+	case VolumeFileMhd:
+	case VolumeFileNrrd:
+	case VolumeFileNifti:
+		return ReadRawPreview(format, path, stride, fullGeometry);
+	default:
+		return nullptr;
+	}
+}
+
+
+void VolumePreview::FitToGeometry(
+	vtkImageData *previewImageData,
+	vtkImageData *fullGeometry)
+{
+	std::array<int, 3> previewDimensions;
+	std::array<int, 3> fullDimensions;
+	std::array<double, 3> spacing;
+	previewImageData->GetDimensions(previewDimensions.data());
+	fullGeometry->GetDimensions(fullDimensions.data());
+	fullGeometry->GetSpacing(spacing.data());
+
+	// stretch the spacing so the last preview voxel lands on the last full one
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		if (previewDimensions[axis] > 1)
+		{
+			spacing[axis] *=
+				static_cast<double>(fullDimensions[axis] - 1) /
+				static_cast<double>(previewDimensions[axis] - 1);
+		}
+	}
+
+	previewImageData->SetSpacing(spacing.data());
+	previewImageData->SetOrigin(fullGeometry->GetOrigin());
+}
+
+
+std::array<int, 3> VolumePreview::PreviewDimensions(
+	const int *dimensions,
+	const int stride)
+{
+	std::array<int, 3> previewDimensions;
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		previewDimensions[axis] = ((std::max(dimensions[axis], 1) - 1) / stride) + 1;
+	}
+
+	return previewDimensions;
+}
+
+
+void VolumePreview::SubsampleSlice(
+	const unsigned char *slice,
+	const int *sliceDimensions,
+	const size_t voxelBytes,
+	const int stride,
+	unsigned char *previewSlice)
+{
+	const size_t rowBytes = static_cast<size_t>(sliceDimensions[0]) * voxelBytes;
+
+	for (int y = 0; y < sliceDimensions[1]; y += stride)
+	{
+		const unsigned char *row = slice + (static_cast<size_t>(y) * rowBytes);
+
+		for (int x = 0; x < sliceDimensions[0]; x += stride)
+		{
+			memcpy(previewSlice, row + (static_cast<size_t>(x) * voxelBytes), voxelBytes);
+			previewSlice += voxelBytes;
+		}
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "../VtkToUnityAPIDefines.h"
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+#include <array>
+#include <string>
+
+
+/*
+ * Quick, low resolution previews of a volume, taking every stride'th voxel
+ * along each axis, shown while the full volume loads. Only sources that can
+ * be read in part cheaply have a preview: DICOM series, where only the
+ * slices needed are decoded, and uncompressed MetaImage or NRRD data, which
+ * is sampled from a file mapping.
+ */
+class VolumePreview
+{
+public:
+	/*
+	 * Returns the preview, reversed along z, or nullptr if the source has no
+	 * cheap preview. fullGeometry is set to the dimensions, spacing and
+	 * origin of the full volume, without any scalars.
+	 */
+	static vtkSmartPointer<vtkImageData> Read(
+		const VolumeFileFormat format,
+		const std::string &path,
+		const int stride,
+		vtkSmartPointer<vtkImageData> &fullGeometry);
+
+	/*
+	 * Sets the preview's spacing and origin so that it covers the same
+	 * bounds as the full volume geometry.
+	 */
+	static void FitToGeometry(
+		vtkImageData *previewImageData,
+		vtkImageData *fullGeometry);
+
+	static std::array<int, 3> PreviewDimensions(
+		const int *dimensions,
+		const int stride);
+
+	/*
+	 * Copies every stride'th voxel of every stride'th row of the slice.
+	 */
+	static void SubsampleSlice(
+		const unsigned char *slice,
+		const int *sliceDimensions,
+		const size_t voxelBytes,
+		const int stride,
+		unsigned char *previewSlice);
+};
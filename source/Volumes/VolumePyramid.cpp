@@ -0,0 +1,219 @@
+#include "VolumePyramid.h"
+
+#include "ParallelFor.h"
+
+#include <vtkDataArray.h>
+#include <vtkPointData.h>
+#include <vtkType.h>
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <vector>
+
+
+template<typename ScalarType> static ScalarType FromMean(
+	const double sum,
+	const int count,
+	std::true_type)
+{
+	return static_cast<ScalarType>(std::floor((sum / count) + 0.5));
+}
+
+
+template<typename ScalarType> static ScalarType FromMean(
+	const double sum,
+	const int count,
+	std::false_type)
+{
+	return static_cast<ScalarType>(sum / count);
+}
+
+
+template<typename ScalarType> static void HalveScalars(
+	const ScalarType *volumeDataPtr,
+	const int *dimensions,
+	const int nComponents,
+	ScalarType *halvedDataPtr,
+	const int *halvedDimensions)
+{
+	const size_t rowValues = static_cast<size_t>(dimensions[0]) * nComponents;
+	const size_t sliceValues = rowValues * dimensions[1];
+	const size_t halvedRowValues = static_cast<size_t>(halvedDimensions[0]) * nComponents;
+	const size_t halvedSliceValues = halvedRowValues * halvedDimensions[1];
+
+	ParallelFor(static_cast<size_t>(halvedDimensions[2]), [&](const size_t hz)
+	{
+		std::vector<double> sums(halvedRowValues);
+		std::vector<int> counts(halvedDimensions[0]);
+
+		for (int hy = 0; hy < halvedDimensions[1]; ++hy)
+		{
+			std::fill(sums.begin(), sums.end(), 0.0);
+			std::fill(counts.begin(), counts.end(), 0);
+
+			// the up to 4 rows of the block, each read once from start to end
+			for (size_t z = 2 * hz; z < std::min<size_t>(2 * hz + 2, dimensions[2]); ++z)
+			{
+				for (int y = 2 * hy; y < std::min(2 * hy + 2, dimensions[1]); ++y)
+				{
+					const ScalarType *row = volumeDataPtr + (z * sliceValues) + (y * rowValues);
+
+					for (int x = 0; x < dimensions[0]; ++x)
+					{
+						const int hx = x / 2;
+						++counts[hx];
+
+						for (int c = 0; c < nComponents; ++c)
+						{
+							sums[(hx * nComponents) + c] += row[(x * nComponents) + c];
+						}
+					}
+				}
+			}
+
+			ScalarType *halvedRow = halvedDataPtr + (hz * halvedSliceValues) + (hy * halvedRowValues);
+
+			for (int hx = 0; hx < halvedDimensions[0]; ++hx)
+			{
+				for (int c = 0; c < nComponents; ++c)
+				{
+					halvedRow[(hx * nComponents) + c] = FromMean<ScalarType>(
+						sums[(hx * nComponents) + c], counts[hx], std::is_integral<ScalarType>());
+				}
+			}
+		}
+	});
+}
+
+
+VolumePyramid::VolumePyramid()
+	: mCancelled(false)
+{}
+
+
+void VolumePyramid::Build(
+	vtkImageData *volumeImageData)
+{
+	vtkSmartPointer<vtkImageData> levelAbove = volumeImageData;
+
+	for (int level = 1; level < sNLevels && !mCancelled; ++level)
+	{
+		vtkSmartPointer<vtkImageData> halved = Halve(levelAbove);
+
+		if (nullptr == halved)
+		{
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mLevels[level] = halved;
+		}
+
+		levelAbove = halved;
+	}
+}
+
+
+void VolumePyramid::Cancel()
+{
+	mCancelled = true;
+}
+
+
+vtkSmartPointer<vtkImageData> VolumePyramid::GetLevel(
+	const int level) const
+{
+	if (level < 1 || level >= sNLevels)
+	{
+		return nullptr;
+	}
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mLevels[level];
+}
+
+
+int VolumePyramid::GetNBuiltLevels() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	int nBuiltLevels(1);
+	while (nBuiltLevels < sNLevels && nullptr != mLevels[nBuiltLevels])
+	{
+		++nBuiltLevels;
+	}
+
+	return nBuiltLevels;
+}
+
+
+unsigned long long VolumePyramid::GetBytes() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	unsigned long long bytes(0);
+	for (int level = 1; level < sNLevels; ++level)
+	{
+		if (nullptr != mLevels[level])
+		{
+			bytes += static_cast<unsigned long long>(mLevels[level]->GetNumberOfPoints()) *
+				mLevels[level]->GetNumberOfScalarComponents() *
+				mLevels[level]->GetScalarSize();
+		}
+	}
+
+	return bytes;
+}
+
+
+vtkSmartPointer<vtkImageData> VolumePyramid::Halve(
+	vtkImageData *volumeImageData)
+{
+	vtkDataArray *scalars = volumeImageData->GetPointData()->GetScalars();
+
+	if (nullptr == scalars)
+	{
+		return nullptr;
+	}
+
+	std::array<int, 3> dimensions;
+	std::array<int, 3> halvedDimensions;
+	std::array<double, 3> spacing;
+	std::array<double, 3> origin;
+	volumeImageData->GetDimensions(dimensions.data());
+	volumeImageData->GetSpacing(spacing.data());
+	volumeImageData->GetOrigin(origin.data());
+
+	// a voxel sits at the centre of the block it replaces
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		halvedDimensions[axis] = (dimensions[axis] + 1) / 2;
+		origin[axis] += 0.5 * spacing[axis];
+		spacing[axis] *= 2.0;
+	}
+
+	auto halvedImageData = vtkSmartPointer<vtkImageData>::New();
+	halvedImageData->SetDimensions(halvedDimensions.data());
+	halvedImageData->SetSpacing(spacing.data());
+	halvedImageData->SetOrigin(origin.data());
+	halvedImageData->AllocateScalars(scalars->GetDataType(), scalars->GetNumberOfComponents());
+
+	void *volumeDataPtr = scalars->GetVoidPointer(0);
+	void *halvedDataPtr = halvedImageData->GetScalarPointer();
+
+	switch (scalars->GetDataType())
+	{
+		vtkTemplateMacro(HalveScalars(
+			static_cast<const VTK_TT*>(volumeDataPtr),
+			dimensions.data(),
+			scalars->GetNumberOfComponents(),
+			static_cast<VTK_TT*>(halvedDataPtr),
+			halvedDimensions.data()));
+	default:
+		return nullptr;
+	}
+
+	return halvedImageData;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+#include <array>
+#include <atomic>
+#include <mutex>
+
+
+/*
+ * Downsampled copies of a volume, each level halving the one before along
+ * every axis, for views that do not need the full resolution. Level 0 is
+ * the volume itself and is not held here. A level covers the same region
+ * as the volume, its voxels being the means of 2x2x2 blocks of the level
+ * above, so a level can stand in for the volume in any mapper or reslice.
+ * Levels are built in the background and may be read while that happens.
+ */
+class VolumePyramid
+{
+public:
+	// the volume and its 2x, 4x and 8x downsampled levels
+	static const int sNLevels = 4;
+
+	VolumePyramid();
+
+	/*
+	 * Builds every level in turn from the volume, publishing each as it is
+	 * done. Stops early once cancelled.
+	 */
+	void Build(
+		vtkImageData *volumeImageData);
+
+	void Cancel();
+
+	/*
+	 * Level 1 to sNLevels - 1, nullptr until it has been built.
+	 */
+	vtkSmartPointer<vtkImageData> GetLevel(
+		const int level) const;
+
+	int GetNBuiltLevels() const;
+
+	unsigned long long GetBytes() const;
+
+	/*
+	 * Halves the volume along every axis, rounding odd dimensions up, each
+	 * voxel the mean of the (up to) 8 it replaces. Slices are averaged in
+	 * parallel, a row at a time from 4 rows of the volume.
+	 */
+	static vtkSmartPointer<vtkImageData> Halve(
+		vtkImageData *volumeImageData);
+
+private:
+	VolumePyramid(const VolumePyramid&) = delete;
+	VolumePyramid& operator=(const VolumePyramid&) = delete;
+
+	mutable std::mutex mMutex;
+	std::array<vtkSmartPointer<vtkImageData>, sNLevels> mLevels;
+	std::atomic<bool> mCancelled;
+};
@@ -0,0 +1,163 @@
+#include "VolumeQualityController.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+// weight of the latest render in the smoothed time
+static const double sFrameTimeSmoothing(0.3);
+// renders after a change before the next is judged, as the time catches up with it
+static const int sSettleFrames(3);
+// the time is under the target by this fraction for sRefineFrames before refining
+static const double sRefineMargin(0.25);
+static const int sRefineFrames(30);
+static const double sRefineStep(1.15);
+// coarsening aims this fraction under the target, so noise does not take it straight back over
+static const double sCoarsenHeadroom(0.1);
+// a single coarsening, however far over the target
+static const double sMaxCoarsenStep(2.0);
+
+
+VolumeQualityController::VolumeQualityController()
+	: mTargetFrameTime(1.0 / 90.0)
+	, mMinSampleDistanceScale(1.0)
+	, mMaxSampleDistanceScale(4.0)
+	, mMinImageSampleDistance(1.0)
+	, mMaxImageSampleDistance(3.0)
+{
+	Reset();
+}
+
+
+void VolumeQualityController::SetTargetFrameTime(
+	const double targetSeconds)
+{
+	if (targetSeconds > 0.0)
+	{
+		mTargetFrameTime = targetSeconds;
+	}
+}
+
+
+double VolumeQualityController::GetTargetFrameTime() const
+{
+	return mTargetFrameTime;
+}
+
+
+void VolumeQualityController::SetBounds(
+	const double minSampleDistanceScale,
+	const double maxSampleDistanceScale,
+	const double minImageSampleDistance,
+	const double maxImageSampleDistance)
+{
+	mMinSampleDistanceScale = std::max(1.0, minSampleDistanceScale);
+	mMaxSampleDistanceScale = std::max(mMinSampleDistanceScale, maxSampleDistanceScale);
+	mMinImageSampleDistance = std::max(1.0, minImageSampleDistance);
+	mMaxImageSampleDistance = std::max(mMinImageSampleDistance, maxImageSampleDistance);
+
+	UpdateSampleDistances();
+}
+
+
+bool VolumeQualityController::AddFrameTime(
+	const double frameSeconds)
+{
+	mSmoothedFrameTime = (mSmoothedFrameTime < 0.0)
+		? frameSeconds
+		: mSmoothedFrameTime + (sFrameTimeSmoothing * (frameSeconds - mSmoothedFrameTime));
+
+	if (mSettleFrames > 0)
+	{
+		--mSettleFrames;
+		return false;
+	}
+
+	const double maxCostReduction = (mMaxSampleDistanceScale / mMinSampleDistanceScale) *
+		std::pow(mMaxImageSampleDistance / mMinImageSampleDistance, 2.0);
+	double costReduction = mCostReduction;
+
+	if (mSmoothedFrameTime > mTargetFrameTime)
+	{
+		// over the target, give up as much as it is over by at once
+		mUnderTargetFrames = 0;
+		costReduction *= std::min(sMaxCoarsenStep,
+			mSmoothedFrameTime / ((1.0 - sCoarsenHeadroom) * mTargetFrameTime));
+	}
+	else if (mSmoothedFrameTime < (1.0 - sRefineMargin) * mTargetFrameTime)
+	{
+		if (++mUnderTargetFrames < sRefineFrames)
+		{
+			return false;
+		}
+
+		mUnderTargetFrames = 0;
+		costReduction /= sRefineStep;
+	}
+	else
+	{
+		// within the band, hold
+		mUnderTargetFrames = 0;
+		return false;
+	}
+
+	costReduction = std::min(maxCostReduction, std::max(1.0, costReduction));
+	if (costReduction == mCostReduction)
+	{
+		return false;
+	}
+
+	// the time measured from here is expected to scale with the cost
+	mSmoothedFrameTime *= mCostReduction / costReduction;
+	mCostReduction = costReduction;
+	mSettleFrames = sSettleFrames;
+
+	const double sampleDistanceScale = mSampleDistanceScale;
+	const double imageSampleDistance = mImageSampleDistance;
+	UpdateSampleDistances();
+
+	return (sampleDistanceScale != mSampleDistanceScale ||
+		imageSampleDistance != mImageSampleDistance);
+}
+
+
+void VolumeQualityController::Reset()
+{
+	mCostReduction = 1.0;
+	mSmoothedFrameTime = -1.0;
+	mSettleFrames = 0;
+	mUnderTargetFrames = 0;
+
+	UpdateSampleDistances();
+}
+
+
+double VolumeQualityController::GetSampleDistanceScale() const
+{
+	return mSampleDistanceScale;
+}
+
+
+double VolumeQualityController::GetImageSampleDistance() const
+{
+	return mImageSampleDistance;
+}
+
+
+double VolumeQualityController::GetSmoothedFrameTime() const
+{
+	return std::max(0.0, mSmoothedFrameTime);
+}
+
+
+void VolumeQualityController::UpdateSampleDistances()
+{
+	// the ray samples go first, fewer pixels show more
+	mSampleDistanceScale = std::min(mMaxSampleDistanceScale,
+		mMinSampleDistanceScale * mCostReduction);
+
+	const double imageCostReduction = mCostReduction *
+		(mMinSampleDistanceScale / mSampleDistanceScale);
+	mImageSampleDistance = std::min(mMaxImageSampleDistance,
+		mMinImageSampleDistance * std::sqrt(imageCostReduction));
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+
+/*
+ * Holds the volume render time at a target by trading sample quality for it,
+ * fed the measured time of each render. The quality given up is a single cost
+ * reduction, taken first from the ray sample distance, as a scale of each
+ * mapper's own, then from the image sample distance, which costs its square.
+ * It coarsens as soon as the smoothed time goes over the target, by the amount
+ * it is over, and refines in small steps only once the time has stayed well
+ * under the target for a while, so it settles rather than oscillating.
+ */
+class VolumeQualityController
+{
+public:
+	VolumeQualityController();
+
+	void SetTargetFrameTime(
+		const double targetSeconds);
+	double GetTargetFrameTime() const;
+
+	/*
+	 * Bounds of the sample distance scale and image sample distance, both at
+	 * least 1, the controller starts at, and refines back to, the minimums.
+	 */
+	void SetBounds(
+		const double minSampleDistanceScale,
+		const double maxSampleDistanceScale,
+		const double minImageSampleDistance,
+		const double maxImageSampleDistance);
+
+	/*
+	 * Takes the time of a render, returns whether the sample distances changed.
+	 */
+	bool AddFrameTime(
+		const double frameSeconds);
+
+	/*
+	 * Back to the best quality, forgetting the times seen.
+	 */
+	void Reset();
+
+	double GetSampleDistanceScale() const;
+	double GetImageSampleDistance() const;
+	double GetSmoothedFrameTime() const;
+
+private:
+	// Splits the cost reduction between the two distances, within their bounds
+	void UpdateSampleDistances();
+
+	double mTargetFrameTime;
+	double mMinSampleDistanceScale;
+	double mMaxSampleDistanceScale;
+	double mMinImageSampleDistance;
+	double mMaxImageSampleDistance;
+
+	double mCostReduction;
+	double mSampleDistanceScale;
+	double mImageSampleDistance;
+
+	double mSmoothedFrameTime;
+	int mSettleFrames;
+	int mUnderTargetFrames;
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "../VtkToUnityAPIDefines.h"
+#include "PackedVolumeMask.h"
+#include "VolumeBricks.h"
+#include "VolumeOctree.h"
+#include "VolumePyramid.h"
+#include "VolumeStatistics.h"
+
+#include <vtkType.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+
+/*
+ * What the plugin keeps about each loaded volume besides its voxels, kept in
+ * step with the volume data vector.
+ */
+struct VolumeRecord
+{
+	VolumeRecord()
+		: reversePending(false)
+		, rescaleSlope(1.0)
+		, rescaleIntercept(0.0)
+		, sourceFormat(NVolumeFileFormat)
+		, narrowScalarType(VTK_VOID)
+		, lastShown(0)
+		, evicted(false)
+		, evictedScalarType(VTK_VOID)
+		, evictedComponents(0)
+		, contentHash(0)
+	{}
+
+	// The scalars are still in file slice order, they are reversed along z
+	// the first time the volume is shown
+	bool reversePending;
+
+	// A stored scalar s stands for (s * rescaleSlope) + rescaleIntercept in the
+	// units of the source, see ScalarNarrowing
+	double rescaleSlope;
+	double rescaleIntercept;
+
+	// Where the volume was read from, NVolumeFileFormat if it has no source
+	// to be read again from, and the type it was narrowed to if any
+	VolumeFileFormat sourceFormat;
+	std::string sourcePath;
+	int narrowScalarType;
+
+	// When the volume was last shown, for evicting the least recently shown
+	unsigned long long lastShown;
+
+	// The scalars have been dropped to fit the memory budget, they are read
+	// back from the source, or from spillPath, when the volume is shown
+	bool evicted;
+	std::string spillPath;
+	int evictedScalarType;
+	int evictedComponents;
+
+	// Set once CreatePaddingMask has been called, kept when the volume is evicted
+	std::shared_ptr<PackedVolumeMask> paddingMask;
+
+	// Built when the volume is first shown or masked, dropped with its scalars
+	std::shared_ptr<VolumeBricks> bricks;
+	std::shared_ptr<VolumeOctree> octree;
+
+	// The VolumeHash of the voxels as first added, 0 if they were not hashed,
+	// as for previews, which are refined in place and so never shared. Volumes
+	// with the same hash and voxels share one vtkImageData, and everything
+	// above bar the source is kept the same for all of them
+	uint64_t contentHash;
+
+	// The downsampled levels, built in the background once the volume is in
+	// display order, and dropped with its scalars when it is evicted
+	std::shared_ptr<VolumePyramid> pyramid;
+
+	// Computed when first asked for, of all voxels and of those the padding
+	// mask keeps, kept when the volume is evicted as its voxels come back the same
+	std::shared_ptr<VolumeStatistics> statistics;
+	std::shared_ptr<VolumeStatistics> maskedStatistics;
+};
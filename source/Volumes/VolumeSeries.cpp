@@ -0,0 +1,78 @@
+#include "VolumeSeries.h"
+
+#include <vtksys/Glob.hxx>
+
+#include <algorithm>
+#include <ctype.h>
+
+
+// Compares runs of digits by their value and everything else by character
+static bool NaturalLess(
+	const std::string &a,
+	const std::string &b)
+{
+	size_t iA = 0;
+	size_t iB = 0;
+
+	while (iA < a.size() && iB < b.size())
+	{
+		if (isdigit(static_cast<unsigned char>(a[iA])) &&
+			isdigit(static_cast<unsigned char>(b[iB])))
+		{
+			const size_t startA = iA;
+			const size_t startB = iB;
+
+			while (iA < a.size() && isdigit(static_cast<unsigned char>(a[iA]))) ++iA;
+			while (iB < b.size() && isdigit(static_cast<unsigned char>(b[iB]))) ++iB;
+
+			// ignore leading zeros, then the longer run is the larger number
+			const std::string numberA = a.substr(startA, iA - startA);
+			const std::string numberB = b.substr(startB, iB - startB);
+			const size_t firstA = std::min(numberA.find_first_not_of('0'), numberA.size());
+			const size_t firstB = std::min(numberB.find_first_not_of('0'), numberB.size());
+			const size_t lengthA = numberA.size() - firstA;
+			const size_t lengthB = numberB.size() - firstB;
+
+			if (lengthA != lengthB)
+			{
+				return lengthA < lengthB;
+			}
+
+			const int compare = numberA.compare(firstA, lengthA, numberB, firstB, lengthB);
+			if (0 != compare)
+			{
+				return compare < 0;
+			}
+
+			continue;
+		}
+
+		if (a[iA] != b[iB])
+		{
+			return a[iA] < b[iB];
+		}
+
+		++iA;
+		++iB;
+	}
+
+	return (a.size() - iA) < (b.size() - iB);
+}
+
+
+std::vector<std::string> VolumeSeries::FindFrames(
+	const std::string &pattern)
+{
+	vtksys::Glob glob;
+	glob.RecurseOff();
+
+	if (!glob.FindFiles(pattern))
+	{
+		return std::vector<std::string>();
+	}
+
+	std::vector<std::string> paths = glob.GetFiles();
+	std::sort(paths.begin(), paths.end(), NaturalLess);
+
+	return paths;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+
+class VolumeSeries
+{
+public:
+	/*
+	 * The files or folders matching a wildcard pattern, e.g.
+	 * "C:/Study/frame_*.mhd", in frame order. Numbers in the names are
+	 * compared by value, so frame_10 comes after frame_9.
+	 */
+	static std::vector<std::string> FindFrames(
+		const std::string &pattern);
+};
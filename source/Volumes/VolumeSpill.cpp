@@ -0,0 +1,99 @@
+#include "VolumeSpill.h"
+
+#include <vtksys/SystemTools.hxx>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+
+
+static const std::string sSpillExtension(".vtuspill");
+
+
+// Unique within the process, the start time keeps concurrent sessions apart
+static std::string NewSpillPath(
+	const std::string &spillFolder)
+{
+	static const long long sSessionTime =
+		std::chrono::system_clock::now().time_since_epoch().count();
+	static std::atomic<unsigned int> sNextSpill(0);
+
+	char spillName[64];
+	snprintf(spillName, sizeof(spillName), "spill-%llx-%u",
+		static_cast<unsigned long long>(sSessionTime), sNextSpill++);
+
+	return spillFolder + "/" + spillName + sSpillExtension;
+}
+
+
+std::string VolumeSpill::Write(
+	const std::string &spillFolder,
+	vtkDataArray *scalars)
+{
+	if (nullptr == scalars ||
+		!vtksys::SystemTools::MakeDirectory(spillFolder))
+	{
+		return std::string();
+	}
+
+	const std::string spillPath = NewSpillPath(spillFolder);
+	const std::streamsize spillBytes = static_cast<std::streamsize>(
+		scalars->GetNumberOfValues() * scalars->GetDataTypeSize());
+
+	{
+		std::ofstream spillFile(spillPath, std::ios::binary | std::ios::trunc);
+		spillFile.write(static_cast<const char*>(scalars->GetVoidPointer(0)), spillBytes);
+
+		if (spillFile)
+		{
+			return spillPath;
+		}
+	}
+
+	vtksys::SystemTools::RemoveFile(spillPath);
+	return std::string();
+}
+
+
+vtkSmartPointer<vtkDataArray> VolumeSpill::Read(
+	const std::string &spillPath,
+	const int scalarType,
+	const int nComponents,
+	const vtkIdType nTuples)
+{
+	vtkSmartPointer<vtkDataArray> scalars =
+		vtkSmartPointer<vtkDataArray>::Take(vtkDataArray::CreateDataArray(scalarType));
+
+	if (nullptr == scalars)
+	{
+		return nullptr;
+	}
+
+	scalars->SetNumberOfComponents(nComponents);
+	scalars->SetNumberOfTuples(nTuples);
+
+	const std::streamsize spillBytes = static_cast<std::streamsize>(
+		scalars->GetNumberOfValues() * scalars->GetDataTypeSize());
+
+	{
+		std::ifstream spillFile(spillPath, std::ios::binary);
+		spillFile.read(static_cast<char*>(scalars->GetVoidPointer(0)), spillBytes);
+
+		if (!spillFile ||
+			spillFile.gcount() != spillBytes)
+		{
+			return nullptr;
+		}
+	}
+
+	vtksys::SystemTools::RemoveFile(spillPath);
+	return scalars;
+}
+
+
+void VolumeSpill::Remove(
+	const std::string &spillPath)
+{
+	vtksys::SystemTools::RemoveFile(spillPath);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vtkDataArray.h>
+#include <vtkSmartPointer.h>
+
+#include <string>
+
+
+/*
+ * Raw scalar files for volumes evicted from memory that have no source to
+ * be read again from, such as previews. The file holds only the scalar
+ * bytes, the caller keeps their type and size.
+ */
+class VolumeSpill
+{
+public:
+	/*
+	 * Returns the path of the new spill file in the folder, or an empty
+	 * string if it could not be written.
+	 */
+	static std::string Write(
+		const std::string &spillFolder,
+		vtkDataArray *scalars);
+
+	/*
+	 * Reads the scalars back and removes the file. Returns nullptr if the
+	 * file does not hold that many values.
+	 */
+	static vtkSmartPointer<vtkDataArray> Read(
+		const std::string &spillPath,
+		const int scalarType,
+		const int nComponents,
+		const vtkIdType nTuples);
+
+	static void Remove(
+		const std::string &spillPath);
+};
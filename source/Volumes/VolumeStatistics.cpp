@@ -0,0 +1,295 @@
+#include "VolumeStatistics.h"
+
+#include "ParallelFor.h"
+
+#include <vtkDataArray.h>
+#include <vtkPointData.h>
+#include <vtkType.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+
+// in percent, in the order of VolumeStatistic, symmetric so a negative slope only reverses them
+static const double sPercentiles[] = { 1.0, 2.0, 5.0, 25.0, 50.0, 75.0, 95.0, 98.0, 99.0 };
+
+static const size_t sFineBins(65536);
+static const size_t sBitsPerWord(64);
+
+
+// Calls functor(value) for the first component of each voxel in [voxelBegin,
+// voxelEnd), which start on a mask word, that the mask keeps
+template<typename ScalarType, typename Functor> static void ForEachKeptValue(
+	const ScalarType *volumeDataPtr,
+	const size_t nComponents,
+	const size_t voxelBegin,
+	const size_t voxelEnd,
+	const uint64_t *bits,
+	Functor functor)
+{
+	if (nullptr == bits)
+	{
+		for (size_t voxel = voxelBegin; voxel < voxelEnd; ++voxel)
+		{
+			functor(volumeDataPtr[voxel * nComponents]);
+		}
+		return;
+	}
+
+	for (size_t wordBegin = voxelBegin; wordBegin < voxelEnd; wordBegin += sBitsPerWord)
+	{
+		const uint64_t word = bits[wordBegin / sBitsPerWord];
+
+		// padding is mostly in whole words
+		if (0 == word)
+		{
+			continue;
+		}
+
+		const size_t nWordVoxels = std::min(sBitsPerWord, voxelEnd - wordBegin);
+		for (size_t iBit = 0; iBit < nWordVoxels; ++iBit)
+		{
+			if (0 != ((word >> iBit) & 1))
+			{
+				functor(volumeDataPtr[(wordBegin + iBit) * nComponents]);
+			}
+		}
+	}
+}
+
+
+template<typename ScalarType> static void AccumulateStatistics(
+	const ScalarType *volumeDataPtr,
+	const size_t nComponents,
+	const size_t nVoxels,
+	const uint64_t *bits,
+	const size_t nBins,
+	uint64_t &nCounted,
+	double &minValue,
+	double &maxValue,
+	double &mean,
+	double &stdDev,
+	double *percentiles,
+	std::vector<uint64_t> &histogram)
+{
+	// contiguous runs of whole mask words, one per thread, each with its own sums and histograms
+	const size_t nChunks = ParallelThreadCount();
+	const size_t chunkWords = (((nVoxels + sBitsPerWord - 1) / sBitsPerWord) + nChunks - 1) / nChunks;
+	auto chunkBegin = [&](const size_t iChunk) { return std::min(nVoxels, iChunk * chunkWords * sBitsPerWord); };
+
+	std::vector<uint64_t> chunkCounts(nChunks, 0);
+	std::vector<ScalarType> chunkMins(nChunks, std::numeric_limits<ScalarType>::max());
+	std::vector<ScalarType> chunkMaxs(nChunks, std::numeric_limits<ScalarType>::lowest());
+	std::vector<double> chunkSums(nChunks, 0.0);
+
+	ParallelFor(nChunks, [&](const size_t iChunk)
+	{
+		uint64_t count(0);
+		ScalarType lo = chunkMins[iChunk];
+		ScalarType hi = chunkMaxs[iChunk];
+		double sum(0.0);
+
+		ForEachKeptValue(volumeDataPtr, nComponents, chunkBegin(iChunk), chunkBegin(iChunk + 1), bits,
+			[&](const ScalarType value)
+		{
+			++count;
+			lo = std::min(lo, value);
+			hi = std::max(hi, value);
+			sum += static_cast<double>(value);
+		});
+
+		chunkCounts[iChunk] = count;
+		chunkMins[iChunk] = lo;
+		chunkMaxs[iChunk] = hi;
+		chunkSums[iChunk] = sum;
+	});
+
+	nCounted = 0;
+	double sum(0.0);
+	for (size_t iChunk = 0; iChunk < nChunks; ++iChunk)
+	{
+		nCounted += chunkCounts[iChunk];
+		sum += chunkSums[iChunk];
+	}
+
+	histogram.assign(nBins, 0);
+	if (0 == nCounted)
+	{
+		return;
+	}
+
+	minValue = static_cast<double>(*std::min_element(chunkMins.begin(), chunkMins.end()));
+	maxValue = static_cast<double>(*std::max_element(chunkMaxs.begin(), chunkMaxs.end()));
+	mean = sum / static_cast<double>(nCounted);
+
+	// integers with few enough values get a fine bin each, so their percentiles are exact
+	const double range = maxValue - minValue;
+	const bool exactBins = std::is_integral<ScalarType>::value && (range < sFineBins);
+	const size_t nFineBins = exactBins ? static_cast<size_t>(range) + 1 : sFineBins;
+	const double fineScale = exactBins ? 1.0 : ((range > 0.0) ? (sFineBins / range) : 0.0);
+	const double binScale = (range > 0.0) ? (nBins / range) : 0.0;
+
+	std::vector<std::vector<uint64_t>> chunkFineHistograms(nChunks);
+	std::vector<std::vector<uint64_t>> chunkHistograms(nChunks);
+	std::vector<double> chunkSquares(nChunks, 0.0);
+
+	ParallelFor(nChunks, [&](const size_t iChunk)
+	{
+		std::vector<uint64_t> fineHistogram(nFineBins, 0);
+		std::vector<uint64_t> chunkHistogram(nBins, 0);
+		double squares(0.0);
+
+		ForEachKeptValue(volumeDataPtr, nComponents, chunkBegin(iChunk), chunkBegin(iChunk + 1), bits,
+			[&](const ScalarType value)
+		{
+			const double offset = static_cast<double>(value) - minValue;
+			squares += (static_cast<double>(value) - mean) * (static_cast<double>(value) - mean);
+			++fineHistogram[std::min(nFineBins - 1, static_cast<size_t>(offset * fineScale))];
+			++chunkHistogram[std::min(nBins - 1, static_cast<size_t>(offset * binScale))];
+		});
+
+		chunkFineHistograms[iChunk].swap(fineHistogram);
+		chunkHistograms[iChunk].swap(chunkHistogram);
+		chunkSquares[iChunk] = squares;
+	});
+
+	std::vector<uint64_t> fineHistogram(nFineBins, 0);
+	double squares(0.0);
+	for (size_t iChunk = 0; iChunk < nChunks; ++iChunk)
+	{
+		for (size_t iBin = 0; iBin < nFineBins; ++iBin)
+		{
+			fineHistogram[iBin] += chunkFineHistograms[iChunk][iBin];
+		}
+
+		for (size_t iBin = 0; iBin < nBins; ++iBin)
+		{
+			histogram[iBin] += chunkHistograms[iChunk][iBin];
+		}
+
+		squares += chunkSquares[iChunk];
+	}
+
+	stdDev = std::sqrt(squares / static_cast<double>(nCounted));
+
+	// the value of rank p% of the way from the lowest to the highest voxel
+	size_t iBin(0);
+	uint64_t below(0);
+	for (size_t iPercentile = 0; iPercentile < (sizeof(sPercentiles) / sizeof(sPercentiles[0])); ++iPercentile)
+	{
+		const double rank = (sPercentiles[iPercentile] / 100.0) * static_cast<double>(nCounted - 1);
+
+		while (iBin + 1 < nFineBins &&
+			static_cast<double>(below + fineHistogram[iBin]) <= rank)
+		{
+			below += fineHistogram[iBin];
+			++iBin;
+		}
+
+		if (exactBins)
+		{
+			percentiles[iPercentile] = minValue + static_cast<double>(iBin);
+		}
+		else
+		{
+			const double withinBin = (0 != fineHistogram[iBin])
+				? ((rank - static_cast<double>(below) + 0.5) / static_cast<double>(fineHistogram[iBin]))
+				: 0.0;
+			percentiles[iPercentile] = (fineScale > 0.0)
+				? std::min(maxValue, minValue + ((static_cast<double>(iBin) + withinBin) / fineScale))
+				: minValue;
+		}
+	}
+}
+
+
+std::shared_ptr<VolumeStatistics> VolumeStatistics::Compute(
+	vtkImageData *volumeImageData,
+	const PackedVolumeMask *mask,
+	const int nBins)
+{
+	vtkDataArray *scalars = volumeImageData->GetPointData()->GetScalars();
+
+	if (nullptr == scalars ||
+		nBins < 1)
+	{
+		return nullptr;
+	}
+
+	const size_t nVoxels = static_cast<size_t>(scalars->GetNumberOfTuples());
+	if (nullptr != mask &&
+		mask->GetNVoxels() != nVoxels)
+	{
+		return nullptr;
+	}
+
+	std::shared_ptr<VolumeStatistics> statistics(new VolumeStatistics());
+	statistics->mMasked = (nullptr != mask);
+	statistics->mPercentiles.fill(0.0);
+
+	void *volumeDataPtr = scalars->GetVoidPointer(0);
+
+	switch (scalars->GetDataType())
+	{
+		vtkTemplateMacro(AccumulateStatistics(
+			static_cast<const VTK_TT*>(volumeDataPtr),
+			static_cast<size_t>(scalars->GetNumberOfComponents()),
+			nVoxels,
+			(nullptr != mask) ? mask->GetBits().data() : nullptr,
+			static_cast<size_t>(nBins),
+			statistics->mNVoxels,
+			statistics->mMin,
+			statistics->mMax,
+			statistics->mMean,
+			statistics->mStdDev,
+			statistics->mPercentiles.data(),
+			statistics->mHistogram));
+	default:
+		return nullptr;
+	}
+
+	return statistics;
+}
+
+
+int VolumeStatistics::GetNBins() const
+{
+	return static_cast<int>(mHistogram.size());
+}
+
+
+bool VolumeStatistics::IsMasked() const
+{
+	return mMasked;
+}
+
+
+void VolumeStatistics::Fill(
+	const double slope,
+	const double intercept,
+	double *statistics,
+	double *histogram) const
+{
+	// a negative slope reverses the order of the values
+	const bool reversed = (slope < 0.0);
+	const size_t nPercentiles = mPercentiles.size();
+
+	statistics[VolumeStatisticNVoxels] = static_cast<double>(mNVoxels);
+	statistics[VolumeStatisticMin] = ((reversed ? mMax : mMin) * slope) + intercept;
+	statistics[VolumeStatisticMax] = ((reversed ? mMin : mMax) * slope) + intercept;
+	statistics[VolumeStatisticMean] = (mMean * slope) + intercept;
+	statistics[VolumeStatisticStdDev] = mStdDev * std::abs(slope);
+
+	for (size_t iPercentile = 0; iPercentile < nPercentiles; ++iPercentile)
+	{
+		const double percentile = mPercentiles[reversed ? (nPercentiles - 1 - iPercentile) : iPercentile];
+		statistics[VolumeStatisticPercentile1 + iPercentile] = (percentile * slope) + intercept;
+	}
+
+	for (size_t iBin = 0; iBin < mHistogram.size(); ++iBin)
+	{
+		histogram[iBin] = static_cast<double>(mHistogram[reversed ? (mHistogram.size() - 1 - iBin) : iBin]);
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "../VtkToUnityAPIDefines.h"
+#include "PackedVolumeMask.h"
+
+#include <vtkImageData.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+
+/*
+ * Intensity statistics of a volume's first component, in stored scalar
+ * units: the range, mean and standard deviation, the percentiles of
+ * VolumeStatistic and a histogram of evenly sized bins over the range.
+ * Computed in two parallel passes, the second binning each voxel into the
+ * histogram and a fine one the percentiles are read from. The fine histogram
+ * has a bin per value for integer scalars spanning up to 65536 values, so
+ * their percentiles are exact; otherwise they are interpolated within a bin
+ * of 1/65536 of the range.
+ */
+class VolumeStatistics
+{
+public:
+	/*
+	 * Only the voxels the mask keeps are counted, if one is given. Returns
+	 * nullptr if the volume has no scalars.
+	 */
+	static std::shared_ptr<VolumeStatistics> Compute(
+		vtkImageData *volumeImageData,
+		const PackedVolumeMask *mask,
+		const int nBins);
+
+	int GetNBins() const;
+	bool IsMasked() const;
+
+	/*
+	 * Fills statistics, NVolumeStatistic values, and histogram, GetNBins
+	 * counts, with stored values s taken to (s * slope) + intercept. The
+	 * histogram runs from the filled min to max, empty if no voxel counted.
+	 */
+	void Fill(
+		const double slope,
+		const double intercept,
+		double *statistics,
+		double *histogram) const;
+
+private:
+	VolumeStatistics() = default;
+
+	bool mMasked = false;
+	uint64_t mNVoxels = 0;
+	double mMin = 0.0;
+	double mMax = 0.0;
+	double mMean = 0.0;
+	double mStdDev = 0.0;
+	std::array<double, NVolumeStatistic - VolumeStatisticPercentile1> mPercentiles;
+	std::vector<uint64_t> mHistogram;
+};
@@ -0,0 +1,70 @@
+#include "WorkerPool.h"
+
+#include <algorithm>
+
+
+WorkerPool::WorkerPool(
+	const unsigned int nThreads)
+	: mStopping(false)
+{
+	const unsigned int nPoolThreads = std::max(1u, nThreads);
+	mThreads.reserve(nPoolThreads);
+
+	for (unsigned int t = 0; t < nPoolThreads; ++t)
+	{
+		mThreads.emplace_back(&WorkerPool::Run, this);
+	}
+}
+
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStopping = true;
+		mTasks.clear();
+	}
+
+	mCondition.notify_all();
+
+	for (auto &thread : mThreads)
+	{
+		thread.join();
+	}
+}
+
+
+void WorkerPool::Enqueue(
+	Task task)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mTasks.push_back(std::move(task));
+	}
+
+	mCondition.notify_one();
+}
+
+
+void WorkerPool::Run()
+{
+	for (;;)
+	{
+		Task task;
+
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mCondition.wait(lock, [this]() { return mStopping || !mTasks.empty(); });
+
+			if (mStopping)
+			{
+				return;
+			}
+
+			task = std::move(mTasks.front());
+			mTasks.pop_front();
+		}
+
+		task();
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/*
+ * A fixed set of background threads running queued tasks in order. Used for
+ * work that must not block the Unity main or render threads, such as volume
+ * loading. Tasks still queued when the pool is destroyed are dropped, the
+ * ones already running are waited for.
+ */
+class WorkerPool
+{
+public:
+	typedef std::function<void()> Task;
+
+	explicit WorkerPool(
+		const unsigned int nThreads);
+	~WorkerPool();
+
+	void Enqueue(
+		Task task);
+
+private:
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	void Run();
+
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+	std::deque<Task> mTasks;
+	std::vector<std::thread> mThreads;
+	bool mStopping;
+};
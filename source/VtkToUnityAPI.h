@@ -35,6 +35,110 @@ public:
 	virtual bool LoadDicomVolumeFromFolder(const std::string &folder) = 0;
 	virtual bool LoadUncMetaImage(const std::string &mhdPath) = 0;
 	virtual bool LoadNrrdImage(const std::string &nrrdPath) = 0;
+	virtual bool LoadNiftiImage(const std::string &niftiPath) = 0;
+
+	// Adds a volume whose voxels are already in memory. With a release function
+	// the buffer is used in place and released once the plugin is done with
+	// it, always, even if the load fails; without one it is copied
+	virtual bool LoadVolumeFromMemory(
+		void *buffer,
+		const std::array<int, 3> &dimensions,
+		const std::array<double, 3> &spacing,
+		const std::array<double, 3> &origin,
+		const int scalarType,
+		const int nComponents,
+		const bool reverseSlices,
+		std::function<void()> release) = 0;
+
+	// Loads the frames of a time series in parallel, returning the number of frames added
+	virtual int LoadVolumeSeries(const VolumeFileFormat format, const std::vector<std::string> &paths) = 0;
+
+	// Generates nFrames frames of a VolumePhantom, returning the number of frames added
+	virtual int AddPhantomVolume(
+		const VolumePhantomType type,
+		const std::array<int, 3> &dimensions,
+		const int scalarType,
+		const int nFrames) = 0;
+
+	virtual void SetParallelDicomLoading(const bool parallel) = 0;
+	virtual void SetMemoryMappedLoading(const bool memoryMapped) = 0;
+	virtual void SetPipelinedInflate(const bool pipelined) = 0;
+	virtual void SetProgressiveLoading(const bool progressive, const int previewStride) = 0;
+	virtual void SetScalarNarrowing(const int bitsPerVoxel) = 0;
+
+	// Times the VTK reader against the CompressedVolumeReader on a compressed
+	// volume, or vtkDICOMImageReader against the ParallelDicomReader on a DICOM
+	// folder, logging the results, nothing is added to the scene
+	virtual bool BenchmarkVolumeReaders(
+		const VolumeFileFormat format,
+		const std::string &path,
+		const int nRuns) = 0;
+	// Writes a phantom of about sizeMB as raw and compressed MetaImage and as DICOM in
+	// folder, then logs the peak resident memory of loading it by each reader path
+	virtual bool BenchmarkVolumeLoadMemory(
+		const std::string &folder,
+		const int sizeMB) = 0;
+	// Writes short phantom series in each format to folder and loads them with
+	// LoadVolumeSeries, logging which load, returns whether all did
+	virtual bool CheckVolumeSeriesLoading(
+		const std::string &folder) = 0;
+
+	// Evicts the least recently shown volumes once their voxels pass the budget
+	virtual void SetVolumeMemoryBudgetMB(const int budgetMB) = 0;
+	virtual int GetNResidentVolumes() = 0;
+	virtual int GetNEvictedVolumes() = 0;
+
+	// Volumes added with the same voxels share one copy, and one set of mappers
+	virtual void SetVolumeDeduplication(const bool deduplicate) = 0;
+	virtual int GetNDistinctVolumes() = 0;
+
+	// Each volume gets 2x, 4x and 8x downsampled levels, built in the background,
+	// that a volume prop or MPR can be shown at in place of the full volume
+	virtual void SetVolumePyramids(const bool enabled) = 0;
+	virtual int GetNVolumePyramidLevels(const int volumeIndex) = 0;
+	virtual void SetPropVolumeLevel(const int propId, const int level) = 0;
+
+	// Volumes are split into bricks with the range of each, 0 to turn them off
+	virtual void SetVolumeBrickSize(const int brickSize) = 0;
+	virtual int GetNVolumeBricks(const int volumeIndex) = 0;
+	virtual int GetNPaddingVolumeBricks(const int volumeIndex) = 0;
+
+	// Volume props added after show every volume through one prop and a pool of mappers, 0 for off
+	virtual void SetVolumeStreaming(const int poolSize) = 0;
+
+	// Crops the volume mappers to the bricks the transfer function leaves visible
+	virtual void SetEmptySpaceCropping(const bool cropping) = 0;
+	// Queries of the current volume, in its own space in m, value in the units of the source
+	virtual bool ProbeVolume(
+		const std::array<double, 3> &positionM,
+		double &value,
+		double &opacity) = 0;
+	virtual bool CastRayIntoVolume(
+		const std::array<double, 3> &originM,
+		const std::array<double, 3> &directionM,
+		std::array<double, 3> &hitM) = 0;
+
+	// Fills NVolumeStatistic values and nBins histogram counts, in the units of the source
+	virtual bool GetVolumeStatistics(
+		const int volumeIndex,
+		const bool maskedOnly,
+		const int nBins,
+		double *statistics,
+		double *histogram) = 0;
+
+	virtual void SetVolumeCacheEnabled(const bool enabled) = 0;
+	virtual void SetVolumeCacheFolder(const std::string &folder) = 0;
+	virtual void SetVolumeCacheSizeLimitMB(const int sizeLimitMB) = 0;
+	virtual void ClearVolumeCache() = 0;
+
+	// Loads in the background, returning a ticket to poll, volumes are added in ticket order
+	virtual int LoadVolumeAsync(const VolumeFileFormat format, const std::string &path) = 0;
+	virtual float GetVolumeLoadProgress(const int ticket) = 0;
+	virtual VolumeLoadStatus GetVolumeLoadStatus(const int ticket) = 0;
+	virtual int GetVolumeLoadIndex(const int ticket) = 0;
+	virtual void CancelVolumeLoad(const int ticket) = 0;
+	// Adds the volumes loaded since the last call, from the render thread
+	virtual void UpdateVolumeLoads() = 0;
 
 	virtual bool CreatePaddingMask(int paddingValue) = 0;
 
@@ -65,14 +169,46 @@ public:
 		const double green1,
 		const double blue1,
 		const double opacity1) = 0;
+	// Sets nPoints points at once, for a whole preset
+	virtual void SetTransferFunctionPoints(
+		const int transferFunctionIndex,
+		const int nPoints,
+		const double *windowFractions,
+		const double *reds,
+		const double *greens,
+		const double *blues,
+		const double *opacities) = 0;
 	virtual void SetVolumeWWWL(const double windowWidth, const double windowLevel) = 0;
 	virtual void SetVolumeOpactityFactor(const double opacityFactor) = 0;
 	virtual void SetVolumeBrightnessFactor(const double brightnessFactor) = 0;
+	// The transfer function and window changes above are rebuilt into the volume's
+	// color and opacity once, by this, from the render thread
+	virtual void UpdateTransferFunction() = 0;
 
 	virtual void SetRenderComposite(const bool composite) = 0;
 
 	virtual void SetTargetFrameRateOn(const bool targetOn) = 0;
 	virtual void SetTargetFrameRateFps(const int targetFps) = 0;
+	// Holds the measured render time at targetFps by coarsening the volume mappers' sample
+	// distances within the bounds, the sample distance as a scale of each mapper's own
+	virtual void SetAdaptiveSampling(const bool adaptiveOn, const double targetFps) = 0;
+	virtual void SetAdaptiveSamplingBounds(
+		const double minSampleDistanceScale,
+		const double maxSampleDistanceScale,
+		const double minImageSampleDistance,
+		const double maxImageSampleDistance) = 0;
+	virtual float GetRenderTimeMs() = 0;
+	// Renders the volumes coarser while the view, props or MPRs move, until they have
+	// been still for idleSeconds
+	virtual void SetMotionLOD(const bool motionLODOn, const double idleSeconds) = 0;
+	virtual void SetMotionLODQuality(
+		const double sampleDistanceScale,
+		const double imageSampleDistance,
+		const int volumeLevel) = 0;
+	// Skips the render of a camera whose matrices, and the scene, are unchanged since its
+	// last, for targets that keep what was last rendered into them
+	virtual void SetSkipUnchangedRenders(const bool skipUnchanged) = 0;
+	virtual int GetNSkippedRenders() = 0;
 
 	virtual int AddMPR(const int existingMprId, const int flipAxis) = 0;
 	virtual void SetMPRWWWL(const double windowWidth, const double windowLevel) = 0;
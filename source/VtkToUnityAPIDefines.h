@@ -55,3 +55,48 @@ enum VolumeLightType {
 	NVolumeLightType
 };
 
+
+enum VolumeFileFormat {
+	VolumeFileDicomFolder = 0,
+	VolumeFileMhd,
+	VolumeFileNrrd,
+	VolumeFileNifti,
+	NVolumeFileFormat
+};
+
+enum VolumeLoadStatus {
+	VolumeLoadUnknown = 0,
+	VolumeLoadQueued,
+	VolumeLoadLoading,
+	VolumeLoadComplete,
+	VolumeLoadFailed,
+	VolumeLoadCancelled,
+	VolumeLoadPreviewing
+};
+
+// The values GetVolumeStatistics fills in, in order
+enum VolumeStatistic {
+	VolumeStatisticNVoxels = 0,
+	VolumeStatisticMin,
+	VolumeStatisticMax,
+	VolumeStatisticMean,
+	VolumeStatisticStdDev,
+	VolumeStatisticPercentile1,
+	VolumeStatisticPercentile2,
+	VolumeStatisticPercentile5,
+	VolumeStatisticPercentile25,
+	VolumeStatisticPercentile50,
+	VolumeStatisticPercentile75,
+	VolumeStatisticPercentile95,
+	VolumeStatisticPercentile98,
+	VolumeStatisticPercentile99,
+	NVolumeStatistic
+};
+
+enum VolumePhantomType {
+	VolumePhantomSpheres = 0,
+	VolumePhantomSheppLogan,
+	VolumePhantomNoise,
+	VolumePhantomBeatingHeart,
+	NVolumePhantomType
+};
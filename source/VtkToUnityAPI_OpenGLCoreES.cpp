@@ -7,10 +7,29 @@
 
 #include "Adapters/vtkAdapterUtility.h"
 
+#include "Volumes/CompressedVolumeReader.h"
+#include "Volumes/MappedVolumeReader.h"
+#include "Volumes/ParallelDicomReader.h"
+#include "Volumes/ParallelFor.h"
+#include "Volumes/RawVolumeHeader.h"
+#include "Volumes/ResidentMemorySampler.h"
+#include "Volumes/ScalarNarrowing.h"
+#include "Volumes/VolumeBuffer.h"
+#include "Volumes/VolumeCache.h"
+#include "Volumes/VolumeHash.h"
+#include "Volumes/VolumePhantom.h"
+#include "Volumes/VolumePreview.h"
+#include "Volumes/VolumePyramid.h"
+#include "Volumes/VolumeSpill.h"
+#include "Volumes/VolumeStatistics.h"
+
 #define _USE_MATH_DEFINES
 #include <math.h>
 
+#include <algorithm>
+#include <chrono>
 #include <fstream>
+#include <set>
 #include <sstream>
 #include <thread>
 
@@ -35,12 +54,15 @@ VTK_MODULE_INIT(vtkRenderingVolumeOpenGL2); // Required for the smart volume map
 #include <vtkLightActor.h>
 #include <vtkLightCollection.h>
 #include <vtkPolyDataMapper.h>
+#include <vtkPropCollection.h>
 #include "vtkWindows.h" // Needed to include OpenGL header on Windows.
 #include <vtk_glew.h>
 
 #include <vtkDICOMImageReader.h>
 #include <vtkMetaImageReader.h>
 #include <vtkNrrdReader.h>
+#include <vtkNIFTIImageHeader.h>
+#include <vtkNIFTIImageReader.h>
 #include <vtkMatrix4x4.h>
 #include <vtkPlane.h>
 #include <vtkSphereSource.h>
@@ -49,8 +71,10 @@ VTK_MODULE_INIT(vtkRenderingVolumeOpenGL2); // Required for the smart volume map
 #include <vtkFrustumCoverageCuller.h>
 
 #include <vtkImageFlip.h>
-#include <vtkImageThreshold.h>
 
+#include <vtkAlgorithm.h>
+#include <vtkDataArray.h>
+#include <vtkPointData.h>
 #include <vtkAlgorithmOutput.h>
 
 
@@ -78,7 +102,263 @@ static const unsigned int sRedIndex(0U);
 static const unsigned int sGreenIndex(1U);
 static const unsigned int sBlueIndex(2U);
 static const unsigned int sOpacityIndex(3U);
+// share of a progressive load's progress taken by its preview
+static const float sPreviewProgressFraction(0.1f);
+// cameras, e.g. the eyes and a spectator, whose last render is remembered for skipping
+static const size_t sMaxRenderSignatures(4);
+// largest change of a view matrix element, metres or rotation, taken as tracking jitter rather than motion
+static const double sViewMotionEpsilon(1.0e-3);
+
+
+static double SecondsSince(
+	const std::chrono::steady_clock::time_point &start)
+{
+	return std::chrono::duration<double>(
+		std::chrono::steady_clock::now() - start).count();
+}
+
+// Forwards a reader's progress, and aborts it once the load has been cancelled
+static void OnVolumeReaderProgress(
+	vtkObject *caller,
+	unsigned long eventId,
+	void *clientData,
+	void *callData)
+{
+	auto progress = static_cast<LoadProgress*>(clientData);
+	progress->Report(*static_cast<double*>(callData));
+
+	if (progress->IsCancelled())
+	{
+		vtkAlgorithm::SafeDownCast(caller)->SetAbortExecute(1);
+	}
+}
+
+static vtkSmartPointer<vtkImageData> UpdateVolumeReader(
+	vtkAlgorithm *reader,
+	LoadProgress *progress)
+{
+	vtkNew<vtkCallbackCommand> progressCallback;
+	if (nullptr != progress)
+	{
+		progressCallback->SetCallback(OnVolumeReaderProgress);
+		progressCallback->SetClientData(progress);
+		reader->AddObserver(vtkCommand::ProgressEvent, progressCallback.GetPointer());
+	}
+
+	reader->Update();
+
+	if (nullptr != progress &&
+		progress->IsCancelled())
+	{
+		return nullptr;
+	}
+
+	// take over the reader's scalars rather than copying them, once the reader
+	// is released the volume holds the only reference
+	vtkSmartPointer<vtkImageData> volumeImageData =
+		vtkSmartPointer<vtkImageData>::New();
+	volumeImageData->ShallowCopy(reader->GetOutputDataObject(0));
+
+	return volumeImageData;
+}
+
+// Replaces the scalars with a copy reversed along z, for volumes whose
+// scalars cannot be reversed in place, such as a read-only file mapping
+static void CopyScalarsReversedAlongZ(
+	vtkImageData *volumeImageData)
+{
+	vtkDataArray *scalars = volumeImageData->GetPointData()->GetScalars();
+	if (nullptr == scalars)
+	{
+		return;
+	}
+
+	std::array<int, 3> dimensions;
+	volumeImageData->GetDimensions(dimensions.data());
+
+	auto reversedScalars = vtkSmartPointer<vtkDataArray>::Take(scalars->NewInstance());
+	reversedScalars->SetNumberOfComponents(scalars->GetNumberOfComponents());
+	reversedScalars->SetNumberOfTuples(scalars->GetNumberOfTuples());
+	reversedScalars->SetName(scalars->GetName());
+
+	const size_t nSlices = static_cast<size_t>(dimensions[2]);
+	const size_t sliceBytes =
+		static_cast<size_t>(dimensions[0]) *
+		static_cast<size_t>(dimensions[1]) *
+		static_cast<size_t>(scalars->GetNumberOfComponents() * scalars->GetDataTypeSize());
+
+	const unsigned char *inputDataPtr = static_cast<const unsigned char*>(scalars->GetVoidPointer(0));
+	unsigned char *reversedDataPtr = static_cast<unsigned char*>(reversedScalars->GetVoidPointer(0));
+
+	ParallelFor(nSlices, [=](const size_t z)
+	{
+		memcpy(
+			reversedDataPtr + (z * sliceBytes),
+			inputDataPtr + ((nSlices - 1 - z) * sliceBytes),
+			sliceBytes);
+	});
+
+	volumeImageData->GetPointData()->SetScalars(reversedScalars);
+}
+
+// Reverses the voxels along each axis set in flipAxes, in place
+static void FlipVolumeAxes(
+	vtkImageData *volumeImageData,
+	const std::array<bool, 3> &flipAxes)
+{
+	vtkDataArray *scalars = volumeImageData->GetPointData()->GetScalars();
+	if (nullptr == scalars ||
+		!(flipAxes[0] || flipAxes[1] || flipAxes[2]))
+	{
+		return;
+	}
+
+	std::array<int, 3> dimensions;
+	volumeImageData->GetDimensions(dimensions.data());
+
+	const size_t nColumns = static_cast<size_t>(dimensions[0]);
+	const size_t nRows = static_cast<size_t>(dimensions[1]);
+	const size_t nSlices = static_cast<size_t>(dimensions[2]);
+	const size_t voxelBytes =
+		static_cast<size_t>(scalars->GetNumberOfComponents() * scalars->GetDataTypeSize());
+	const size_t rowBytes = nColumns * voxelBytes;
+	const size_t sliceBytes = nRows * rowBytes;
+
+	unsigned char *dataPtr = static_cast<unsigned char*>(scalars->GetVoidPointer(0));
+
+	ParallelFor(nSlices, [=](const size_t z)
+	{
+		unsigned char *slicePtr = dataPtr + (z * sliceBytes);
+
+		if (flipAxes[0])
+		{
+			for (size_t y = 0; y < nRows; ++y)
+			{
+				unsigned char *rowPtr = slicePtr + (y * rowBytes);
+
+				for (size_t x = 0; x < nColumns / 2; ++x)
+				{
+					std::swap_ranges(
+						rowPtr + (x * voxelBytes),
+						rowPtr + ((x + 1) * voxelBytes),
+						rowPtr + ((nColumns - 1 - x) * voxelBytes));
+				}
+			}
+		}
+
+		if (flipAxes[1])
+		{
+			for (size_t y = 0; y < nRows / 2; ++y)
+			{
+				std::swap_ranges(
+					slicePtr + (y * rowBytes),
+					slicePtr + ((y + 1) * rowBytes),
+					slicePtr + ((nRows - 1 - y) * rowBytes));
+			}
+		}
+	});
+
+	if (flipAxes[2])
+	{
+		ParallelFor(nSlices / 2, [=](const size_t z)
+		{
+			std::swap_ranges(
+				dataPtr + (z * sliceBytes),
+				dataPtr + ((z + 1) * sliceBytes),
+				dataPtr + ((nSlices - 1 - z) * sliceBytes));
+		});
+	}
 
+	scalars->Modified();
+}
+
+static unsigned long long ScalarBytes(
+	vtkImageData *volumeImageData)
+{
+	vtkDataArray *scalars = volumeImageData->GetPointData()->GetScalars();
+
+	if (nullptr == scalars)
+	{
+		return 0;
+	}
+
+	return static_cast<unsigned long long>(scalars->GetNumberOfValues()) *
+		static_cast<unsigned long long>(scalars->GetDataTypeSize());
+}
+
+
+// Whether the view moved by more than tracking jitter. The last view is kept until
+// it does, so a slow drift still adds up to a move
+static bool ViewMoved(
+	const std::array<double, 16> &lastViewMatrix,
+	const std::array<double, 16> &viewMatrix)
+{
+	for (size_t i = 0; i < viewMatrix.size(); ++i)
+	{
+		if (fabs(viewMatrix[i] - lastViewMatrix[i]) > sViewMotionEpsilon)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+static unsigned long long PyramidBytes(
+	const VolumeRecord &record)
+{
+	return (nullptr != record.pyramid) ? record.pyramid->GetBytes() : 0;
+}
+
+
+// Keeps the samples per voxel as the spacing of the mapper's input changes
+static void SetVolumeMapperInput(
+	vtkGPUVolumeRayCastMapper *volumeMapper,
+	vtkImageData *volumeImageData)
+{
+	vtkImageData *previousImageData = volumeMapper->GetInput();
+
+	if (nullptr != previousImageData &&
+		previousImageData->GetSpacing()[0] > 0.0)
+	{
+		volumeMapper->SetSampleDistance(static_cast<float>(volumeMapper->GetSampleDistance() *
+			(volumeImageData->GetSpacing()[0] / previousImageData->GetSpacing()[0])));
+	}
+
+	volumeMapper->SetInputData(volumeImageData);
+}
+
+
+// The same extent, spacing and origin as the grid, before any conversion to metres or
+// re-centring, and the same scalars. The grid may be a structure alone, with no scalars
+// of its own to give their type
+static bool SameVolumeGrid(
+	vtkImageData *a,
+	const int scalarType,
+	const int nComponents,
+	vtkImageData *b)
+{
+	std::array<int, 6> extentA;
+	std::array<int, 6> extentB;
+	a->GetExtent(extentA.data());
+	b->GetExtent(extentB.data());
+
+	const double maxError(1e-6);
+
+	for (int i = 0; i < 3; ++i)
+	{
+		if (maxError < fabs(a->GetSpacing()[i] - b->GetSpacing()[i]) ||
+			maxError < fabs(a->GetOrigin()[i] - b->GetOrigin()[i]))
+		{
+			return false;
+		}
+	}
+
+	return extentA == extentB &&
+		scalarType == b->GetScalarType() &&
+		nComponents == b->GetNumberOfScalarComponents();
+}
 
 static int WindowFractionDoubleToInteger(const double windowFractionIn)
 {
@@ -115,6 +395,33 @@ VtkToUnityAPI* CreateVtkToUnityAPI_OpenGLCoreES(UnityGfxRenderer apiType)
 
 VtkToUnityAPI_OpenGLCoreES::VtkToUnityAPI_OpenGLCoreES(UnityGfxRenderer apiType)
 	: mAPIType(apiType)
+	, mPaddingMaskOn(false)
+	, mPaddingMaskValue(0.0)
+	, mVolumeMemoryBudgetBytes(0)
+	, mVolumeShowCounter(0)
+	, mDeduplicateVolumes(true)
+	, mVolumeBrickSize(VolumeBricks::sDefaultBrickSize)
+	, mEmptySpaceCropping(true)
+	, mVolumeStreamingPoolSize(0)
+	, mAutoAdjustSampleDistances(true)
+	, mAdaptiveSamplingOn(false)
+	, mAppliedSampleDistanceScale(1.0)
+	, mAppliedImageSampleDistance(1.0)
+	, mRenderCpuSeconds()
+	, mRenderTimerIndex(0)
+	, mWindowRendered(false)
+	, mMotionLODOn(false)
+	, mInMotion(false)
+	, mMotionIdleSeconds(0.3)
+	, mMotionSampleDistanceScale(2.0)
+	, mMotionImageSampleDistance(2.0)
+	, mMotionVolumeLevel(0)
+	, mSkipUnchangedRenders(false)
+	, mNSkippedRenders(0)
+	, mVolumePyramidsOn(true)
+	, mTransferFunctionDirty(true)
+	, mVolumeWindowDirty(true)
+	, mPyramidWorkers(1)
 {
 	VtkIntrospection::InitIntrospector();
 }
@@ -122,6 +429,16 @@ VtkToUnityAPI_OpenGLCoreES::VtkToUnityAPI_OpenGLCoreES(UnityGfxRenderer apiType)
 
 VtkToUnityAPI_OpenGLCoreES::~VtkToUnityAPI_OpenGLCoreES()
 {
+	// the pyramid being built is stopped at its next level rather than finished
+	for (auto &record : mVolumeRecords)
+	{
+		if (nullptr != record.pyramid)
+		{
+			record.pyramid->Cancel();
+		}
+	}
+
+	RemoveVolumeSpills();
 	VtkIntrospection::FinalizeIntrospector();
 }
 
@@ -148,1510 +465,4122 @@ void VtkToUnityAPI_OpenGLCoreES::SetDebugLogFunction(DebugLogFunc func)
 bool VtkToUnityAPI_OpenGLCoreES::LoadDicomVolumeFromFolder(
 	const std::string &dicomFolder)
 {
-	vtkNew<vtkDICOMImageReader> dicomReader;
-	dicomReader->SetDirectoryName(dicomFolder.c_str());
-	dicomReader->Update();
+	const auto loadStart = std::chrono::steady_clock::now();
 
-	vtkSmartPointer<vtkImageData> volumeImageData = 
-		vtkSmartPointer<vtkImageData>::New();
-	volumeImageData->DeepCopy(dicomReader->GetOutput());
+	VolumeRecord record;
+	vtkSmartPointer<vtkImageData> volumeImageData = ReadVolumeFile(
+		VolumeFileDicomFolder, dicomFolder, mVolumeLoadOptions, nullptr, record);
+
+	if (nullptr == volumeImageData)
+	{
+		return false;
+	}
+
+	// report the read time, so the two readers can be compared on the same series
+	std::stringstream timing;
+	timing << "LoadDicomVolumeFromFolder: read "
+		<< volumeImageData->GetDimensions()[2] << " slices in "
+		<< SecondsSince(loadStart) << " s";
+	LogToDebugLog(DebugLogLevel::DebugLog, timing.str());
 
 	if (!CheckVolumeExtentSpacingOrigin(volumeImageData))
 	{
 		return false;
 	}
 
-	AddVolume(volumeImageData);
+	AddVolume(volumeImageData, record);
 	return true;
 }
 
 bool VtkToUnityAPI_OpenGLCoreES::LoadUncMetaImage(
 	const std::string &mhdPath)
 {
-	vtkNew<vtkMetaImageReader> mhdReader;
-	mhdReader->SetFileName(mhdPath.c_str());
-	mhdReader->Update();
-
-	vtkSmartPointer<vtkImageData> volumeImageData =
-		vtkSmartPointer<vtkImageData>::New();
-	volumeImageData->DeepCopy(mhdReader->GetOutput());
+	VolumeRecord record;
+	vtkSmartPointer<vtkImageData> volumeImageData = ReadVolumeFile(
+		VolumeFileMhd, mhdPath, mVolumeLoadOptions, nullptr, record);
 
-	if (!CheckVolumeExtentSpacingOrigin(volumeImageData))
+	if (nullptr == volumeImageData ||
+		!CheckVolumeExtentSpacingOrigin(volumeImageData))
 	{
 		return false;
 	}
 
-	AddVolume(volumeImageData);
+	AddVolume(volumeImageData, record);
 	return true;
 }
 
 bool VtkToUnityAPI_OpenGLCoreES::LoadNrrdImage(
 	const std::string &nrrdPath)
 {
-	vtkNew<vtkNrrdReader> nrrdReader;
-	nrrdReader->SetFileName(nrrdPath.c_str());
-	nrrdReader->Update();
-
-	vtkSmartPointer<vtkImageData> volumeImageData =
-		vtkSmartPointer<vtkImageData>::New();
-	volumeImageData->DeepCopy(nrrdReader->GetOutput());
+	VolumeRecord record;
+	vtkSmartPointer<vtkImageData> volumeImageData = ReadVolumeFile(
+		VolumeFileNrrd, nrrdPath, mVolumeLoadOptions, nullptr, record);
 
-	if (!CheckVolumeExtentSpacingOrigin(volumeImageData))
+	if (nullptr == volumeImageData ||
+		!CheckVolumeExtentSpacingOrigin(volumeImageData))
 	{
 		return false;
 	}
 
-	AddVolume(volumeImageData);
+	AddVolume(volumeImageData, record);
 	return true;
 }
 
-
-bool VtkToUnityAPI_OpenGLCoreES::CreatePaddingMask(int paddingValue)
+bool VtkToUnityAPI_OpenGLCoreES::LoadNiftiImage(
+	const std::string &niftiPath)
 {
-	// return if we have already generated a mask or there are no volume
-	if (nullptr != mVolumeMask ||
-		nullptr == mCurrentVolumeData)
+	VolumeRecord record;
+	vtkSmartPointer<vtkImageData> volumeImageData = ReadVolumeFile(
+		VolumeFileNifti, niftiPath, mVolumeLoadOptions, nullptr, record);
+
+	if (nullptr == volumeImageData ||
+		!CheckVolumeExtentSpacingOrigin(volumeImageData))
 	{
 		return false;
 	}
 
-	auto imageThreshold = vtkSmartPointer<vtkImageThreshold>::New();
-	imageThreshold->SetInputData(mCurrentVolumeData);
-	imageThreshold->SetInValue(0.0);
-	imageThreshold->SetOutValue(255.0);
-	imageThreshold->SetOutputScalarTypeToUnsignedChar();
-	imageThreshold->ThresholdBetween(paddingValue - 0.5, paddingValue + 0.5);
-	imageThreshold->Update();
-
-	mVolumeMask = vtkSmartPointer<vtkImageData>::New();
-	mVolumeMask->DeepCopy(imageThreshold->GetOutput());
-
+	AddVolume(volumeImageData, record);
 	return true;
 }
 
-
-void VtkToUnityAPI_OpenGLCoreES::ClearVolumes()
+bool VtkToUnityAPI_OpenGLCoreES::LoadVolumeFromMemory(
+	void *buffer,
+	const std::array<int, 3> &dimensions,
+	const std::array<double, 3> &spacing,
+	const std::array<double, 3> &origin,
+	const int scalarType,
+	const int nComponents,
+	const bool reverseSlices,
+	std::function<void()> release)
 {
-	mVolumeDataVector.clear();
-	SetVolumeIndex(-1);
-	mVolumeMask = nullptr;
-}
+	RawVolumeLayout layout;
+	layout.scalarType = scalarType;
+	layout.nComponents = nComponents;
+	layout.dimensions = dimensions;
+	layout.spacing = spacing;
+	layout.origin = origin;
 
+	VolumeRecord record;
+	vtkSmartPointer<vtkImageData> volumeImageData;
 
-int VtkToUnityAPI_OpenGLCoreES::GetNVolumes()
-{
-	return static_cast<int>(mVolumeDataVector.size());
-}
-
+	if (release)
+	{
+		volumeImageData = VolumeBuffer::Wrap(buffer, layout, release);
 
-Float4 VtkToUnityAPI_OpenGLCoreES::GetVolumeSpacingM()
-{
-	return StdArray3ToFloat4(mVolumeSpacingM);
-}
+		if (nullptr == volumeImageData)
+		{
+			release();
+		}
 
+		// the buffer is not ours to write to, the reversed copy is made when the volume is shown
+		record.reversePending = reverseSlices;
+	}
+	else
+	{
+		volumeImageData = VolumeBuffer::Copy(buffer, layout, reverseSlices);
+	}
 
-Float4 VtkToUnityAPI_OpenGLCoreES::GetVolumeExtentsMin()
-{
-	return StdArray3ToFloat4(mVolumeExtentMin);
-}
+	if (nullptr == volumeImageData)
+	{
+		LogToDebugLog(DebugLogLevel::DebugLogWarning,
+			"LoadVolumeFromMemory: unsupported scalar type, components or dimensions");
+		return false;
+	}
 
+	// there is no source to read it again from, an evicted volume is spilled
+	NarrowVolumeScalars(volumeImageData, mVolumeLoadOptions, record);
 
-Float4 VtkToUnityAPI_OpenGLCoreES::GetVolumeExtentsMax()
-{
-	return StdArray3ToFloat4(mVolumeExtentMax);
-}
+	if (!CheckVolumeExtentSpacingOrigin(volumeImageData))
+	{
+		return false;
+	}
 
-Float4 VtkToUnityAPI_OpenGLCoreES::GetVolumeOriginM()
-{
-	return StdArray3ToFloat4(mVolumeOriginCentredM);
+	AddVolume(volumeImageData, record);
+	return true;
 }
 
 
-void VtkToUnityAPI_OpenGLCoreES::SetVolumeIndex(
-	const int index)
+int VtkToUnityAPI_OpenGLCoreES::LoadVolumeSeries(
+	const VolumeFileFormat format,
+	const std::vector<std::string> &paths)
 {
-	int newIndex = index;
-	// This may be an odd looking set of if/else, but...
-	// if the index is invalid, show the synthetic volume, indicated by 
-	if (newIndex < 0 ||
-		newIndex >= mVolumeDataVector.size())
+	if (paths.empty())
 	{
-		newIndex = -1;
+		return 0;
 	}
 
-	if (newIndex ==-1 )
-	{
-		// if the index is invalid, show the synthetic volume
-		mCurrentVolumeData->ShallowCopy(mSyntheticVolumeData.GetPointer());
-		mCurrentVolumeIndex = -1;
-		return;
-	}
+	const auto loadStart = std::chrono::steady_clock::now();
 
-	if (newIndex == mCurrentVolumeIndex)
-	{
-		// if the index is valid but unchanged, so we don't need to update the 
-		// current volume data
-		return;
-	}
+	// the frames are already spread over the cores, the parallel DICOM read and the
+	// prefetch and inflate threads of each compressed frame would only oversubscribe them
+	VolumeLoadOptions options = mVolumeLoadOptions;
+	options.parallelDicom = false;
+	options.pipelinedInflate = false;
+	options.narrowScalarType = VTK_VOID;
 
-	mCurrentVolumeIndex = newIndex;
-	mCurrentVolumeData->ShallowCopy(mVolumeDataVector[newIndex]);
+	const size_t nFrames = paths.size();
+	const int firstFrameIndex = GetNVolumes();
 
-	for (auto volumePropsVectorPair : mVolumeProp3Ds)
+	// the first frame's grid and scalars as read, before it is converted to metres, re-centred
+	// and narrowed, without holding on to its voxels
+	auto seriesGrid = vtkSmartPointer<vtkImageData>::New();
+	int seriesScalarType(VTK_VOID);
+	int seriesNComponents(0);
+
+	// a core's worth of frames is read at a time, and the budget enforced after each,
+	// so a series loaded under a budget holds little more than it
+	const size_t chunkFrames = ParallelThreadCount();
+	for (size_t chunkStart = 0; chunkStart < nFrames; chunkStart += chunkFrames)
 	{
-		auto volumePropsVector = volumePropsVectorPair.second;
+		const size_t nChunkFrames = std::min(chunkFrames, nFrames - chunkStart);
+		std::vector<vtkSmartPointer<vtkImageData>> frames(nChunkFrames);
+		std::vector<VolumeRecord> frameRecords(nChunkFrames);
 
-		for (int iVolumeProp = 0; iVolumeProp < volumePropsVector.size(); ++iVolumeProp)
+		ParallelFor(nChunkFrames, [&](const size_t iFrame)
+		{
+			frames[iFrame] = ReadVolumeFile(
+				format, paths[chunkStart + iFrame], options, nullptr, frameRecords[iFrame]);
+		});
+
+		if (0 == chunkStart &&
+			nullptr != frames.front())
 		{
-			volumePropsVector[iVolumeProp]->SetVisibility(iVolumeProp == mCurrentVolumeIndex);
+			seriesGrid->CopyStructure(frames.front());
+			seriesScalarType = frames.front()->GetScalarType();
+			seriesNComponents = frames.front()->GetNumberOfScalarComponents();
 		}
-	}
 
-	// update all of the reslices, is all of this really necessary?
-	for (auto & reslicePair : mReslice)
-	{
-		auto id = reslicePair.first;
-		auto reslice = reslicePair.second;
+		// every frame must be on the same grid, a series failing part way adds none of it
+		for (size_t iFrame = 0; iFrame < nChunkFrames; ++iFrame)
+		{
+			if (nullptr == frames[iFrame] ||
+				!SameVolumeGrid(seriesGrid, seriesScalarType, seriesNComponents, frames[iFrame]))
+			{
+				LogToDebugLog(DebugLogLevel::DebugLogWarning,
+					std::string("LoadVolumeSeries: could not read, or a different grid in, ") + paths[chunkStart + iFrame]);
+				RemoveVolumesFrom(firstFrameIndex);
+				return -1;
+			}
+		}
 
-		auto resliceTransformIter = mResliceTransforms.find(id);
-		auto resliceColorIter = mResliceColors.find(id);
+		// narrowing is parallel within a frame, so it is done one frame at a time
+		for (size_t iFrame = 0; iFrame < nChunkFrames; ++iFrame)
+		{
+			NarrowVolumeScalars(frames[iFrame], mVolumeLoadOptions, frameRecords[iFrame]);
+		}
 
-		if (resliceTransformIter != mResliceTransforms.end() &&
-			resliceColorIter != mResliceColors.end())
+		// only the first frame can disagree with the volumes already loaded
+		for (auto &frame : frames)
 		{
-			reslice->RemoveAllInputs();
-			reslice->SetInputData(mCurrentVolumeData.GetPointer());
-			reslice->SetResliceTransform((*resliceTransformIter).second);
-			reslice->SetInterpolationModeToLinear();
-			reslice->Update();
+			if (!CheckVolumeExtentSpacingOrigin(frame))
+			{
+				LogToDebugLog(DebugLogLevel::DebugLogWarning,
+					"LoadVolumeSeries: series does not match the volumes already loaded");
+				RemoveVolumesFrom(firstFrameIndex);
+				return -1;
+			}
+		}
 
-			(*resliceColorIter).second->Update();
+		// frames repeating one already loaded, or an earlier frame, are shared
+		for (size_t iFrame = 0; iFrame < nChunkFrames; ++iFrame)
+		{
+			ShareDuplicateVolume(frames[iFrame], frameRecords[iFrame]);
+			mVolumeDataVector.push_back(frames[iFrame]);
+			mVolumeRecords.push_back(frameRecords[iFrame]);
 		}
+
+		// the frames are read again from their files when shown
+		EnforceVolumeMemoryBudget();
 	}
+
+	// update the scene once for the whole series
+	SetVolumeIndex(firstFrameIndex);
+	QueueVolumePyramids();
+
+	std::stringstream timing;
+	timing << "LoadVolumeSeries: read " << nFrames << " frames in "
+		<< SecondsSince(loadStart) << " s";
+	LogToDebugLog(DebugLogLevel::DebugLog, timing.str());
+
+	return static_cast<int>(nFrames);
 }
 
 
-int VtkToUnityAPI_OpenGLCoreES::AddVolumeProp()
+int VtkToUnityAPI_OpenGLCoreES::AddPhantomVolume(
+	const VolumePhantomType type,
+	const std::array<int, 3> &dimensions,
+	const int scalarType,
+	const int nFrames)
 {
-	// We need a volume mapper for each volume prop as the clipping planes are 
-	// attached to the volume mapper
-	std::vector<vtkSmartPointer<vtkProp3D>> volumePropsVector;
-	volumePropsVector.reserve(GetNVolumes());
-	std::vector<vtkSmartPointer<vtkGPUVolumeRayCastMapper>> volumeMappersVector;
-	volumeMappersVector.reserve(GetNVolumes());
-	vtkTypeBool visibility(true);
+	const auto generateStart = std::chrono::steady_clock::now();
+	const int firstFrameIndex = GetNVolumes();
 
-	for (auto volumeData : mVolumeDataVector)
+	// one frame at a time, so a series larger than memory can be made under a budget
+	for (int frame = 0; frame < nFrames; ++frame)
 	{
-		auto volumeMapper = vtkSmartPointer<vtkGPUVolumeRayCastMapper>::New();
-		volumeMapper->SetBlendModeToComposite();
-		volumeMapper->SetInputData(volumeData);
-		volumeMapper->Update();
+		vtkSmartPointer<vtkImageData> volumeImageData =
+			VolumePhantom::Generate(type, dimensions.data(), scalarType, frame, nFrames);
+
+		if (nullptr == volumeImageData)
+		{
+			LogToDebugLog(DebugLogLevel::DebugLogWarning,
+				"AddPhantomVolume: unknown phantom or scalar type, or a bad size");
+			break;
+		}
 
-		// we need to scale the volume mapper steps as we scale the data by a 
-		// factor of 1000 to account for mm to m as the base unit
-		volumeMapper->SetSampleDistance(
-			volumeMapper->GetSampleDistance() * sMmToMConversion);
+		VolumeRecord record;
+		NarrowVolumeScalars(volumeImageData, mVolumeLoadOptions, record);
 
-		// if a volume mask has been defined set it
-		if (nullptr != mVolumeMask)
+		if (!CheckVolumeExtentSpacingOrigin(volumeImageData))
 		{
-			volumeMapper->SetMaskInput(mVolumeMask);
-			volumeMapper->SetMaskTypeToBinary();
+			LogToDebugLog(DebugLogLevel::DebugLogWarning,
+				"AddPhantomVolume: phantom does not match the volumes already loaded");
+			break;
 		}
 
-		// connect up the volume to the property and the mapper
-		auto volumeProp = vtkSmartPointer<vtkVolume>::New();
-		volumeProp->SetProperty(mVolumeProperty.GetPointer());
-		volumeProp->SetVisibility(visibility);
-		visibility = false;
-		volumeProp->SetMapper(volumeMapper);
+		// static phantoms repeat the same frame
+		ShareDuplicateVolume(volumeImageData, record);
+		mVolumeDataVector.push_back(volumeImageData);
+		mVolumeRecords.push_back(record);
+		EnforceVolumeMemoryBudget();
+	}
 
-		volumePropsVector.push_back(volumeProp);
-		volumeMappersVector.push_back(volumeMapper);
-		mRenderer->AddViewProp(volumeProp);
+	const int nAdded = GetNVolumes() - firstFrameIndex;
+	if (nAdded > 0)
+	{
+		SetVolumeIndex(firstFrameIndex);
+		QueueVolumePyramids();
 	}
 
-	mVolumeProp3Ds.insert(std::make_pair(mNextActorIndex, volumePropsVector));
-	mVolumeMappers.insert(std::make_pair(mNextActorIndex, volumeMappersVector));
+	std::stringstream timing;
+	timing << "AddPhantomVolume: generated " << nAdded << " frames in "
+		<< SecondsSince(generateStart) << " s";
+	LogToDebugLog(DebugLogLevel::DebugLog, timing.str());
 
-	return (mNextActorIndex++);
+	return nAdded;
 }
 
 
-int VtkToUnityAPI_OpenGLCoreES::AddCropPlaneToVolume(const int volumeId)
+void VtkToUnityAPI_OpenGLCoreES::SetParallelDicomLoading(const bool parallel)
 {
-	// Let's just check that we have a volume mapper to apply the croping plane to
-	auto mapperIter = mVolumeMappers.find(volumeId);
-
-	if (mVolumeMappers.end() == mapperIter)
-	{
-		return -1;
-	}
-
-	auto volumeMappersVector = (*mapperIter).second;
-
-	// so create the plane and add it to the mapper
-	auto volumeCropPlane = vtkSmartPointer<vtkPlane>::New();
-	mVolumeCropPlanes.insert(std::make_pair(mNextActorIndex, volumeCropPlane));
-
-	for (auto volumeMapper : volumeMappersVector)
-	{
-		if (NULL == volumeMapper)
-		{
-			return -1;
-		}
-
-		volumeMapper->AddClippingPlane(volumeCropPlane.GetPointer());
-	}
-
-	return (mNextActorIndex++);
+	mVolumeLoadOptions.parallelDicom = parallel;
 }
 
 
-int VtkToUnityAPI_OpenGLCoreES::GetNTransferFunctions()
+void VtkToUnityAPI_OpenGLCoreES::SetMemoryMappedLoading(const bool memoryMapped)
 {
-	return static_cast<int>(mTransferFunctions.size());
+	mVolumeLoadOptions.memoryMapped = memoryMapped;
 }
 
 
-int VtkToUnityAPI_OpenGLCoreES::GetTransferFunctionIndex()
+void VtkToUnityAPI_OpenGLCoreES::SetPipelinedInflate(const bool pipelined)
 {
-	return static_cast<int>(mTransferFunctionIndex);
+	mVolumeLoadOptions.pipelinedInflate = pipelined;
 }
 
 
-void VtkToUnityAPI_OpenGLCoreES::SetTransferFunctionIndex(const int index)
+void VtkToUnityAPI_OpenGLCoreES::SetProgressiveLoading(const bool progressive, const int previewStride)
 {
-	if (index < 0 || index >= GetNTransferFunctions())
-	{
-		return;
-	}
-
-	mTransferFunctionIndex = index;
-	UpdateVolumeColorAndOpacity();
+	mVolumeLoadOptions.progressive = progressive;
+	mVolumeLoadOptions.previewStride = std::max(2, previewStride);
 }
 
 
-int VtkToUnityAPI_OpenGLCoreES::AddTransferFunction()
+void VtkToUnityAPI_OpenGLCoreES::SetScalarNarrowing(const int bitsPerVoxel)
 {
-	mTransferFunctions.push_back(InitialiseGreyLinear());
-	return static_cast<int>(mTransferFunctions.size() - 1);
+	switch (bitsPerVoxel)
+	{
+	case 8:
+		mVolumeLoadOptions.narrowScalarType = VTK_UNSIGNED_CHAR;
+		break;
+	case 16:
+		mVolumeLoadOptions.narrowScalarType = VTK_UNSIGNED_SHORT;
+		break;
+	default:
+		mVolumeLoadOptions.narrowScalarType = VTK_VOID;
+		break;
+	}
 }
 
 
-int VtkToUnityAPI_OpenGLCoreES::ResetTransferFunctions()
+bool VtkToUnityAPI_OpenGLCoreES::BenchmarkVolumeReaders(
+	const VolumeFileFormat format,
+	const std::string &path,
+	const int nRuns)
 {
-	mTransferFunctions.clear();
-	mTransferFunctionIndex = AddTransferFunction();
-	return mTransferFunctionIndex;
-}
+	// a DICOM folder compares the parallel reader with vtkDICOMImageReader instead
+	const bool dicom = (VolumeFileDicomFolder == format);
 
-
-void VtkToUnityAPI_OpenGLCoreES::SetTransferFunctionPoint(
-	const int transferFunctionIndex,
-	const double windowFraction,
-	const double red1,
-	const double green1,
-	const double blue1,
-	const double opacity1)
-{
-	if (transferFunctionIndex < 0 
-		|| transferFunctionIndex >= GetNTransferFunctions())
+	RawVolumeLayout layout;
+	if (!dicom &&
+		(!RawVolumeHeader::Read(format, path, layout) ||
+		!layout.compressed))
 	{
-		return;
+		LogToDebugLog(DebugLogLevel::DebugLogWarning,
+			std::string("BenchmarkVolumeReaders: not a compressed MetaImage or NRRD volume, or a DICOM folder ") + path);
+		return false;
 	}
 
-	auto& transferFunction =
-		mTransferFunctions[transferFunctionIndex];
+	// read the source every time, and narrow as a load would
+	VolumeLoadOptions options(mVolumeLoadOptions);
+	options.memoryMapped = false;
+	options.cacheEnabled = false;
 
-	// if there is an existing point, update it
-	// otherwise add a new point
-	const int windowFractionInt(WindowFractionDoubleToInteger(windowFraction));
-	auto &transferFunctionPointIter = transferFunction.find(windowFractionInt);
+	double seconds[2] = { 0.0, 0.0 };
+	const char *readerNames[2] = {
+		dicom ? "vtkDICOMImageReader" : "VTK reader",
+		dicom ? "parallel DICOM reader" : "pipelined inflate" };
+	unsigned long long dataBytes(0);
 
-	if (transferFunctionPointIter != transferFunction.end())
-	{
-		auto &colourArray = (*transferFunctionPointIter).second;
-		colourArray[sRedIndex] = red1;
-		colourArray[sGreenIndex] = green1;
-		colourArray[sBlueIndex] = blue1;
-		colourArray[sOpacityIndex] = opacity1;
-	}
-	else
+	for (int run = 0; run < nRuns; ++run)
 	{
-		transferFunction.insert(
-			VtkToUnityAPI_OpenGLCoreES::TransferFunctionPoint(
-				windowFractionInt,
-				{ { red1, green1, blue1, opacity1 } }));
-	}
+		for (int iReader = 0; iReader < 2; ++iReader)
+		{
+			options.pipelinedInflate = (!dicom && 1 == iReader);
+			options.parallelDicom = (dicom && 1 == iReader);
 
-	UpdateVolumeColorAndOpacity();
-}
+			const auto readStart = std::chrono::steady_clock::now();
+			VolumeRecord record;
+			vtkSmartPointer<vtkImageData> volumeImageData =
+				ReadVolumeFromSource(format, path, options, nullptr, record);
 
+			if (nullptr == volumeImageData)
+			{
+				LogToDebugLog(DebugLogLevel::DebugLogWarning,
+					std::string("BenchmarkVolumeReaders: ") + readerNames[iReader] + " failed on " + path);
+				return false;
+			}
 
-void VtkToUnityAPI_OpenGLCoreES::SetVolumeWWWL(const double windowWidth, const double windowLevel)
-{
-	mWindowWidth = windowWidth;
-	mWindowLevel = windowLevel;
-	UpdateVolumeColorAndOpacity();
-}
+			dataBytes = ScalarBytes(volumeImageData);
+			NarrowVolumeScalars(volumeImageData, options, record);
+			seconds[iReader] += SecondsSince(readStart);
+		}
+	}
 
+	const double dataMB = static_cast<double>(dataBytes) / (1 << 20);
 
-void VtkToUnityAPI_OpenGLCoreES::SetVolumeOpactityFactor(const double opacityFactor)
-{
-	mOpacityFactor = opacityFactor;
-	UpdateVolumeColorAndOpacity();
-}
+	for (int iReader = 0; iReader < 2; ++iReader)
+	{
+		const double meanSeconds = seconds[iReader] / std::max(1, nRuns);
 
+		std::stringstream timing;
+		timing << "BenchmarkVolumeReaders: " << readerNames[iReader] << " read " << dataMB
+			<< " MB in " << meanSeconds << " s (" << (dataMB / meanSeconds) << " MB/s), mean of "
+			<< nRuns << " runs";
+		LogToDebugLog(DebugLogLevel::DebugLog, timing.str());
+	}
 
-void VtkToUnityAPI_OpenGLCoreES::SetVolumeBrightnessFactor(const double brightnessFactor)
-{
-	mBrightnessFactor = brightnessFactor;
-	UpdateVolumeColorAndOpacity();
+	return true;
 }
 
 
-void VtkToUnityAPI_OpenGLCoreES::SetRenderComposite(const bool composite)
+bool VtkToUnityAPI_OpenGLCoreES::BenchmarkVolumeLoadMemory(
+	const std::string &folder,
+	const int sizeMB)
 {
-	for (auto & volumeMapperPair : mVolumeMappers)
+	struct ReaderPath
 	{
-		auto volumeMappersVector = volumeMapperPair.second;
+		const char *name;
+		VolumeFileFormat format;
+		std::string path;
+		bool memoryMapped;
+		bool pipelinedInflate;
+		bool parallelDicom;
+	};
+
+	const std::string rawPath = folder + "/memory_benchmark.mhd";
+	const std::string compressedPath = folder + "/memory_benchmark_compressed.mhd";
+	const std::string dicomPath = folder + "/memory_benchmark_dicom";
+
+	const ReaderPath readerPaths[] = {
+		{ "mapped", VolumeFileMhd, rawPath, true, false, false },
+		{ "pipelined inflate", VolumeFileMhd, compressedPath, false, true, false },
+		{ "parallel DICOM", VolumeFileDicomFolder, dicomPath, false, false, true },
+		{ "VTK reader", VolumeFileMhd, rawPath, false, false, false } };
+
+	// 16 bit slices of 512 x 512, two to the MB, released again before any is read
+	{
+		const std::array<int, 3> dimensions{ { 512, 512, std::max(1, 2 * sizeMB) } };
+		vtkSmartPointer<vtkImageData> phantomImageData = VolumePhantom::Generate(
+			VolumePhantomSpheres, dimensions.data(), VTK_SHORT, 0, 1);
+
+		if (nullptr == phantomImageData ||
+			!VolumePhantom::Write(phantomImageData, VolumeFileMhd, rawPath, false) ||
+			!VolumePhantom::Write(phantomImageData, VolumeFileMhd, compressedPath, true) ||
+			!VolumePhantom::Write(phantomImageData, VolumeFileDicomFolder, dicomPath, false))
+		{
+			LogToDebugLog(DebugLogLevel::DebugLogWarning,
+				std::string("BenchmarkVolumeLoadMemory: could not write the phantom volumes to ") + folder);
+			return false;
+		}
+	}
 
-		for (auto volumeMapper : volumeMappersVector)
+	for (const auto &readerPath : readerPaths)
+	{
+		// read the source every time, and narrow as a load would
+		VolumeLoadOptions options(mVolumeLoadOptions);
+		options.cacheEnabled = false;
+		options.memoryMapped = readerPath.memoryMapped;
+		options.pipelinedInflate = readerPath.pipelinedInflate;
+		options.parallelDicom = readerPath.parallelDicom;
+
+		const unsigned long long startBytes = ResidentMemorySampler::GetResidentBytes();
+		ResidentMemorySampler sampler;
+		sampler.Start();
+
+		VolumeRecord record;
+		vtkSmartPointer<vtkImageData> volumeImageData =
+			ReadVolumeFromSource(readerPath.format, readerPath.path, options, nullptr, record);
+		unsigned long long volumeBytes(0);
+
+		if (nullptr != volumeImageData)
 		{
-			if (volumeMapper)
+			volumeBytes = ScalarBytes(volumeImageData);
+
+			// as when the volume is first shown
+			if (record.reversePending)
 			{
-				if (composite)
-				{
-					volumeMapper->SetBlendModeToComposite();
-				}
-				else
-				{
-					volumeMapper->SetBlendModeToMaximumIntensity();
-				}
+				CopyScalarsReversedAlongZ(volumeImageData);
+				record.reversePending = false;
 			}
+
+			NarrowVolumeScalars(volumeImageData, options, record);
+		}
+
+		const unsigned long long peakBytes = sampler.Stop();
+
+		if (nullptr == volumeImageData ||
+			0 == volumeBytes)
+		{
+			LogToDebugLog(DebugLogLevel::DebugLogWarning,
+				std::string("BenchmarkVolumeLoadMemory: ") + readerPath.name + " failed on " + readerPath.path);
+			return false;
 		}
+
+		const double volumeMB = static_cast<double>(volumeBytes) / (1 << 20);
+		const double loadMB = static_cast<double>(peakBytes - std::min(peakBytes, startBytes)) / (1 << 20);
+
+		std::stringstream memory;
+		memory << "BenchmarkVolumeLoadMemory: " << readerPath.name << " load of a " << volumeMB
+			<< " MB volume peaked at " << loadMB << " MB resident over the "
+			<< (static_cast<double>(startBytes) / (1 << 20)) << " MB before it, "
+			<< (loadMB / volumeMB) << " times the volume";
+		LogToDebugLog(DebugLogLevel::DebugLog, memory.str());
 	}
+
+	return true;
 }
 
-void VtkToUnityAPI_OpenGLCoreES::SetTargetFrameRateOn(const bool targetOn)
+
+bool VtkToUnityAPI_OpenGLCoreES::CheckVolumeSeriesLoading(
+	const std::string &folder)
 {
-	for (auto & volumeMapperPair : mVolumeMappers)
+	// the series would otherwise have to match the volumes loaded
+	if (0 != GetNVolumes())
 	{
-		auto volumeMappersVector = volumeMapperPair.second;
+		LogToDebugLog(DebugLogLevel::DebugLogWarning,
+			"CheckVolumeSeriesLoading: clear the volumes before checking");
+		return false;
+	}
 
-		for (auto volumeMapper : volumeMappersVector)
+	struct SeriesFile
+	{
+		VolumeFileFormat format;
+		const char *fileName;
+		bool compressed;
+	};
+
+	// short frames, as CT is, in each format, the compressed NIfTI taking the VTK reader
+	const SeriesFile seriesFiles[] = {
+		{ VolumeFileDicomFolder, "series_dicom", false },
+		{ VolumeFileMhd, "series.mhd", false },
+		{ VolumeFileNrrd, "series.nrrd", true },
+		{ VolumeFileNifti, "series.nii.gz", true } };
+
+	const int nFrames(3);
+	const std::array<int, 3> dimensions{ { 64, 64, 32 } };
+	bool passed(true);
+
+	for (const auto &seriesFile : seriesFiles)
+	{
+		std::vector<std::string> paths;
+
+		for (int frame = 0; frame < nFrames; ++frame)
 		{
-			if (volumeMapper)
+			vtkSmartPointer<vtkImageData> phantomImageData = VolumePhantom::Generate(
+				VolumePhantomBeatingHeart, dimensions.data(), VTK_SHORT, frame, nFrames);
+			paths.push_back(VolumePhantom::FramePath(folder + "/" + seriesFile.fileName, frame, nFrames));
+
+			if (nullptr == phantomImageData ||
+				!VolumePhantom::Write(phantomImageData, seriesFile.format, paths.back(), seriesFile.compressed))
 			{
-				volumeMapper->SetAutoAdjustSampleDistances(targetOn);
+				LogToDebugLog(DebugLogLevel::DebugLogWarning,
+					std::string("CheckVolumeSeriesLoading: could not write ") + paths.back());
+				return false;
 			}
 		}
+
+		const bool loaded =
+			nFrames == LoadVolumeSeries(seriesFile.format, paths) &&
+			nFrames == GetNVolumes();
+
+		LogToDebugLog(loaded ? DebugLogLevel::DebugLog : DebugLogLevel::DebugLogError,
+			std::string("CheckVolumeSeriesLoading: ") + (loaded ? "loaded " : "failed to load ") +
+			seriesFile.fileName);
+
+		passed = passed && loaded;
+		ClearVolumes();
 	}
 
+	return passed;
 }
 
-void VtkToUnityAPI_OpenGLCoreES::SetTargetFrameRateFps(const int targetFps)
+
+void VtkToUnityAPI_OpenGLCoreES::SetVolumeMemoryBudgetMB(const int budgetMB)
 {
-	mRenderWindow->SetDesiredUpdateRate(targetFps);
+	mVolumeMemoryBudgetBytes = static_cast<unsigned long long>(std::max(0, budgetMB)) << 20;
+	EnforceVolumeMemoryBudget();
 }
 
-int VtkToUnityAPI_OpenGLCoreES::AddMPR(const int existingMprId, const int flipAxis)
+
+int VtkToUnityAPI_OpenGLCoreES::GetNResidentVolumes()
 {
-	// are we dealing with a new or existing MPR?
-	// - if new - create the reslice and its transform
-	// - if existing - use the existing reslice and its transform
-	auto existingResliceColors = mResliceColors.find(existingMprId);
+	return static_cast<int>(std::count_if(mVolumeRecords.begin(), mVolumeRecords.end(),
+		[](const VolumeRecord &record) { return !record.evicted; }));
+}
 
-	vtkSmartPointer<vtkImageMapToColors> resliceColor;
 
-	if (mResliceColors.end() == existingResliceColors)
-	{
-		auto resliceTransform = vtkSmartPointer<vtkTransform>::New();
-		resliceTransform->Identity();
+int VtkToUnityAPI_OpenGLCoreES::GetNEvictedVolumes()
+{
+	return GetNVolumes() - GetNResidentVolumes();
+}
 
-		// create a reslice object, make it 2D and associate it with the current volume
-		auto reslice = vtkSmartPointer<vtkImageReslice>::New();
-		reslice->SetOutputDimensionality(2);
-		reslice->SetInputData(mCurrentVolumeData);
-		reslice->SetResliceTransform(resliceTransform);
-		reslice->SetInterpolationModeToLinear();
 
-		// Map the image through the lookup table
-		resliceColor = vtkSmartPointer<vtkImageMapToColors>::New();
-		resliceColor->SetLookupTable(mResliceLookupTable);
+void VtkToUnityAPI_OpenGLCoreES::SetVolumeDeduplication(const bool deduplicate)
+{
+	mDeduplicateVolumes = deduplicate;
+}
 
-		if (0 > flipAxis)
-		{
-			resliceColor->SetInputConnection(reslice->GetOutputPort());
-		}
-		else
-		{
-			// try and flip this image
-			auto resliceFlip = vtkSmartPointer<vtkImageFlip>::New();
-			resliceFlip->SetFilteredAxis(flipAxis);
-			resliceFlip->SetInputConnection(reslice->GetOutputPort());
-			resliceColor->SetInputConnection(resliceFlip->GetOutputPort());
-		}
 
-		resliceColor->Update();
+int VtkToUnityAPI_OpenGLCoreES::GetNDistinctVolumes()
+{
+	std::set<vtkImageData*> distinctVolumes;
 
-		mReslice.insert(std::make_pair(mNextActorIndex, reslice));
-		mResliceTransforms.insert(std::make_pair(mNextActorIndex, resliceTransform));
-		mResliceColors.insert(std::make_pair(mNextActorIndex, resliceColor));
-	}
-	else
+	for (auto &volumeData : mVolumeDataVector)
 	{
-		resliceColor = (*existingResliceColors).second;
+		distinctVolumes.insert(volumeData.GetPointer());
 	}
 
-	// Display the image
-	auto resliceImageActor = vtkSmartPointer<vtkImageActor>::New();
-	resliceImageActor->SetInputData(resliceColor->GetOutput());
+	return static_cast<int>(distinctVolumes.size());
+}
 
-	mNonVolumeProp3Ds.insert(std::make_pair(mNextActorIndex, resliceImageActor));
-	mNonVolumePropTypes.insert(std::make_pair(mNextActorIndex, "vtkImageMapToColors"));
 
-	mRenderer->AddActor(resliceImageActor);
+void VtkToUnityAPI_OpenGLCoreES::SetVolumePyramids(const bool enabled)
+{
+	mVolumePyramidsOn = enabled;
 
-	return (mNextActorIndex++);
+	if (enabled)
+	{
+		QueueVolumePyramids();
+		return;
+	}
+
+	for (int iVolume = 0; iVolume < GetNVolumes(); ++iVolume)
+	{
+		ReleaseVolumePyramid(iVolume);
+	}
+
+	BindVolumeMasks();
 }
 
 
-void VtkToUnityAPI_OpenGLCoreES::SetMPRWWWL(const double windowWidth, 
-											const double windowLevel)
+int VtkToUnityAPI_OpenGLCoreES::GetNVolumePyramidLevels(const int volumeIndex)
 {
-	mResliceLookupTable->SetTableRange(
-		windowLevel - (0.5 * windowWidth),
-		windowLevel + (0.5 * windowWidth)); // image intensity range
-	mResliceLookupTable->Build();
+	if (volumeIndex < 0 ||
+		volumeIndex >= GetNVolumes())
+	{
+		return -1;
+	}
+
+	const auto &pyramid = mVolumeRecords[volumeIndex].pyramid;
+	return (nullptr != pyramid) ? pyramid->GetNBuiltLevels() : 1;
 }
 
 
-int VtkToUnityAPI_OpenGLCoreES::VtkResource_CallObject(
-	const LPCSTR classname,
-	const Float4 &color,
-	const bool wireframe)
+void VtkToUnityAPI_OpenGLCoreES::SetVolumeBrickSize(const int brickSize)
 {
-	vtkAlgorithm* pAlgo;
+	const int newBrickSize = std::max(0, brickSize);
 
-	vtkAdapter* pAdapter = vtkAdapterUtility::GetAdapter(classname);
-	if (pAdapter != NULL)
+	if (newBrickSize == mVolumeBrickSize)
 	{
-		pAlgo = (vtkAlgorithm*)pAdapter->NewInstance();
+		return;
 	}
-	else
+
+	// bricks of the old size are dropped, the new are built as volumes are shown or masked
+	mVolumeBrickSize = newBrickSize;
+	for (auto &record : mVolumeRecords)
 	{
-		pAlgo = (vtkAlgorithm*)VtkIntrospection::CreateObject(classname);
+		record.bricks.reset();
+		record.octree.reset();
 	}
 
-	pAlgo->Update();
+	if (mCurrentVolumeIndex >= 0)
+	{
+		UpdateVolumeBricks(mCurrentVolumeIndex);
+	}
 
-	vtkNew<vtkPolyDataMapper> mapper;
-	mapper->SetInputConnection(pAlgo->GetOutputPort());
+	UpdateVolumeCropping();
+}
 
-	vtkSmartPointer<vtkActor> actor = vtkSmartPointer<vtkActor>::New();
-	actor->SetMapper(mapper.GetPointer());
-	actor->GetProperty()->SetColor(color.x, color.y, color.z);
-	actor->GetProperty()->SetOpacity(color.w);
 
-	if (wireframe)
+int VtkToUnityAPI_OpenGLCoreES::GetNVolumeBricks(const int volumeIndex)
+{
+	if (volumeIndex < 0 ||
+		volumeIndex >= GetNVolumes() ||
+		nullptr == mVolumeRecords[volumeIndex].bricks)
 	{
-		actor->GetProperty()->SetRepresentationToWireframe();
+		return -1;
 	}
 
-	mNonVolumeProp3Ds.insert(std::make_pair(mNextActorIndex, actor));
-	mNonVolumePropObjects.insert(std::make_pair(mNextActorIndex, (vtkObjectBase *) pAlgo));
-	mNonVolumePropTypes.insert(std::make_pair(mNextActorIndex, classname));
-	mRenderer->AddActor(actor);
-
-	return (mNextActorIndex++);
+	return static_cast<int>(mVolumeRecords[volumeIndex].bricks->GetNBricks());
 }
 
 
-int VtkToUnityAPI_OpenGLCoreES::VtkResource_CallObject(
-	LPCSTR classname)
+int VtkToUnityAPI_OpenGLCoreES::GetNPaddingVolumeBricks(const int volumeIndex)
 {
-	vtkObjectBase *pResource = NULL;
-	vtkAdapter *pAdapter = vtkAdapterUtility::GetAdapter(classname);
-	if (pAdapter != NULL)
+	if (volumeIndex < 0 ||
+		volumeIndex >= GetNVolumes() ||
+		nullptr == mVolumeRecords[volumeIndex].bricks)
 	{
-		pResource = pAdapter->NewInstance();
+		return -1;
 	}
-	else
-	{
-		pResource = VtkIntrospection::CreateObject(classname);
-		if (pResource == NULL)
-		{
-			return -1;
-		}
+
+	return static_cast<int>(mVolumeRecords[volumeIndex].bricks->GetNPaddingBricks());
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::SetVolumeStreaming(const int poolSize)
+{
+	mVolumeStreamingPoolSize = std::max(0, poolSize);
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::SetEmptySpaceCropping(const bool cropping)
+{
+	mEmptySpaceCropping = cropping;
+	UpdateVolumeCropping();
+}
+
+
+bool VtkToUnityAPI_OpenGLCoreES::ProbeVolume(
+	const std::array<double, 3> &positionM,
+	double &value,
+	double &opacity)
+{
+	if (mCurrentVolumeIndex < 0 ||
+		mVolumeRecords[mCurrentVolumeIndex].evicted)
+	{
+		return false;
 	}
 
-	mNonVolumePropObjects.insert(std::make_pair(mNextActorIndex, pResource));
-	mNonVolumePropTypes.insert(std::make_pair(mNextActorIndex, classname));
-	return mNextActorIndex++;
+	vtkImageData *volumeImageData = mVolumeDataVector[mCurrentVolumeIndex];
+	const VolumeRecord &record = mVolumeRecords[mCurrentVolumeIndex];
+
+	// the nearest voxel
+	std::array<int, 3> voxel;
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		voxel[axis] = static_cast<int>(std::floor(
+			((positionM[axis] - mVolumeCentre[axis]) / mVolumeSpacingM[axis]) + 0.5));
+
+		if (voxel[axis] < mVolumeExtent[2 * axis] ||
+			voxel[axis] > mVolumeExtent[(2 * axis) + 1])
+		{
+			return false;
+		}
+	}
+
+	const double storedValue = volumeImageData->GetScalarComponentAsDouble(voxel[0], voxel[1], voxel[2], 0);
+	value = (storedValue * record.rescaleSlope) + record.rescaleIntercept;
+
+	// a brick the transfer function leaves transparent needs no look up
+	const VolumeOctree::ScalarIntervals visibleScalars = GetVisibleScalarIntervals();
+	const bool visibleBrick = (nullptr == record.octree) ||
+		record.octree->IsBrickVisible(record.bricks->GetBrickIndex(
+			voxel[0] - mVolumeExtent[0], voxel[1] - mVolumeExtent[2], voxel[2] - mVolumeExtent[4]),
+			visibleScalars, mPaddingMaskOn);
+
+	opacity = (visibleBrick && VolumeOctree::IsVisibleScalar(storedValue, visibleScalars))
+		? mVolumeOpacity->GetValue(storedValue)
+		: 0.0;
+	return true;
 }
 
 
-LPCSTR VtkToUnityAPI_OpenGLCoreES::VtkResource_CallMethodAsString(
-	const int rid,
-	LPCSTR method,
-	LPCSTR format,
-	const char *const *argv)
+bool VtkToUnityAPI_OpenGLCoreES::CastRayIntoVolume(
+	const std::array<double, 3> &originM,
+	const std::array<double, 3> &directionM,
+	std::array<double, 3> &hitM)
 {
-	/* Getting VTK object */
-	auto objectIter = mNonVolumePropObjects.find(rid);
-	if (mNonVolumePropObjects.end() != objectIter)
+	if (mCurrentVolumeIndex < 0 ||
+		mVolumeRecords[mCurrentVolumeIndex].evicted)
 	{
-		vtkObjectBase *pObject = objectIter->second;
+		return false;
+	}
 
-		/* Generating arguments */
-		std::vector<vtkObjectBase *> refs;
-		std::vector<LPCSTR> vals;
-		VtkArgs_Prepare(format, argv, refs, vals);
+	const VolumeRecord &record = mVolumeRecords[mCurrentVolumeIndex];
+	UpdateVolumeBricks(mCurrentVolumeIndex);
 
-		/* Getting the string representation */
-		return _strdup(VtkIntrospection::CallMethod_AsString(pObject, method, format, refs, vals));
+	if (nullptr == record.octree)
+	{
+		LogToDebugLog(DebugLogLevel::DebugLogWarning,
+			"CastRayIntoVolume: the volume has no bricks, see SetVolumeBrickSize");
+		return false;
 	}
-	else
+
+	// the same ray parameter in voxels from the first, and in m
+	std::array<double, 3> origin;
+	std::array<double, 3> direction;
+	for (int axis = 0; axis < 3; ++axis)
 	{
-		return NULL;
+		origin[axis] = ((originM[axis] - mVolumeCentre[axis]) / mVolumeSpacingM[axis]) - mVolumeExtent[2 * axis];
+		direction[axis] = directionM[axis] / mVolumeSpacingM[axis];
+	}
+
+	double hitT(0.0);
+	if (!record.octree->CastRay(mVolumeDataVector[mCurrentVolumeIndex], origin, direction,
+		GetVisibleScalarIntervals(), mPaddingMaskOn, hitT))
+	{
+		return false;
 	}
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		hitM[axis] = originM[axis] + (hitT * directionM[axis]);
+	}
+
+	return true;
 }
 
-int VtkToUnityAPI_OpenGLCoreES::VtkResource_CallMethodAsVtkObject(
-	const int rid,
-	LPCSTR method,
-	LPCSTR format,
-	LPCSTR classname,
-	const char *const *argv)
+
+bool VtkToUnityAPI_OpenGLCoreES::GetVolumeStatistics(
+	const int volumeIndex,
+	const bool maskedOnly,
+	const int nBins,
+	double *statistics,
+	double *histogram)
 {
-	/* Getting VTK object */
-	auto objectIter = mNonVolumePropObjects.find(rid);
-	if (mNonVolumePropObjects.end() != objectIter)
+	if (volumeIndex < 0 ||
+		volumeIndex >= GetNVolumes() ||
+		nBins < 1)
 	{
-		vtkObjectBase *pObject = objectIter->second;
+		LogToDebugLog(DebugLogLevel::DebugLogWarning,
+			"GetVolumeStatistics: no such volume, or no histogram bins");
+		return false;
+	}
 
-		/* Generating arguments */
-		std::vector<vtkObjectBase *> refs;
-		std::vector<LPCSTR> vals;
-		VtkArgs_Prepare(format, argv, refs, vals);
-		
-		/* Getting resulting VTK Object */
-		vtkObjectBase *pReturnObject = VtkIntrospection::CallMethod_AsVtkObject(
-			pObject, method, format, classname, refs, vals);
+	VolumeRecord &record = mVolumeRecords[volumeIndex];
+	std::shared_ptr<VolumeStatistics> &cachedStatistics =
+		maskedOnly ? record.maskedStatistics : record.statistics;
 
-		if (pReturnObject != NULL)
+	if (nullptr == cachedStatistics ||
+		cachedStatistics->GetNBins() != nBins)
+	{
+		if (record.evicted)
 		{
-			/* Checking if the object is already registered */
-			for (auto iEntry : mNonVolumePropObjects)
+			LogToDebugLog(DebugLogLevel::DebugLogWarning,
+				"GetVolumeStatistics: the volume is evicted, show it first");
+			return false;
+		}
+
+		const PackedVolumeMask *mask(nullptr);
+		if (maskedOnly)
+		{
+			if (!mPaddingMaskOn)
 			{
-				if (iEntry.second == pReturnObject)
-				{
-					return iEntry.first;
-				}
+				LogToDebugLog(DebugLogLevel::DebugLogWarning,
+					"GetVolumeStatistics: no padding mask, call CreatePaddingMask first");
+				return false;
 			}
 
-			/* Object not yet registered */
-			mNonVolumePropObjects.insert(std::make_pair(mNextActorIndex, pReturnObject));
-			mNonVolumePropTypes.insert(std::make_pair(mNextActorIndex, classname));
-			return mNextActorIndex++;
+			// the mask is in display order, only the order of the counted voxels matters
+			if (record.reversePending)
+			{
+				CopyScalarsReversedAlongZ(mVolumeDataVector[volumeIndex]);
+				record.reversePending = false;
+				QueueVolumePyramid(volumeIndex);
+			}
+
+			UpdateVolumePaddingMask(volumeIndex);
+			mask = record.paddingMask.get();
 		}
-		else
+
+		const auto statisticsStart = std::chrono::steady_clock::now();
+		cachedStatistics = VolumeStatistics::Compute(mVolumeDataVector[volumeIndex], mask, nBins);
+
+		if (nullptr == cachedStatistics ||
+			(maskedOnly && nullptr == mask))
 		{
-			return -1;
+			cachedStatistics.reset();
+			LogToDebugLog(DebugLogLevel::DebugLogWarning,
+				"GetVolumeStatistics: could not compute the statistics");
+			return false;
 		}
+
+		SyncSharedVolumes(volumeIndex);
+
+		std::stringstream timing;
+		timing << "GetVolumeStatistics: computed in " << SecondsSince(statisticsStart) << " s";
+		LogToDebugLog(DebugLogLevel::DebugLog, timing.str());
+	}
+
+	cachedStatistics->Fill(record.rescaleSlope, record.rescaleIntercept, statistics, histogram);
+	return true;
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::SetPropVolumeLevel(const int propId, const int level)
+{
+	if (level <= 0)
+	{
+		mPropVolumeLevels.erase(propId);
 	}
 	else
 	{
-		return -1;
+		mPropVolumeLevels[propId] = std::min(level, VolumePyramid::sNLevels - 1);
 	}
+
+	ApplyPropVolumeLevels();
 }
 
-void VtkToUnityAPI_OpenGLCoreES::VtkResource_CallMethodAsVoid(
-	const int rid,
-	LPCSTR method,
-	LPCSTR format,
-	const char *const *argv)
+
+void VtkToUnityAPI_OpenGLCoreES::SetVolumeCacheEnabled(const bool enabled)
 {
-	/* Getting VTK object */
-	auto objectIter = mNonVolumePropObjects.find(rid);
-	if (mNonVolumePropObjects.end() != objectIter)
-	{
-		vtkObjectBase *pObject = objectIter->second;
+	mVolumeLoadOptions.cacheEnabled = enabled;
+}
 
-		/* Generating arguments */
-		std::vector<vtkObjectBase *> refs;
-		std::vector<LPCSTR> vals;
-		VtkArgs_Prepare(format, argv, refs, vals);
 
-		/* Calling method */
-		VtkIntrospection::CallMethod_AsVoid(pObject, method, format, refs, vals);
+void VtkToUnityAPI_OpenGLCoreES::SetVolumeCacheFolder(const std::string &folder)
+{
+	mVolumeLoadOptions.cacheFolder = folder;
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::SetVolumeCacheSizeLimitMB(const int sizeLimitMB)
+{
+	mVolumeLoadOptions.cacheMaxBytes =
+		static_cast<unsigned long long>(std::max(0, sizeLimitMB)) << 20;
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::ClearVolumeCache()
+{
+	VolumeCache::Clear(mVolumeLoadOptions.cacheFolder);
+}
+
+
+int VtkToUnityAPI_OpenGLCoreES::LoadVolumeAsync(
+	const VolumeFileFormat format,
+	const std::string &path)
+{
+	const VolumeLoadOptions options = mVolumeLoadOptions;
+
+	return mVolumeLoads.Enqueue(
+		[this, format, path, options](
+			LoadProgress &progress,
+			VolumeRecord &record,
+			const VolumeLoadQueue::PreviewFunction &publishPreview) -> vtkSmartPointer<vtkImageData>
+		{
+			// a cached volume maps at once, there is nothing to preview
+			double rescaleSlope;
+			double rescaleIntercept;
+			const bool cached = options.cacheEnabled &&
+				nullptr != VolumeCache::Find(options.cacheFolder, path, rescaleSlope, rescaleIntercept);
+
+			if (options.progressive && !cached)
+			{
+				progress.SetRange(0.0f, sPreviewProgressFraction);
+
+				vtkSmartPointer<vtkImageData> fullGeometry;
+				vtkSmartPointer<vtkImageData> previewImageData =
+					VolumePreview::Read(format, path, options.previewStride, fullGeometry);
+
+				if (nullptr != previewImageData &&
+					!progress.IsCancelled())
+				{
+					publishPreview(previewImageData, fullGeometry);
+				}
+
+				progress.SetRange(sPreviewProgressFraction, 1.0f);
+			}
+
+			vtkSmartPointer<vtkImageData> volumeImageData =
+				ReadVolumeFile(format, path, options, &progress, record);
+
+			if (progress.IsCancelled())
+			{
+				return nullptr;
+			}
+
+			return volumeImageData;
+		});
+}
+
+
+float VtkToUnityAPI_OpenGLCoreES::GetVolumeLoadProgress(const int ticket)
+{
+	return mVolumeLoads.GetProgress(ticket);
+}
+
+
+VolumeLoadStatus VtkToUnityAPI_OpenGLCoreES::GetVolumeLoadStatus(const int ticket)
+{
+	return mVolumeLoads.GetStatus(ticket);
+}
+
+
+int VtkToUnityAPI_OpenGLCoreES::GetVolumeLoadIndex(const int ticket)
+{
+	return mVolumeLoads.GetVolumeIndex(ticket);
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::CancelVolumeLoad(const int ticket)
+{
+	mVolumeLoads.Cancel(ticket);
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::UpdateVolumeLoads()
+{
+	mVolumeLoads.CommitLoaded(
+		[this](vtkSmartPointer<vtkImageData> previewImageData, vtkSmartPointer<vtkImageData> fullGeometry)
+		{
+			// the extents reported are those of the full volume, the preview is stretched over them
+			if (!CheckVolumeExtentSpacingOrigin(fullGeometry))
+			{
+				LogToDebugLog(DebugLogLevel::DebugLogWarning,
+					"UpdateVolumeLoads: volume preview does not match the existing volumes");
+				return -1;
+			}
+
+			VolumePreview::FitToGeometry(previewImageData, fullGeometry);
+			AddVolume(previewImageData, VolumeRecord(), false);
+			return GetNVolumes() - 1;
+		},
+		[this](vtkSmartPointer<vtkImageData> volumeImageData, const VolumeRecord &record, const int previewIndex)
+		{
+			if (!CheckVolumeExtentSpacingOrigin(volumeImageData))
+			{
+				LogToDebugLog(DebugLogLevel::DebugLogWarning,
+					"UpdateVolumeLoads: loaded volume does not match the existing volumes");
+				return -1;
+			}
+
+			if (previewIndex < 0)
+			{
+				AddVolume(volumeImageData, record);
+				return GetNVolumes() - 1;
+			}
+
+			// refine the preview in place, so its index and the props and reslices using it are kept
+			VolumeRecord &previewRecord = mVolumeRecords[previewIndex];
+			if (!previewRecord.spillPath.empty())
+			{
+				VolumeSpill::Remove(previewRecord.spillPath);
+			}
+
+			// the preview's levels are built from the preview's voxels
+			ReleaseVolumePyramid(previewIndex);
+
+			const unsigned long long lastShown = previewRecord.lastShown;
+			mVolumeDataVector[previewIndex]->ShallowCopy(volumeImageData);
+			previewRecord = record;
+			previewRecord.lastShown = lastShown;
+
+			if (previewIndex == mCurrentVolumeIndex)
+			{
+				mCurrentVolumeIndex = -1;
+				SetVolumeIndex(previewIndex);
+			}
+			else
+			{
+				QueueVolumePyramid(previewIndex);
+				EnforceVolumeMemoryBudget();
+			}
+
+			return previewIndex;
+		});
+
+	// levels finished since the last frame are picked up by the props waiting on them
+	if (!mPropVolumeLevels.empty() ||
+		(mInMotion && mMotionVolumeLevel > 0))
+	{
+		ApplyPropVolumeLevels();
 	}
 }
 
-LPCSTR VtkToUnityAPI_OpenGLCoreES::VtkResource_CallMethodPipedAsString(
-	const int rid,
-	const int methodc,
-	const int formatc,
-	const char *const *methodv,
-	const char *const *formatv,
-	const char *const *argv)
+
+bool VtkToUnityAPI_OpenGLCoreES::CreatePaddingMask(int paddingValue)
 {
-	/* Getting VTK object */
-	auto objectIter = mNonVolumePropObjects.find(rid);
-	if (mNonVolumePropObjects.end() != objectIter)
+	// return if we have already generated the masks
+	if (mPaddingMaskOn)
 	{
-		vtkObjectBase *pObject = objectIter->second;
+		return false;
+	}
 
-		/* Generating arguments */
-		std::vector<vtkObjectBase *> refs;
-		std::vector<LPCSTR> vals;
-		std::vector<LPCSTR> mtds(methodv, methodv + methodc);
-		std::vector<LPCSTR> fmts(formatv, formatv + formatc);
-		VtkArgs_PreparePiped(formatc, formatv, argv, refs, vals);
+	mPaddingMaskOn = true;
+	mPaddingMaskValue = paddingValue;
 
-		/* Getting the string representation */
-		return VtkIntrospection::CallMethodPiped_AsString(pObject, mtds, fmts, refs, vals);
+	// every frame of a series is masked on its own voxels, evicted and not yet
+	// reversed volumes are masked when they are next shown
+	for (int iVolume = 0; iVolume < GetNVolumes(); ++iVolume)
+	{
+		UpdateVolumePaddingMask(iVolume);
 	}
-	else
+
+	if (mCurrentVolumeIndex >= 0)
 	{
-		return NULL;
+		const auto &mask = mVolumeRecords[mCurrentVolumeIndex].paddingMask;
+		mCurrentVolumeMask = (nullptr != mask)
+			? mask->Expand(mVolumeDataVector[mCurrentVolumeIndex])
+			: nullptr;
 	}
+
+	BindVolumeMasks();
+	UpdateVolumeCropping();
+	return true;
 }
 
-int VtkToUnityAPI_OpenGLCoreES::VtkResource_CallMethodPipedAsVtkObject(
-	const int rid,
-	const int methodc,
-	const int formatc,
-	LPCSTR classname,
-	const char *const *methodv,
-	const char *const *formatv,
-	const char *const *argv)
+
+void VtkToUnityAPI_OpenGLCoreES::ClearVolumes()
 {
-	/* Getting VTK object */
-	auto objectIter = mNonVolumePropObjects.find(rid);
-	if (mNonVolumePropObjects.end() != objectIter)
+	// pending loads would otherwise be added after the clear
+	mVolumeLoads.CancelAll();
+
+	for (int iVolume = 0; iVolume < GetNVolumes(); ++iVolume)
 	{
-		vtkObjectBase *pObject = objectIter->second;
+		ReleaseVolumePyramid(iVolume);
+	}
 
-		/* Generating arguments */
-		std::vector<vtkObjectBase *> refs;
-		std::vector<LPCSTR> vals;
+	RemoveVolumeSpills();
+	mVolumeDataVector.clear();
+	mVolumeRecords.clear();
+	mPaddingMaskOn = false;
+	SetVolumeIndex(-1);
+}
+
+
+int VtkToUnityAPI_OpenGLCoreES::GetNVolumes()
+{
+	return static_cast<int>(mVolumeDataVector.size());
+}
+
+
+Float4 VtkToUnityAPI_OpenGLCoreES::GetVolumeSpacingM()
+{
+	return StdArray3ToFloat4(mVolumeSpacingM);
+}
+
+
+Float4 VtkToUnityAPI_OpenGLCoreES::GetVolumeExtentsMin()
+{
+	return StdArray3ToFloat4(mVolumeExtentMin);
+}
+
+
+Float4 VtkToUnityAPI_OpenGLCoreES::GetVolumeExtentsMax()
+{
+	return StdArray3ToFloat4(mVolumeExtentMax);
+}
+
+Float4 VtkToUnityAPI_OpenGLCoreES::GetVolumeOriginM()
+{
+	return StdArray3ToFloat4(mVolumeOriginCentredM);
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::SetVolumeIndex(
+	const int index)
+{
+	int newIndex = index;
+	// This may be an odd looking set of if/else, but...
+	// if the index is invalid, show the synthetic volume, indicated by 
+	if (newIndex < 0 ||
+		newIndex >= mVolumeDataVector.size())
+	{
+		newIndex = -1;
+	}
+
+	if (newIndex ==-1 )
+	{
+		// if the index is invalid, show the synthetic volume
+		mCurrentVolumeData->ShallowCopy(mSyntheticVolumeData.GetPointer());
+		mCurrentVolumeIndex = -1;
+		UpdateScalarRescale();
+		mCurrentVolumeMask = nullptr;
+		BindVolumeMasks();
+		return;
+	}
+
+	if (newIndex == mCurrentVolumeIndex)
+	{
+		// if the index is valid but unchanged, so we don't need to update the 
+		// current volume data
+		return;
+	}
+
+	VolumeRecord &record = mVolumeRecords[newIndex];
+	if (record.evicted &&
+		!RestoreVolume(newIndex))
+	{
+		LogToDebugLog(DebugLogLevel::DebugLogWarning,
+			"SetVolumeIndex: could not read the evicted volume back, showing the synthetic volume");
+		SetVolumeIndex(-1);
+		return;
+	}
+
+	if (record.reversePending)
+	{
+		CopyScalarsReversedAlongZ(mVolumeDataVector[newIndex]);
+		record.reversePending = false;
+	}
+
+	UpdateVolumeBricks(newIndex);
+	QueueVolumePyramid(newIndex);
+
+	mCurrentVolumeIndex = newIndex;
+	mCurrentVolumeData->ShallowCopy(mVolumeDataVector[newIndex]);
+	UpdateStreamingVolumeProps();
+	UpdateScalarRescale();
+
+	// only the shown volume's mask is expanded for upload
+	UpdateVolumePaddingMask(newIndex);
+	mCurrentVolumeMask = (nullptr != record.paddingMask)
+		? record.paddingMask->Expand(mVolumeDataVector[newIndex])
+		: nullptr;
+	BindVolumeMasks();
+	UpdateVolumeCropping();
+
+	record.lastShown = ++mVolumeShowCounter;
+	SyncSharedVolumes(newIndex);
+	EnforceVolumeMemoryBudget();
+
+	for (auto volumePropsVectorPair : mVolumeProp3Ds)
+	{
+		auto volumePropsVector = volumePropsVectorPair.second;
+
+		// volumes sharing voxels share a prop, so it is shown if any of them is current
+		for (int iVolumeProp = 0; iVolumeProp < volumePropsVector.size(); ++iVolumeProp)
+		{
+			volumePropsVector[iVolumeProp]->SetVisibility(
+				mCurrentVolumeIndex < volumePropsVector.size() &&
+				volumePropsVector[iVolumeProp] == volumePropsVector[mCurrentVolumeIndex]);
+		}
+	}
+
+	// update all of the reslices, is all of this really necessary?
+	for (auto & reslicePair : mReslice)
+	{
+		auto id = reslicePair.first;
+		auto reslice = reslicePair.second;
+
+		auto resliceTransformIter = mResliceTransforms.find(id);
+		auto resliceColorIter = mResliceColors.find(id);
+
+		if (resliceTransformIter != mResliceTransforms.end() &&
+			resliceColorIter != mResliceColors.end())
+		{
+			reslice->RemoveAllInputs();
+			reslice->SetInputData(GetResliceInput(id));
+			reslice->SetResliceTransform((*resliceTransformIter).second);
+			reslice->SetInterpolationModeToLinear();
+			reslice->Update();
+
+			(*resliceColorIter).second->Update();
+		}
+	}
+}
+
+
+int VtkToUnityAPI_OpenGLCoreES::AddVolumeProp()
+{
+	if (mVolumeStreamingPoolSize > 0)
+	{
+		return AddStreamingVolumeProp();
+	}
+
+	// We need a volume mapper for each volume prop as the clipping planes are 
+	// attached to the volume mapper
+	std::vector<vtkSmartPointer<vtkProp3D>> volumePropsVector;
+	volumePropsVector.reserve(GetNVolumes());
+	std::vector<vtkSmartPointer<vtkGPUVolumeRayCastMapper>> volumeMappersVector;
+	volumeMappersVector.reserve(GetNVolumes());
+	vtkTypeBool visibility(true);
+	std::map<vtkImageData*, size_t> firstVolumeIndices;
+
+	for (auto volumeData : mVolumeDataVector)
+	{
+		// volumes sharing voxels share the mapper, and so the texture, too
+		auto firstVolumeIndex = firstVolumeIndices.insert(
+			std::make_pair(volumeData.GetPointer(), volumeMappersVector.size()));
+
+		if (!firstVolumeIndex.second)
+		{
+			volumePropsVector.push_back(volumePropsVector[firstVolumeIndex.first->second]);
+			volumeMappersVector.push_back(volumeMappersVector[firstVolumeIndex.first->second]);
+			continue;
+		}
+
+		auto volumeMapper = CreateVolumeMapper(volumeData);
+
+		// each volume's mapper takes its own mask, the hidden volumes' are bound when shown
+		if (mCurrentVolumeIndex >= 0 &&
+			mVolumeDataVector[mCurrentVolumeIndex] == volumeData &&
+			nullptr != mCurrentVolumeMask)
+		{
+			volumeMapper->SetMaskInput(mCurrentVolumeMask);
+			volumeMapper->SetMaskTypeToBinary();
+		}
+
+		// connect up the volume to the property and the mapper
+		auto volumeProp = vtkSmartPointer<vtkVolume>::New();
+		volumeProp->SetProperty(mVolumeProperty.GetPointer());
+		volumeProp->SetVisibility(visibility);
+		visibility = false;
+		volumeProp->SetMapper(volumeMapper);
+
+		volumePropsVector.push_back(volumeProp);
+		volumeMappersVector.push_back(volumeMapper);
+		mRenderer->AddViewProp(volumeProp);
+	}
+
+	mVolumeProp3Ds.insert(std::make_pair(mNextActorIndex, volumePropsVector));
+	mVolumeMappers.insert(std::make_pair(mNextActorIndex, volumeMappersVector));
+	UpdateVolumeCropping();
+
+	return (mNextActorIndex++);
+}
+
+
+vtkSmartPointer<vtkGPUVolumeRayCastMapper> VtkToUnityAPI_OpenGLCoreES::CreateVolumeMapper(
+	vtkImageData *inputImageData)
+{
+	auto volumeMapper = vtkSmartPointer<vtkGPUVolumeRayCastMapper>::New();
+	volumeMapper->SetBlendModeToComposite();
+
+	if (nullptr != inputImageData)
+	{
+		volumeMapper->SetInputData(inputImageData);
+		volumeMapper->Update();
+	}
+
+	// we need to scale the volume mapper steps as we scale the data by a 
+	// factor of 1000 to account for mm to m as the base unit
+	volumeMapper->SetSampleDistance(static_cast<float>(
+		volumeMapper->GetSampleDistance() * sMmToMConversion * mAppliedSampleDistanceScale));
+	volumeMapper->SetImageSampleDistance(static_cast<float>(mAppliedImageSampleDistance));
+	volumeMapper->SetAutoAdjustSampleDistances(
+		!mAdaptiveSamplingOn && !mInMotion && mAutoAdjustSampleDistances);
+
+	return volumeMapper;
+}
+
+
+int VtkToUnityAPI_OpenGLCoreES::AddStreamingVolumeProp()
+{
+	// the pool mappers are made up front without volumes, so the crop planes and
+	// blend modes given to the prop reach all of them
+	StreamingVolumeProp streamingProp;
+	streamingProp.volumeProp = vtkSmartPointer<vtkVolume>::New();
+	streamingProp.volumeProp->SetProperty(mVolumeProperty.GetPointer());
+	streamingProp.showCounter = 0;
+
+	for (int iMapper = 0; iMapper < mVolumeStreamingPoolSize; ++iMapper)
+	{
+		streamingProp.mappers.push_back(CreateVolumeMapper(nullptr));
+		streamingProp.mapperLastShown.push_back(0);
+	}
+
+	const size_t nEntries = std::max(
+		static_cast<size_t>(GetNVolumes()), streamingProp.mappers.size());
+	std::vector<vtkSmartPointer<vtkProp3D>> volumePropsVector(nEntries, streamingProp.volumeProp);
+	std::vector<vtkSmartPointer<vtkGPUVolumeRayCastMapper>> volumeMappersVector(nEntries);
+	for (size_t iEntry = 0; iEntry < nEntries; ++iEntry)
+	{
+		volumeMappersVector[iEntry] = streamingProp.mappers[iEntry % streamingProp.mappers.size()];
+	}
+
+	streamingProp.volumeProp->SetMapper(streamingProp.mappers.front());
+	streamingProp.volumeProp->SetVisibility(mCurrentVolumeIndex >= 0);
+	mRenderer->AddViewProp(streamingProp.volumeProp);
+
+	mVolumeProp3Ds.insert(std::make_pair(mNextActorIndex, volumePropsVector));
+	mVolumeMappers.insert(std::make_pair(mNextActorIndex, volumeMappersVector));
+	mStreamingVolumeProps.insert(std::make_pair(mNextActorIndex, streamingProp));
+
+	// loads the current volume into the first pool mapper
+	UpdateStreamingVolumeProps();
+	BindVolumeMasks();
+	UpdateVolumeCropping();
+
+	return (mNextActorIndex++);
+}
+
+
+int VtkToUnityAPI_OpenGLCoreES::AddCropPlaneToVolume(const int volumeId)
+{
+	// Let's just check that we have a volume mapper to apply the croping plane to
+	auto mapperIter = mVolumeMappers.find(volumeId);
+
+	if (mVolumeMappers.end() == mapperIter)
+	{
+		return -1;
+	}
+
+	auto volumeMappersVector = (*mapperIter).second;
+
+	// so create the plane and add it to the mapper
+	auto volumeCropPlane = vtkSmartPointer<vtkPlane>::New();
+	mVolumeCropPlanes.insert(std::make_pair(mNextActorIndex, volumeCropPlane));
+
+	// a mapper shared by volumes with the same voxels takes the plane once
+	std::set<vtkGPUVolumeRayCastMapper*> croppedMappers;
+
+	for (auto volumeMapper : volumeMappersVector)
+	{
+		if (NULL == volumeMapper)
+		{
+			return -1;
+		}
+
+		if (croppedMappers.insert(volumeMapper.GetPointer()).second)
+		{
+			volumeMapper->AddClippingPlane(volumeCropPlane.GetPointer());
+		}
+	}
+
+	return (mNextActorIndex++);
+}
+
+
+int VtkToUnityAPI_OpenGLCoreES::GetNTransferFunctions()
+{
+	return static_cast<int>(mTransferFunctions.size());
+}
+
+
+int VtkToUnityAPI_OpenGLCoreES::GetTransferFunctionIndex()
+{
+	return static_cast<int>(mTransferFunctionIndex);
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::SetTransferFunctionIndex(const int index)
+{
+	if (index < 0 || index >= GetNTransferFunctions())
+	{
+		return;
+	}
+
+	mTransferFunctionIndex = index;
+	mTransferFunctionDirty = true;
+}
+
+
+int VtkToUnityAPI_OpenGLCoreES::AddTransferFunction()
+{
+	mTransferFunctions.push_back(InitialiseGreyLinear());
+	return static_cast<int>(mTransferFunctions.size() - 1);
+}
+
+
+int VtkToUnityAPI_OpenGLCoreES::ResetTransferFunctions()
+{
+	mTransferFunctions.clear();
+	mTransferFunctionIndex = AddTransferFunction();
+	mTransferFunctionDirty = true;
+	return mTransferFunctionIndex;
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::SetTransferFunctionPoint(
+	const int transferFunctionIndex,
+	const double windowFraction,
+	const double red1,
+	const double green1,
+	const double blue1,
+	const double opacity1)
+{
+	SetTransferFunctionPoints(
+		transferFunctionIndex,
+		1,
+		&windowFraction,
+		&red1,
+		&green1,
+		&blue1,
+		&opacity1);
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::SetTransferFunctionPoints(
+	const int transferFunctionIndex,
+	const int nPoints,
+	const double *windowFractions,
+	const double *reds,
+	const double *greens,
+	const double *blues,
+	const double *opacities)
+{
+	if (transferFunctionIndex < 0 
+		|| transferFunctionIndex >= GetNTransferFunctions())
+	{
+		return;
+	}
+
+	auto& transferFunction =
+		mTransferFunctions[transferFunctionIndex];
+
+	for (int iPoint = 0; iPoint < nPoints; ++iPoint)
+	{
+		// if there is an existing point, update it
+		// otherwise add a new point
+		const int windowFractionInt(WindowFractionDoubleToInteger(windowFractions[iPoint]));
+		const std::array<double, 4> colour{ { reds[iPoint], greens[iPoint], blues[iPoint], opacities[iPoint] } };
+		auto transferFunctionPointIter = transferFunction.find(windowFractionInt);
+
+		if (transferFunctionPointIter != transferFunction.end())
+		{
+			(*transferFunctionPointIter).second = colour;
+		}
+		else
+		{
+			transferFunction.insert(
+				VtkToUnityAPI_OpenGLCoreES::TransferFunctionPoint(
+					windowFractionInt,
+					colour));
+		}
+	}
+
+	// editing a hidden transfer function leaves the shown one alone
+	if (transferFunctionIndex == mTransferFunctionIndex)
+	{
+		mTransferFunctionDirty = true;
+	}
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::SetVolumeWWWL(const double windowWidth, const double windowLevel)
+{
+	mWindowWidth = windowWidth;
+	mWindowLevel = windowLevel;
+	mVolumeWindowDirty = true;
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::SetVolumeOpactityFactor(const double opacityFactor)
+{
+	mOpacityFactor = opacityFactor;
+	mTransferFunctionDirty = true;
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::SetVolumeBrightnessFactor(const double brightnessFactor)
+{
+	mBrightnessFactor = brightnessFactor;
+	mTransferFunctionDirty = true;
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::UpdateTransferFunction()
+{
+	if (mTransferFunctionDirty)
+	{
+		UpdateVolumeColorAndOpacity();
+	}
+	else if (mVolumeWindowDirty)
+	{
+		UpdateVolumeWindow(false);
+	}
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::SetRenderComposite(const bool composite)
+{
+	for (auto & volumeMapperPair : mVolumeMappers)
+	{
+		auto volumeMappersVector = volumeMapperPair.second;
+
+		for (auto volumeMapper : volumeMappersVector)
+		{
+			if (volumeMapper)
+			{
+				if (composite)
+				{
+					volumeMapper->SetBlendModeToComposite();
+				}
+				else
+				{
+					volumeMapper->SetBlendModeToMaximumIntensity();
+				}
+			}
+		}
+	}
+}
+
+void VtkToUnityAPI_OpenGLCoreES::SetTargetFrameRateOn(const bool targetOn)
+{
+	mAutoAdjustSampleDistances = targetOn;
+
+	// the adaptive sampling and motion LOD set the distances themselves
+	if (mAdaptiveSamplingOn ||
+		mInMotion)
+	{
+		return;
+	}
+
+	for (auto & volumeMapperPair : mVolumeMappers)
+	{
+		auto volumeMappersVector = volumeMapperPair.second;
+
+		for (auto volumeMapper : volumeMappersVector)
+		{
+			if (volumeMapper)
+			{
+				volumeMapper->SetAutoAdjustSampleDistances(targetOn);
+			}
+		}
+	}
+
+}
+
+void VtkToUnityAPI_OpenGLCoreES::SetTargetFrameRateFps(const int targetFps)
+{
+	mRenderWindow->SetDesiredUpdateRate(targetFps);
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::SetAdaptiveSampling(const bool adaptiveOn, const double targetFps)
+{
+	if (targetFps > 0.0)
+	{
+		mVolumeQuality.SetTargetFrameTime(1.0 / targetFps);
+	}
+
+	if (adaptiveOn != mAdaptiveSamplingOn)
+	{
+		mAdaptiveSamplingOn = adaptiveOn;
+		mVolumeQuality.Reset();
+		ApplyVolumeSampleDistances();
+		ResetRenderTimers();
+	}
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::SetAdaptiveSamplingBounds(
+	const double minSampleDistanceScale,
+	const double maxSampleDistanceScale,
+	const double minImageSampleDistance,
+	const double maxImageSampleDistance)
+{
+	mVolumeQuality.SetBounds(
+		minSampleDistanceScale,
+		maxSampleDistanceScale,
+		minImageSampleDistance,
+		maxImageSampleDistance);
+	ApplyVolumeSampleDistances();
+}
+
+
+float VtkToUnityAPI_OpenGLCoreES::GetRenderTimeMs()
+{
+	return static_cast<float>(mVolumeQuality.GetSmoothedFrameTime() * 1000.0);
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::SetMotionLOD(const bool motionLODOn, const double idleSeconds)
+{
+	mMotionLODOn = motionLODOn;
+	mMotionIdleSeconds = std::max(0.0, idleSeconds);
+
+	if (!mMotionLODOn)
+	{
+		UpdateMotionLOD();
+	}
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::SetMotionLODQuality(
+	const double sampleDistanceScale,
+	const double imageSampleDistance,
+	const int volumeLevel)
+{
+	mMotionSampleDistanceScale = std::max(1.0, sampleDistanceScale);
+	mMotionImageSampleDistance = std::max(1.0, imageSampleDistance);
+	mMotionVolumeLevel = std::max(0, std::min(volumeLevel, VolumePyramid::sNLevels - 1));
+
+	if (mInMotion)
+	{
+		ApplyVolumeSampleDistances();
+		ApplyPropVolumeLevels();
+	}
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::NoteTransform(const int id, const Float16 &transform)
+{
+	std::array<float, 16> elements;
+	std::copy(transform.elements, transform.elements + 16, elements.begin());
+
+	// the first transform places the prop rather than moving it
+	auto lastTransformIter = mLastTransforms.find(id);
+	if (mLastTransforms.end() == lastTransformIter)
+	{
+		mLastTransforms.insert(std::make_pair(id, elements));
+		return;
+	}
+
+	if (lastTransformIter->second != elements)
+	{
+		lastTransformIter->second = elements;
+		NoteMotion();
+	}
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::NoteMotion()
+{
+	if (!mMotionLODOn)
+	{
+		return;
+	}
+
+	mLastMotion = std::chrono::steady_clock::now();
+
+	if (!mInMotion)
+	{
+		mInMotion = true;
+		ApplyVolumeSampleDistances();
+
+		if (mMotionVolumeLevel > 0)
+		{
+			ApplyPropVolumeLevels();
+		}
+	}
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::UpdateMotionLOD()
+{
+	if (!mInMotion ||
+		(mMotionLODOn && SecondsSince(mLastMotion) < mMotionIdleSeconds))
+	{
+		return;
+	}
+
+	mInMotion = false;
+	ApplyVolumeSampleDistances();
+
+	if (mMotionVolumeLevel > 0)
+	{
+		ApplyPropVolumeLevels();
+	}
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::ApplyVolumeSampleDistances()
+{
+	const double motionScale = mInMotion ? mMotionSampleDistanceScale : 1.0;
+	const double motionImageScale = mInMotion ? mMotionImageSampleDistance : 1.0;
+	const double sampleDistanceScale = motionScale * (mAdaptiveSamplingOn
+		? mVolumeQuality.GetSampleDistanceScale()
+		: 1.0);
+	const double imageSampleDistance = motionImageScale * (mAdaptiveSamplingOn
+		? mVolumeQuality.GetImageSampleDistance()
+		: 1.0);
+
+	// a mapper shared by volumes, or a streaming prop's pool, is scaled once
+	std::set<vtkGPUVolumeRayCastMapper*> sampledMappers;
+
+	for (auto &volumeMapperPair : mVolumeMappers)
+	{
+		for (auto &volumeMapper : volumeMapperPair.second)
+		{
+			if (!volumeMapper ||
+				!sampledMappers.insert(volumeMapper.GetPointer()).second)
+			{
+				continue;
+			}
+
+			// each mapper's own distance follows its input's spacing
+			volumeMapper->SetSampleDistance(static_cast<float>(volumeMapper->GetSampleDistance() *
+				(sampleDistanceScale / mAppliedSampleDistanceScale)));
+			volumeMapper->SetImageSampleDistance(static_cast<float>(imageSampleDistance));
+			volumeMapper->SetAutoAdjustSampleDistances(
+				!mAdaptiveSamplingOn && !mInMotion && mAutoAdjustSampleDistances);
+		}
+	}
+
+	mAppliedSampleDistanceScale = sampleDistanceScale;
+	mAppliedImageSampleDistance = imageSampleDistance;
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::ResetRenderTimers()
+{
+	for (auto &renderTimer : mRenderTimers)
+	{
+		renderTimer.Reset();
+	}
+
+	mRenderTimerIndex = 0;
+}
+
+int VtkToUnityAPI_OpenGLCoreES::AddMPR(const int existingMprId, const int flipAxis)
+{
+	// are we dealing with a new or existing MPR?
+	// - if new - create the reslice and its transform
+	// - if existing - use the existing reslice and its transform
+	auto existingResliceColors = mResliceColors.find(existingMprId);
+
+	vtkSmartPointer<vtkImageMapToColors> resliceColor;
+
+	if (mResliceColors.end() == existingResliceColors)
+	{
+		auto resliceTransform = vtkSmartPointer<vtkTransform>::New();
+		resliceTransform->Identity();
+
+		// create a reslice object, make it 2D and associate it with the current volume
+		auto reslice = vtkSmartPointer<vtkImageReslice>::New();
+		reslice->SetOutputDimensionality(2);
+		reslice->SetInputData(mCurrentVolumeData);
+		reslice->SetResliceTransform(resliceTransform);
+		reslice->SetInterpolationModeToLinear();
+
+		// Map the image through the lookup table
+		resliceColor = vtkSmartPointer<vtkImageMapToColors>::New();
+		resliceColor->SetLookupTable(mResliceLookupTable);
+
+		if (0 > flipAxis)
+		{
+			resliceColor->SetInputConnection(reslice->GetOutputPort());
+		}
+		else
+		{
+			// try and flip this image
+			auto resliceFlip = vtkSmartPointer<vtkImageFlip>::New();
+			resliceFlip->SetFilteredAxis(flipAxis);
+			resliceFlip->SetInputConnection(reslice->GetOutputPort());
+			resliceColor->SetInputConnection(resliceFlip->GetOutputPort());
+		}
+
+		resliceColor->Update();
+
+		mReslice.insert(std::make_pair(mNextActorIndex, reslice));
+		mResliceTransforms.insert(std::make_pair(mNextActorIndex, resliceTransform));
+		mResliceColors.insert(std::make_pair(mNextActorIndex, resliceColor));
+	}
+	else
+	{
+		resliceColor = (*existingResliceColors).second;
+	}
+
+	// Display the image
+	auto resliceImageActor = vtkSmartPointer<vtkImageActor>::New();
+	resliceImageActor->SetInputData(resliceColor->GetOutput());
+
+	mNonVolumeProp3Ds.insert(std::make_pair(mNextActorIndex, resliceImageActor));
+	mNonVolumePropTypes.insert(std::make_pair(mNextActorIndex, "vtkImageMapToColors"));
+
+	mRenderer->AddActor(resliceImageActor);
+
+	return (mNextActorIndex++);
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::SetMPRWWWL(const double windowWidth, 
+											const double windowLevel)
+{
+	mMPRWindowWidth = windowWidth;
+	mMPRWindowLevel = windowLevel;
+	UpdateMPRLookupTable();
+}
+
+
+int VtkToUnityAPI_OpenGLCoreES::VtkResource_CallObject(
+	const LPCSTR classname,
+	const Float4 &color,
+	const bool wireframe)
+{
+	vtkAlgorithm* pAlgo;
+
+	vtkAdapter* pAdapter = vtkAdapterUtility::GetAdapter(classname);
+	if (pAdapter != NULL)
+	{
+		pAlgo = (vtkAlgorithm*)pAdapter->NewInstance();
+	}
+	else
+	{
+		pAlgo = (vtkAlgorithm*)VtkIntrospection::CreateObject(classname);
+	}
+
+	pAlgo->Update();
+
+	vtkNew<vtkPolyDataMapper> mapper;
+	mapper->SetInputConnection(pAlgo->GetOutputPort());
+
+	vtkSmartPointer<vtkActor> actor = vtkSmartPointer<vtkActor>::New();
+	actor->SetMapper(mapper.GetPointer());
+	actor->GetProperty()->SetColor(color.x, color.y, color.z);
+	actor->GetProperty()->SetOpacity(color.w);
+
+	if (wireframe)
+	{
+		actor->GetProperty()->SetRepresentationToWireframe();
+	}
+
+	mNonVolumeProp3Ds.insert(std::make_pair(mNextActorIndex, actor));
+	mNonVolumePropObjects.insert(std::make_pair(mNextActorIndex, (vtkObjectBase *) pAlgo));
+	mNonVolumePropTypes.insert(std::make_pair(mNextActorIndex, classname));
+	mRenderer->AddActor(actor);
+
+	return (mNextActorIndex++);
+}
+
+
+int VtkToUnityAPI_OpenGLCoreES::VtkResource_CallObject(
+	LPCSTR classname)
+{
+	vtkObjectBase *pResource = NULL;
+	vtkAdapter *pAdapter = vtkAdapterUtility::GetAdapter(classname);
+	if (pAdapter != NULL)
+	{
+		pResource = pAdapter->NewInstance();
+	}
+	else
+	{
+		pResource = VtkIntrospection::CreateObject(classname);
+		if (pResource == NULL)
+		{
+			return -1;
+		}
+	}
+
+	mNonVolumePropObjects.insert(std::make_pair(mNextActorIndex, pResource));
+	mNonVolumePropTypes.insert(std::make_pair(mNextActorIndex, classname));
+	return mNextActorIndex++;
+}
+
+
+LPCSTR VtkToUnityAPI_OpenGLCoreES::VtkResource_CallMethodAsString(
+	const int rid,
+	LPCSTR method,
+	LPCSTR format,
+	const char *const *argv)
+{
+	/* Getting VTK object */
+	auto objectIter = mNonVolumePropObjects.find(rid);
+	if (mNonVolumePropObjects.end() != objectIter)
+	{
+		vtkObjectBase *pObject = objectIter->second;
+
+		/* Generating arguments */
+		std::vector<vtkObjectBase *> refs;
+		std::vector<LPCSTR> vals;
+		VtkArgs_Prepare(format, argv, refs, vals);
+
+		/* Getting the string representation */
+		return _strdup(VtkIntrospection::CallMethod_AsString(pObject, method, format, refs, vals));
+	}
+	else
+	{
+		return NULL;
+	}
+}
+
+int VtkToUnityAPI_OpenGLCoreES::VtkResource_CallMethodAsVtkObject(
+	const int rid,
+	LPCSTR method,
+	LPCSTR format,
+	LPCSTR classname,
+	const char *const *argv)
+{
+	/* Getting VTK object */
+	auto objectIter = mNonVolumePropObjects.find(rid);
+	if (mNonVolumePropObjects.end() != objectIter)
+	{
+		vtkObjectBase *pObject = objectIter->second;
+
+		/* Generating arguments */
+		std::vector<vtkObjectBase *> refs;
+		std::vector<LPCSTR> vals;
+		VtkArgs_Prepare(format, argv, refs, vals);
+		
+		/* Getting resulting VTK Object */
+		vtkObjectBase *pReturnObject = VtkIntrospection::CallMethod_AsVtkObject(
+			pObject, method, format, classname, refs, vals);
+
+		if (pReturnObject != NULL)
+		{
+			/* Checking if the object is already registered */
+			for (auto iEntry : mNonVolumePropObjects)
+			{
+				if (iEntry.second == pReturnObject)
+				{
+					return iEntry.first;
+				}
+			}
+
+			/* Object not yet registered */
+			mNonVolumePropObjects.insert(std::make_pair(mNextActorIndex, pReturnObject));
+			mNonVolumePropTypes.insert(std::make_pair(mNextActorIndex, classname));
+			return mNextActorIndex++;
+		}
+		else
+		{
+			return -1;
+		}
+	}
+	else
+	{
+		return -1;
+	}
+}
+
+void VtkToUnityAPI_OpenGLCoreES::VtkResource_CallMethodAsVoid(
+	const int rid,
+	LPCSTR method,
+	LPCSTR format,
+	const char *const *argv)
+{
+	/* Getting VTK object */
+	auto objectIter = mNonVolumePropObjects.find(rid);
+	if (mNonVolumePropObjects.end() != objectIter)
+	{
+		vtkObjectBase *pObject = objectIter->second;
+
+		/* Generating arguments */
+		std::vector<vtkObjectBase *> refs;
+		std::vector<LPCSTR> vals;
+		VtkArgs_Prepare(format, argv, refs, vals);
+
+		/* Calling method */
+		VtkIntrospection::CallMethod_AsVoid(pObject, method, format, refs, vals);
+	}
+}
+
+LPCSTR VtkToUnityAPI_OpenGLCoreES::VtkResource_CallMethodPipedAsString(
+	const int rid,
+	const int methodc,
+	const int formatc,
+	const char *const *methodv,
+	const char *const *formatv,
+	const char *const *argv)
+{
+	/* Getting VTK object */
+	auto objectIter = mNonVolumePropObjects.find(rid);
+	if (mNonVolumePropObjects.end() != objectIter)
+	{
+		vtkObjectBase *pObject = objectIter->second;
+
+		/* Generating arguments */
+		std::vector<vtkObjectBase *> refs;
+		std::vector<LPCSTR> vals;
+		std::vector<LPCSTR> mtds(methodv, methodv + methodc);
+		std::vector<LPCSTR> fmts(formatv, formatv + formatc);
+		VtkArgs_PreparePiped(formatc, formatv, argv, refs, vals);
+
+		/* Getting the string representation */
+		return VtkIntrospection::CallMethodPiped_AsString(pObject, mtds, fmts, refs, vals);
+	}
+	else
+	{
+		return NULL;
+	}
+}
+
+int VtkToUnityAPI_OpenGLCoreES::VtkResource_CallMethodPipedAsVtkObject(
+	const int rid,
+	const int methodc,
+	const int formatc,
+	LPCSTR classname,
+	const char *const *methodv,
+	const char *const *formatv,
+	const char *const *argv)
+{
+	/* Getting VTK object */
+	auto objectIter = mNonVolumePropObjects.find(rid);
+	if (mNonVolumePropObjects.end() != objectIter)
+	{
+		vtkObjectBase *pObject = objectIter->second;
+
+		/* Generating arguments */
+		std::vector<vtkObjectBase *> refs;
+		std::vector<LPCSTR> vals;
+		std::vector<LPCSTR> mtds(methodv, methodv + methodc);
+		std::vector<LPCSTR> fmts(formatv, formatv + formatc);
+		VtkArgs_PreparePiped(formatc, formatv, argv, refs, vals);
+
+		/* Getting resulting VTK Object */
+		vtkObjectBase *pReturnObject = VtkIntrospection::CallMethodPiped_AsVtkObject(
+			pObject, mtds, fmts, classname, refs, vals);
+
+		if (pReturnObject != NULL)
+		{
+			/* Checking if the object is already registered */
+			for (auto iEntry : mNonVolumePropObjects)
+			{
+				if (iEntry.second == pReturnObject)
+				{
+					return iEntry.first;
+				}
+			}
+
+			/* Object not yet registered */
+			mNonVolumePropObjects.insert(std::make_pair(mNextActorIndex, pReturnObject));
+			mNonVolumePropTypes.insert(std::make_pair(mNextActorIndex, classname));
+			return mNextActorIndex++;
+		}
+		else
+		{
+			return NULL;
+		}
+	}
+	else
+	{
+		return -1;
+	}
+}
+
+void VtkToUnityAPI_OpenGLCoreES::VtkResource_CallMethodPipedAsVoid(
+	const int rid,
+	const int methodc,
+	const int formatc,
+	const char *const *methodv,
+	const char *const *formatv,
+	const char *const *argv)
+{
+	/* Getting VTK object */
+	auto objectIter = mNonVolumePropObjects.find(rid);
+	if (mNonVolumePropObjects.end() != objectIter)
+	{
+		vtkObjectBase *pObject = objectIter->second;
+
+		/* Generating arguments */
+		std::vector<vtkObjectBase *> refs;
+		std::vector<LPCSTR> vals;
 		std::vector<LPCSTR> mtds(methodv, methodv + methodc);
 		std::vector<LPCSTR> fmts(formatv, formatv + formatc);
 		VtkArgs_PreparePiped(formatc, formatv, argv, refs, vals);
 
-		/* Getting resulting VTK Object */
-		vtkObjectBase *pReturnObject = VtkIntrospection::CallMethodPiped_AsVtkObject(
-			pObject, mtds, fmts, classname, refs, vals);
+		VtkIntrospection::CallMethodPiped_AsVoid(pObject, mtds, fmts, refs, vals);
+	}
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::VtkArgs_Prepare(
+	LPCSTR format,
+	const char *const *argv,
+	std::vector<vtkObjectBase *>& refs,
+	std::vector<LPCSTR>& vals)
+{
+	for (int i = 0; i < std::strlen(format); ++i)
+	{
+		if (format[i] == 'o' || format[i] == 'O')
+		{
+			int index = std::atoi(argv[i]);
+			vtkObjectBase *pObject = mNonVolumePropObjects[index];
+			refs.emplace_back(pObject);
+		}
+		else
+		{
+			vals.emplace_back(argv[i]);
+		}
+	}
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::VtkArgs_PreparePiped(
+	const int formatc,
+	const char *const *formatv,
+	const char *const *argv,
+	std::vector<vtkObjectBase *>& refs,
+	std::vector<LPCSTR>& vals)
+{
+	for (int f = 0; f < formatc; ++f)
+	{
+		const char *format = formatv[f];
+
+		for (int i = 0; i < std::strlen(format); ++i)
+		{
+			if (format[i] == 'o' || format[i] == 'O')
+			{
+				int index = std::atoi(argv[i]);
+				vtkObjectBase *pObject = mNonVolumePropObjects[index];
+				refs.emplace_back(pObject);
+			}
+			else
+			{
+				vals.emplace_back(argv[i]);
+			}
+		}
+	}
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::VtkResource_Connect(
+	LPCSTR connectionType,
+	const int sourceRid,
+	const int targetRid)
+{
+	/* Getting VTK objects */
+	auto sourceIter = mNonVolumePropObjects.find(sourceRid);
+	auto targetIter = mNonVolumePropObjects.find(targetRid);
+
+	if (mNonVolumePropObjects.end() != sourceIter && mNonVolumePropObjects.end() != targetIter)
+	{
+		vtkObjectBase *pSource = sourceIter->second;
+		vtkObjectBase *pTarget = targetIter->second;
+
+		/* Retrieving output port */
+		vtkAlgorithmOutput *pPort = ((vtkAlgorithm *)pSource)->GetOutputPort(0);
+
+		/* Generating call name */
+		std::stringstream methodName;
+		methodName << "Set" << connectionType << "Connection";
+
+		/* Connecting the two components */
+		VtkIntrospection::CallMethod_AsVoid(
+			pTarget,
+			methodName.str().c_str(),
+			"o",
+			std::vector<vtkObjectBase *>({ pPort }),
+			std::vector<LPCSTR>());
+	}
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::VtkResource_AddActor(
+	const int rid,
+	const Float4 &color,
+	const bool wireframe)
+{
+	/* Getting VTK object */
+	auto objectIter = mNonVolumePropObjects.find(rid);
+	if (mNonVolumePropObjects.end() != objectIter)
+	{
+		vtkObjectBase *pObject = objectIter->second;
+		vtkNew<vtkPolyDataMapper> mapper;
+		mapper->SetInputConnection(((vtkAlgorithm *)pObject)->GetOutputPort());
+
+		vtkSmartPointer<vtkActor> actor = vtkSmartPointer<vtkActor>::New();
+		actor->SetMapper(mapper.GetPointer());
+		actor->GetProperty()->SetColor(color.x, color.y, color.z);
+		actor->GetProperty()->SetOpacity(color.w);
+
+		if (wireframe)
+		{
+			actor->GetProperty()->SetRepresentationToWireframe();
+		}
+
+		mNonVolumeProp3Ds.insert(std::make_pair(rid, actor));
+		mRenderer->AddActor(actor);
+	}
+}
+
+
+LPCSTR VtkToUnityAPI_OpenGLCoreES::VtkError_Get()
+{
+	return VtkIntrospection::ErrorGet();
+}
+
+
+bool VtkToUnityAPI_OpenGLCoreES::VtkError_Occurred()
+{
+	return VtkIntrospection::ErrorOccurred();
+}
+
+
+LPCSTR VtkToUnityAPI_OpenGLCoreES::VtkResource_GetAttrAsString(
+	const int rid,
+	LPCSTR propertyName)
+{
+	// Temporary debugging log system as Debug does not seem to work...
+	//ofstream logFile;
+	//logFile.open("log.txt");
+	//logFile << "VtkToUnityAPI_OpenGLCoreES::GetPrimitiveProperty(" << shapeId << ", " << propertyName << ");" << std::endl;
+ 
+	auto objectIter = mNonVolumePropObjects.find(rid);
+	auto shapeTypeIter = mNonVolumePropTypes.find(rid);
+
+	if (mNonVolumePropObjects.end() != objectIter && mNonVolumePropTypes.end() != shapeTypeIter)
+	{
+		auto object = objectIter->second;
+
+		//logFile << "\tCompare \"height\" against " << propertyName << " yields " << (propertyName == "height") << std::endl;
+		//logFile << "\tCompare \"height\" against " << propertyName << " with std::strcmp yields " << (std::strcmp(propertyName, "height")) << std::endl;
+
+		// Based on https://stackoverflow.com/questions/54635806/how-to-store-a-double-in-a-void-in-c :: Old, here for future reference in case we revert back to pointers
+		// Based on https://stackoverflow.com/questions/2342162/stdstring-formatting-like-sprintf :: Legacy too
+		// Based on https://stackoverflow.com/questions/7184698/how-do-i-convert-a-int-to-lpctstr-win32 :: Legacy too
+		// Based on https://stackoverflow.com/questions/50710587/convert-double-to-char-array-c?noredirect=1&lq=1
+
+		vtkAdapter* pAdapter = vtkAdapterUtility::GetAdapter(shapeTypeIter->second);
+		if (pAdapter != NULL)
+		{
+			return pAdapter->GetAttribute(object, propertyName);
+		}
+		else
+		{
+			return _strdup(VtkIntrospection::GetProperty(object, propertyName));
+		}
+	}
+	else
+	{
+		return NULL;
+	}
+
+	//logFile << "\tYielding \"" << retValue << "\"" << std::endl;
+	//logFile.close();
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::VtkResource_SetAttrFromString(
+	const int rid,
+	LPCSTR propertyName,
+	LPCSTR format,
+	LPCSTR newValue)
+{
+	auto objectIter = mNonVolumePropObjects.find(rid);
+	auto shapeTypeIter = mNonVolumePropTypes.find(rid);
+
+	if (mNonVolumePropObjects.end() != objectIter && mNonVolumePropTypes.end() != shapeTypeIter)
+	{
+		auto object = objectIter->second;
+
+		vtkAdapter* pAdapter = vtkAdapterUtility::GetAdapter(shapeTypeIter->second);
+		if (pAdapter != NULL)
+		{
+			pAdapter->SetAttribute(object, propertyName, newValue);
+		}
+		else
+		{
+			VtkIntrospection::SetProperty(object, propertyName, format, newValue);
+		}
+	}
+}
+
+
+LPCSTR VtkToUnityAPI_OpenGLCoreES::VtkResource_GetDescriptor(
+	const int rid)
+{
+	auto objectIter = mNonVolumePropObjects.find(rid);
+	auto shapeTypeIter = mNonVolumePropTypes.find(rid);
+
+	if (mNonVolumePropObjects.end() != objectIter && mNonVolumePropTypes.end() != shapeTypeIter)
+	{
+		vtkAdapter* pAdapter = vtkAdapterUtility::GetAdapter(shapeTypeIter->second);
+		if (pAdapter != NULL)
+		{
+			 return pAdapter->GetDescriptor();
+		}
+		else
+		{
+			auto object = vtkActor::SafeDownCast(objectIter->second);
+			return _strdup(VtkIntrospection::GetDescriptor(object));
+		}
+	}
+	else
+	{
+		return NULL;
+	}
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::GetDescriptor(
+	const int shapeId,
+	char* retDescriptor)
+{
+	// Dummy implementation for Thomas Thesis
+	// TODO: implement the actual dispatcher
+	retDescriptor = "Height:System.Double,Radius:System.Double,Resolution:System.Int16,Angle:System.Double,Capping:System.Int16,Center:VtkUnityWorkbench.Double3,Direction:VtkUnityWorkbench.Double3";
+}
+
+
+int VtkToUnityAPI_OpenGLCoreES::AddLight()
+{
+	auto light = vtkSmartPointer<vtkLight>::New();
+	light->SetLightTypeToHeadlight();
+
+	mRenderer->AddLight(light); 
+
+	mLights.insert(std::make_pair(mNextActorIndex, light));
+
+	return (mNextActorIndex++);
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::SetLightingOn(
+	bool lightingOn)
+{
+	// check we have some lights
+	if (mRenderer->GetLights()->GetNumberOfItems() > 0)
+	{
+		// even if we have, if there has not been one render loop this may still fail
+		// so may need to add a 'first rendrer' flag, and store the desired state
+		mVolumeProperty->SetShade(lightingOn ? 1 : 0);
+
+		//mNonVolumeProp3Ds
+
+		auto nonVolumePropIter = mNonVolumeProp3Ds.begin();
+
+		while (nonVolumePropIter != mNonVolumeProp3Ds.end())
+		{
+			auto actor = vtkActor::SafeDownCast(nonVolumePropIter->second);
+
+			if (NULL != actor)
+			{
+				actor->GetProperty()->SetLighting(lightingOn);
+			}
+
+			++nonVolumePropIter;
+		}
+	}
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::SetLightColor(
+	int id,
+	LightColorType lightColorType,
+	Float4 &rgbColor)
+{
+	// find the light
+	auto lightIter = mLights.find(id);
+
+	if (mLights.end() == lightIter)
+	{
+		return;
+	}
+
+	auto light = lightIter->second;
+
+	// set that lights colour property
+	if (LightColorAmbient == lightColorType)
+	{
+		light->SetAmbientColor(rgbColor.x, rgbColor.y, rgbColor.z);
+	}
+	else if (LightColorDiffuse == lightColorType)
+	{
+		light->SetDiffuseColor(rgbColor.x, rgbColor.y, rgbColor.z);
+	}
+	else if (LightColorSpecular == lightColorType)
+	{
+		light->SetSpecularColor(rgbColor.x, rgbColor.y, rgbColor.z);
+	}
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::SetLightIntensity(
+	int id,
+	float intensity)
+{
+	// find the light
+	auto lightIter = mLights.find(id);
+
+	if (mLights.end() == lightIter)
+	{
+		return;
+	}
+
+	auto light = lightIter->second;
+
+	light->SetIntensity(intensity);
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::SetVolumeLighting(
+	VolumeLightType volumeLightType,
+	float lightValue)
+{
+	// set the volume properties colour
+	if (VolumeLightAmbient == volumeLightType)
+	{
+		mVolumeProperty->SetAmbient(lightValue);
+	}
+	else if (VolumeLightDiffuse == volumeLightType)
+	{
+		mVolumeProperty->SetDiffuse(lightValue);
+	}
+	else if (VolumeLightSpecular == volumeLightType)
+	{
+		mVolumeProperty->SetSpecular(lightValue);
+	}
+	else if (VolumeLightSpecularPower == volumeLightType)
+	{
+		mVolumeProperty->SetSpecularPower(lightValue);
+	}
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::RemoveProp3D(
+	int id)
+{
+	{
+		// was it a non-volume prop, e.g. primitive, mpr
+		auto actorIter = mNonVolumeProp3Ds.find(id);
+
+		// We've found it, so destroy it!
+		if (mNonVolumeProp3Ds.end() != actorIter)
+		{
+			mRenderer->RemoveActor(actorIter->second);
+			VtkIntrospection::DeleteObject((vtkActor::SafeDownCast(actorIter->second))->GetMapper()->GetInputConnection(0, 0)->GetProducer());
+			mNonVolumeProp3Ds.erase(id);
+			mNonVolumePropTypes.erase(id);
+		}
+	}
+
+	{
+		// was it a volume prop
+		auto actorVectorIter = mVolumeProp3Ds.find(id);
+
+		// We've found it, so destroy it!
+		if (mVolumeProp3Ds.end() != actorVectorIter)
+		{
+			for (auto actorIter : actorVectorIter->second)
+			{
+				mRenderer->RemoveActor(actorIter);
+			}
+
+			mVolumeProp3Ds.erase(id);
+		}
+	}
+
+	// remove any volume mappers
+	auto volumeMapperIter = mVolumeMappers.find(id);
+
+	// This was a volume so destory the mapper too
+	if (mVolumeMappers.end() != volumeMapperIter)
+	{
+		// todo - Hmm, I'm not 100% on how to get rid of the mapper properly
+		//*volumeMapperIter = NULL;
+		mVolumeMappers.erase(id);
+	}
+
+
+	mPropVolumeLevels.erase(id);
+	mStreamingVolumeProps.erase(id);
+	mLastTransforms.erase(id);
+
+	// This was a reslice, so destroy that object too
+	{
+		// may need to do some other operations here to properly clean up
+		mReslice.erase(id);
+		mResliceTransforms.erase(id);
+		mResliceColors.erase(id);
+	}
+
+	{
+		// was it a light
+		auto lightIter = mLights.find(id);
+
+		// We've found it, so destroy it!
+		if (mLights.end() != lightIter)
+		{
+			mRenderer->RemoveLight(lightIter->second);
+			mLights.erase(id);
+		}
+	}
+
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::SetProp3DTransform(
+	int id,
+	Float16 transform)
+{
+	NoteTransform(id, transform);
+
+	// is it a not-a-volume prop?
+	{
+		auto actorIter = mNonVolumeProp3Ds.find(id);
+
+		if (mNonVolumeProp3Ds.end() != actorIter)
+		{
+			auto prop3D = actorIter->second;
+			auto vtkMatrix = Float16ToVtkMatrix4x4(transform);
+			prop3D->SetUserMatrix(vtkMatrix);
+			prop3D->Modified();
+			return;
+		}
+	}
+
+	// is it a volume prop?
+	{
+		auto volumeProp3DsIter = mVolumeProp3Ds.find(id);
+
+		if (mVolumeProp3Ds.end() != volumeProp3DsIter)
+		{
+			auto volumePropsVector = (*volumeProp3DsIter).second;
+
+			for (auto volumeProp : volumePropsVector)
+			{
+				//auto prop3D = actorIter->second;
+				auto vtkMatrix = Float16ToVtkMatrix4x4(transform);
+				volumeProp->SetUserMatrix(vtkMatrix);
+				volumeProp->Modified();
+			}
+			
+			return;
+		}
+	}
+
+	// is it a plane?
+	{
+		auto planeIter = mVolumeCropPlanes.find(id);
+
+		if (mVolumeCropPlanes.end() != planeIter)
+		{
+			auto vtkMatrix = Float16ToVtkMatrix4x4(transform);
+			vtkNew<vtkTransform> vtkTransform;
+			vtkTransform->SetMatrix(vtkMatrix);
+
+			auto plane = planeIter->second;
+			plane->SetOrigin(vtkTransform->TransformPoint(0.0, 0.0, 0.0));
+			plane->SetNormal(vtkTransform->TransformNormal(0.0, 1.0, 0.0));
+			plane->Modified();
+			return;
+		}
+	}
+
+	// no it's an unidentified object! Could have an error message here
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::SetMPRTransform(
+	const int id,
+	Float16 transformVolume)
+{
+	auto resliceTransformIter = mResliceTransforms.find(id);
+	auto resliceColorIter = mResliceColors.find(id);
+
+	if (mResliceTransforms.end() == resliceTransformIter || 
+		mResliceColors.end() == resliceColorIter)
+	{
+		return;
+	}
+
+	NoteTransform(id, transformVolume);
+
+	auto resliceTransform = resliceTransformIter->second;
+	auto vtkMatrix = Float16ToVtkMatrix4x4(transformVolume);
+	resliceTransform->SetMatrix(vtkMatrix);
+	resliceTransform->Modified();
+
+	// this should force the image to be updated
+	auto resliceColor = resliceColorIter->second;
+	resliceColor->Update();
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::UpdateVtkCameraAndRender(
+	const std::array<double, 16> &viewMatrix,
+	const std::array<double, 16> &projectionMatrix)
+{
+	// each camera moves against its own last view, a camera not seen before is placed rather than moved
+	auto cameraViewIter = std::find_if(mCameraViews.begin(), mCameraViews.end(),
+		[&](const CameraView &cameraView)
+		{
+			return cameraView.projectionMatrix == projectionMatrix;
+		});
+
+	if (mCameraViews.end() == cameraViewIter)
+	{
+		if (mCameraViews.size() >= sMaxRenderSignatures)
+		{
+			mCameraViews.erase(mCameraViews.begin());
+		}
+		mCameraViews.push_back({ projectionMatrix, viewMatrix });
+	}
+	else if (ViewMoved(cameraViewIter->viewMatrix, viewMatrix))
+	{
+		NoteMotion();
+		cameraViewIter->viewMatrix = viewMatrix;
+	}
+	UpdateMotionLOD();
+
+	// a camera rendered before, with nothing changed since, still has that render
+	auto signatureIter = std::find_if(mRenderSignatures.begin(), mRenderSignatures.end(),
+		[&](const RenderSignature &signature)
+		{
+			return (signature.viewMatrix == viewMatrix &&
+				signature.projectionMatrix == projectionMatrix);
+		});
+
+	if (mSkipUnchangedRenders &&
+		mRenderScene &&
+		mRenderSignatures.end() != signatureIter &&
+		signatureIter->sceneMTime == GetSceneMTime())
+	{
+		++mNSkippedRenders;
+		return;
+	}
+
+	mRenderer->SetViewMatrix(viewMatrix);
+	mRenderer->SetProjectionMatrix(projectionMatrix);
+
+	mRenderer->ResetCameraClippingRange();
+
+	if (mRenderScene)
+	{
+		// the ray casting is on the GPU, which the CPU time of Render() does not wait for
+		const bool timeRender = mAdaptiveSamplingOn && mWindowRendered;
+		if (timeRender)
+		{
+			// a timer still not read back two renders on is dropped
+			mRenderTimers[mRenderTimerIndex].Reset();
+			mRenderTimers[mRenderTimerIndex].Start();
+		}
+
+		const auto renderStart = std::chrono::steady_clock::now();
+		mExternalVTKWidget->GetRenderWindow()->Render();
+		mWindowRendered = true;
+
+		if (timeRender)
+		{
+			mRenderTimers[mRenderTimerIndex].Stop();
+			mRenderCpuSeconds[mRenderTimerIndex] = SecondsSince(renderStart);
+			mRenderTimerIndex = 1 - mRenderTimerIndex;
+
+			// the previous render's timer, without waiting on the GPU for it
+			vtkOpenGLRenderTimer &lastRenderTimer = mRenderTimers[mRenderTimerIndex];
+			if (lastRenderTimer.Stopped() &&
+				lastRenderTimer.Ready())
+			{
+				// zero where the GL has no timer queries, leaving the CPU time
+				const double renderSeconds = std::max(
+					mRenderCpuSeconds[mRenderTimerIndex],
+					static_cast<double>(lastRenderTimer.GetElapsedSeconds()));
+				lastRenderTimer.Reset();
+
+				if (mVolumeQuality.AddFrameTime(renderSeconds))
+				{
+					ApplyVolumeSampleDistances();
+				}
+			}
+		}
+
+		// taken after the render, which brings the pipelines up to date
+		if (mSkipUnchangedRenders)
+		{
+			if (mRenderSignatures.end() != signatureIter)
+			{
+				mRenderSignatures.erase(signatureIter);
+			}
+			else if (mRenderSignatures.size() >= sMaxRenderSignatures)
+			{
+				mRenderSignatures.erase(mRenderSignatures.begin());
+			}
+
+			mRenderSignatures.push_back({ viewMatrix, projectionMatrix, GetSceneMTime() });
+		}
+	}
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::SetSkipUnchangedRenders(const bool skipUnchanged)
+{
+	mSkipUnchangedRenders = skipUnchanged;
+	mRenderSignatures.clear();
+}
+
+
+int VtkToUnityAPI_OpenGLCoreES::GetNSkippedRenders()
+{
+	return mNSkippedRenders;
+}
+
+
+vtkMTimeType VtkToUnityAPI_OpenGLCoreES::GetSceneMTime()
+{
+	// the props' redraw times take in their mappers, inputs, properties and matrices
+	vtkMTimeType sceneMTime = std::max(mRenderer->GetMTime(), mVolumeProperty->GetMTime());
+
+	vtkPropCollection *viewProps = mRenderer->GetViewProps();
+	viewProps->InitTraversal();
+	for (vtkProp *viewProp = viewProps->GetNextProp(); nullptr != viewProp; viewProp = viewProps->GetNextProp())
+	{
+		sceneMTime = std::max(sceneMTime, viewProp->GetRedrawMTime());
+	}
+
+	for (const auto &lightPair : mLights)
+	{
+		sceneMTime = std::max(sceneMTime, lightPair.second->GetMTime());
+	}
+
+	for (const auto &cropPlanePair : mVolumeCropPlanes)
+	{
+		sceneMTime = std::max(sceneMTime, cropPlanePair.second->GetMTime());
+	}
+
+	for (const auto &reslicePair : mReslice)
+	{
+		sceneMTime = std::max(sceneMTime, reslicePair.second->GetMTime());
+	}
+
+	for (const auto &resliceTransformPair : mResliceTransforms)
+	{
+		sceneMTime = std::max(sceneMTime, resliceTransformPair.second->GetMTime());
+	}
+
+	if (nullptr != mCurrentVolumeMask)
+	{
+		sceneMTime = std::max(sceneMTime, mCurrentVolumeMask->GetMTime());
+	}
+
+	return std::max(sceneMTime, mCurrentVolumeData->GetMTime());
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::LogToDebugLog(
+	const DebugLogLevel level,
+	const std::string& message)
+{
+	if (nullptr == mDebugLog)
+	{
+		return;
+	}
+
+	(*mDebugLog)(level, message);
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::CreateResources()
+{
+	mNextActorIndex = 0;
+	mNonVolumeProp3Ds.clear();
+	mNonVolumePropObjects.clear();
+	mNonVolumePropTypes.clear();
+	mVolumeProp3Ds.clear();
+	mLights.clear();
+
+	// create the VTK external renderer
+	mRenderWindow = vtkSmartPointer<vtkExternalOpenGLRenderWindow>::New();
+	mWindowRendered = false;
+	ResetRenderTimers();
+	mExternalVTKWidget->SetRenderWindow(mRenderWindow);
+	mExternalVTKWidget->GetRenderWindow()->AddRenderer(mRenderer.GetPointer());
+
+	vtkFrustumCoverageCuller *frustrumCoverageCuller = vtkFrustumCoverageCuller::SafeDownCast(mRenderer->GetCullers()->GetLastItem());
+	frustrumCoverageCuller->SetSortingStyleToBackToFront();
+
+	mCurrentVolumeIndex = -1;
+
+	// Set up the Volume transfer functions, mappers, props etc.
+	mWindowWidth = 150.0;
+	mWindowLevel = 100.0;
+	mRescaleSlope = 1.0;
+	mRescaleIntercept = 0.0;
+	mOpacityFactor = 1.0;
+	mBrightnessFactor = 1.0;
+
+	ResetTransferFunctions();
+
+	UpdateVolumeColorAndOpacity();
+
+	mVolumeProperty->SetColor(mVolumeColor.GetPointer());
+	mVolumeProperty->SetScalarOpacity(mVolumeOpacity.GetPointer());
+	mVolumeProperty->SetInterpolationTypeToLinear();
+	mVolumeProperty->SetScalarOpacityUnitDistance(0.001); // compensate for m / mm
+
+	mVolumeProperty->SetAmbient(0.1);
+	mVolumeProperty->SetDiffuse(0.9);
+	mVolumeProperty->SetSpecular(0.2);
+	mVolumeProperty->SetSpecularPower(10.0);
+
+	mVolumeMappers.clear();
+	mStreamingVolumeProps.clear();
+
+	// Create a synthetic volume to default to rendering
+	{
+		//Assigning Values , Allocating Memory
+		const int maxX = 200;
+		const int maxY = 200;
+		const int maxZ = 150;
+		mSyntheticVolumeData->SetDimensions(maxX, maxY, maxZ);
+		// the values only go up to 447, 16 bits are plenty
+		mSyntheticVolumeData->AllocateScalars(VTK_UNSIGNED_SHORT, 1);
+		vtkTypeUInt16 *voxel = static_cast<vtkTypeUInt16*>(mSyntheticVolumeData->GetScalarPointer());
+		mSyntheticVolumeData->UpdateCellGhostArrayCache();
+
+		for (int z = 0; z < maxZ; z++)
+		{
+			for (int y = 0; y < maxY; y++)
+			{
+				for (int x = 0; x < maxX; x++)
+				{
+					*voxel++ = z * 3;
+				}
+			}
+		}
+
+		std::array<double, 3> spacing = { {0.001, 0.001, 0.001} };
+		mSyntheticVolumeData->SetSpacing(spacing.data());
+	}
+
+	// And set the current volume to point to it
+	mCurrentVolumeData = vtkSmartPointer<vtkImageData>::New();
+	mCurrentVolumeData->ShallowCopy(mSyntheticVolumeData.GetPointer());
+
+	// Initialise the MPR looup table
+	// this is a good default for US images
+	mMPRWindowWidth = 350.0; // image intensity range 0 to 350
+	mMPRWindowLevel = 175.0;
+	mResliceLookupTable->SetValueRange(0.0, 1.0); // from black to white
+	mResliceLookupTable->SetSaturationRange(0.0, 0.0); // no color saturation
+	mResliceLookupTable->SetRampToLinear();
+	UpdateMPRLookupTable();
+
+	mRenderer->ResetCamera();
+	mRenderer->SetLightFollowCamera(false);
+
+	mRenderScene = true;
+}
+
+vtkSmartPointer<vtkImageData> VtkToUnityAPI_OpenGLCoreES::ReadVolumeFile(
+	const VolumeFileFormat format,
+	const std::string &path,
+	const VolumeLoadOptions &options,
+	LoadProgress *progress,
+	VolumeRecord &record)
+{
+	vtkSmartPointer<vtkImageData> volumeImageData;
+
+	if (options.cacheEnabled)
+	{
+		volumeImageData = VolumeCache::Find(
+			options.cacheFolder, path, record.rescaleSlope, record.rescaleIntercept);
+
+		if (nullptr != volumeImageData)
+		{
+			LogToDebugLog(DebugLogLevel::DebugLog,
+				std::string("ReadVolumeFile: mapped cached volume for ") + path);
+		}
+	}
+
+	if (nullptr == volumeImageData)
+	{
+		volumeImageData = ReadVolumeFromSource(format, path, options, progress, record);
+
+		if (nullptr != volumeImageData &&
+			options.cacheEnabled &&
+			!(nullptr != progress && progress->IsCancelled()))
+		{
+			if (!VolumeCache::Store(
+				options.cacheFolder,
+				options.cacheMaxBytes,
+				path,
+				volumeImageData,
+				record.reversePending,
+				record.rescaleSlope,
+				record.rescaleIntercept))
+			{
+				LogToDebugLog(DebugLogLevel::DebugLogWarning,
+					std::string("ReadVolumeFile: could not cache the volume in ") + options.cacheFolder);
+			}
+		}
+	}
+
+	// the cache keeps the scalars as read, so changing the narrowing needs no new entries
+	if (nullptr != volumeImageData &&
+		!(nullptr != progress && progress->IsCancelled()))
+	{
+		NarrowVolumeScalars(volumeImageData, options, record);
+
+		// so the volume can be evicted and read again
+		record.sourceFormat = format;
+		record.sourcePath = path;
+	}
+
+	return volumeImageData;
+}
+
+vtkSmartPointer<vtkImageData> VtkToUnityAPI_OpenGLCoreES::ReadVolumeFromSource(
+	const VolumeFileFormat format,
+	const std::string &path,
+	const VolumeLoadOptions &options,
+	LoadProgress *progress,
+	VolumeRecord &record)
+{
+	vtkSmartPointer<vtkImageData> volumeImageData;
+
+	// NIfTI values may be scaled, the VTK reader below takes it from the files this does not parse
+	RawVolumeLayout niftiLayout;
+	if (VolumeFileNifti == format &&
+		RawVolumeHeader::ReadNifti(path, niftiLayout))
+	{
+		record.rescaleSlope = niftiLayout.rescaleSlope;
+		record.rescaleIntercept = niftiLayout.rescaleIntercept;
+	}
+
+	// uncompressed NIfTI is always mapped, there is no other fast reader for it
+	if ((options.memoryMapped || VolumeFileNifti == format) &&
+		VolumeFileDicomFolder != format)
+	{
+		volumeImageData = MappedVolumeReader::Read(format, path);
+
+		if (nullptr != volumeImageData)
+		{
+			// the mapping is read-only, the reversed copy is made when the volume is shown
+			record.reversePending = true;
+			return volumeImageData;
+		}
+
+		LogToDebugLog(DebugLogLevel::DebugLog,
+			"ReadVolumeFile: volume cannot be memory mapped, reading it instead");
+	}
+
+	RawVolumeLayout layout;
+	if (options.pipelinedInflate &&
+		VolumeFileDicomFolder != format &&
+		RawVolumeHeader::Read(format, path, layout) &&
+		layout.compressed)
+	{
+		// slices are inflated straight into their reversed place, no flip needed
+		volumeImageData = CompressedVolumeReader::Read(layout, true, progress);
+
+		if (nullptr != volumeImageData ||
+			(nullptr != progress && progress->IsCancelled()))
+		{
+			return volumeImageData;
+		}
+
+		LogToDebugLog(DebugLogLevel::DebugLogWarning,
+			"ReadVolumeFile: pipelined inflate failed, falling back to the VTK reader");
+	}
+
+	switch (format)
+	{
+	case VolumeFileDicomFolder:
+	{
+		if (options.parallelDicom)
+		{
+			// slices are written straight into their reversed place, no flip needed
+			volumeImageData = ParallelDicomReader::Read(path, true, progress);
+
+			if (nullptr != volumeImageData ||
+				(nullptr != progress && progress->IsCancelled()))
+			{
+				return volumeImageData;
+			}
+
+			LogToDebugLog(DebugLogLevel::DebugLogWarning,
+				"ReadVolumeFile: parallel reader failed, falling back to vtkDICOMImageReader");
+		}
+
+		vtkNew<vtkDICOMImageReader> dicomReader;
+		dicomReader->SetDirectoryName(path.c_str());
+		volumeImageData = UpdateVolumeReader(dicomReader.GetPointer(), progress);
+		break;
+	}
+	case VolumeFileMhd:
+	{
+		vtkNew<vtkMetaImageReader> mhdReader;
+		mhdReader->SetFileName(path.c_str());
+		volumeImageData = UpdateVolumeReader(mhdReader.GetPointer(), progress);
+		break;
+	}
+	case VolumeFileNrrd:
+	{
+		vtkNew<vtkNrrdReader> nrrdReader;
+		nrrdReader->SetFileName(path.c_str());
+		volumeImageData = UpdateVolumeReader(nrrdReader.GetPointer(), progress);
+		break;
+	}
+	case VolumeFileNifti:
+	{
+		// for what RawVolumeHeader does not read, such as NIfTI-2 or big endian files, and
+		// compressed files when the pipelined inflate is off
+		vtkNew<vtkNIFTIImageReader> niftiReader;
+		niftiReader->SetFileName(path.c_str());
+		volumeImageData = UpdateVolumeReader(niftiReader.GetPointer(), progress);
+
+		// the reader keeps the file's spatial units, to mm as RawVolumeHeader reads them
+		const double unitsToMm = RawVolumeHeader::NiftiUnitsToMm(
+			niftiReader->GetNIFTIHeader()->GetXYZTUnits());
+
+		if (nullptr != volumeImageData)
+		{
+			std::array<double, 3> spacing;
+			volumeImageData->GetSpacing(spacing.data());
+			volumeImageData->SetSpacing(
+				spacing[0] * unitsToMm,
+				spacing[1] * unitsToMm,
+				spacing[2] * unitsToMm);
+		}
+
+		// the reader leaves the origin at zero and the voxels as stored, take the origin from
+		// the sform or qform, RAS to LPS, and flip the axes running against LPS
+		vtkMatrix4x4 *niftiMatrix = (nullptr != niftiReader->GetSFormMatrix())
+			? niftiReader->GetSFormMatrix()
+			: niftiReader->GetQFormMatrix();
 
-		if (pReturnObject != NULL)
+		if (nullptr != volumeImageData &&
+			nullptr != niftiMatrix)
 		{
-			/* Checking if the object is already registered */
-			for (auto iEntry : mNonVolumePropObjects)
+			double rasAxes[3][3];
+			for (int axis = 0; axis < 3; ++axis)
 			{
-				if (iEntry.second == pReturnObject)
+				for (int column = 0; column < 3; ++column)
 				{
-					return iEntry.first;
+					rasAxes[axis][column] = niftiMatrix->GetElement(axis, column);
 				}
 			}
 
-			/* Object not yet registered */
-			mNonVolumePropObjects.insert(std::make_pair(mNextActorIndex, pReturnObject));
-			mNonVolumePropTypes.insert(std::make_pair(mNextActorIndex, classname));
-			return mNextActorIndex++;
+			std::array<bool, 3> flipAxes;
+			if (!RawVolumeHeader::NiftiAxesToLps(rasAxes, flipAxes))
+			{
+				LogToDebugLog(DebugLogLevel::DebugLogWarning,
+					std::string("ReadVolumeFile: the rotation of the NIfTI axes is not applied for ") + path);
+			}
+
+			std::array<int, 3> dimensions;
+			std::array<double, 3> spacing;
+			volumeImageData->GetDimensions(dimensions.data());
+			volumeImageData->GetSpacing(spacing.data());
+
+			std::array<double, 3> origin{ {
+				-niftiMatrix->GetElement(0, 3) * unitsToMm,
+				-niftiMatrix->GetElement(1, 3) * unitsToMm,
+				niftiMatrix->GetElement(2, 3) * unitsToMm } };
+
+			// a flipped axis starts from its far end
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				if (flipAxes[axis])
+				{
+					origin[axis] -= (dimensions[axis] - 1) * spacing[axis];
+				}
+			}
+
+			FlipVolumeAxes(volumeImageData, flipAxes);
+			volumeImageData->SetOrigin(origin.data());
 		}
-		else
+
+		if (0.0 != niftiReader->GetRescaleSlope())
 		{
-			return NULL;
+			record.rescaleSlope = niftiReader->GetRescaleSlope();
+			record.rescaleIntercept = niftiReader->GetRescaleIntercept();
 		}
+		break;
 	}
-	else
+	default:
+		break;
+	}
+
+	// the reader has been released by now, so this flips the only copy of the data
+	if (nullptr != volumeImageData)
 	{
-		return -1;
+		ReverseVolumeAlongZ(volumeImageData);
 	}
+
+	return volumeImageData;
 }
 
-void VtkToUnityAPI_OpenGLCoreES::VtkResource_CallMethodPipedAsVoid(
-	const int rid,
-	const int methodc,
-	const int formatc,
-	const char *const *methodv,
-	const char *const *formatv,
-	const char *const *argv)
+void VtkToUnityAPI_OpenGLCoreES::AddVolume(
+	vtkSmartPointer<vtkImageData> volumeImageData,
+	const VolumeRecord &record,
+	const bool deduplicate)
 {
-	/* Getting VTK object */
-	auto objectIter = mNonVolumePropObjects.find(rid);
-	if (mNonVolumePropObjects.end() != objectIter)
+	// LogToDebugLog(DebugLogLevel::DebugLog, "VtkToUnityAPI_OpenGLCoreES: AddVolume: Test Message");
+	VolumeRecord addedRecord(record);
+	if (deduplicate)
 	{
-		vtkObjectBase *pObject = objectIter->second;
+		ShareDuplicateVolume(volumeImageData, addedRecord);
+	}
 
-		/* Generating arguments */
-		std::vector<vtkObjectBase *> refs;
-		std::vector<LPCSTR> vals;
-		std::vector<LPCSTR> mtds(methodv, methodv + methodc);
-		std::vector<LPCSTR> fmts(formatv, formatv + formatc);
-		VtkArgs_PreparePiped(formatc, formatv, argv, refs, vals);
+	mVolumeDataVector.push_back(volumeImageData);
+	mVolumeRecords.push_back(addedRecord);
 
-		VtkIntrospection::CallMethodPiped_AsVoid(pObject, mtds, fmts, refs, vals);
-	}
+	const int index(static_cast<int>(mVolumeDataVector.size()) - 1);
+	SetVolumeIndex(index);
+	QueueVolumePyramid(index);
 }
 
-
-void VtkToUnityAPI_OpenGLCoreES::VtkArgs_Prepare(
-	LPCSTR format,
-	const char *const *argv,
-	std::vector<vtkObjectBase *>& refs,
-	std::vector<LPCSTR>& vals)
+bool VtkToUnityAPI_OpenGLCoreES::CheckVolumeExtentSpacingOrigin(
+	vtkSmartPointer<vtkImageData> volumeImageData)
 {
-	for (int i = 0; i < std::strlen(format); ++i)
+	// Check that the volume given has the same extents etc. as the others
+	std::array<int, 6> extent;
+	volumeImageData->GetExtent(extent.data());
+
+	// origin is in mm? converting to m
+	std::array<double, 3> origin;
+	volumeImageData->GetOrigin(origin.data());
+
+	// DICOM (and mhd?) dimensions are in mm, Unity is in m, updating the spacing to be in m
+	std::array<double, 3> spacing;
+	volumeImageData->GetSpacing(spacing.data());
+	std::for_each(spacing.begin(), spacing.end(), [](double &s) { s *= sMmToMConversion; });
+	volumeImageData->SetSpacing(spacing.data());
+
+	// if this is the first volume, just remember the values
+	if (mVolumeDataVector.empty())
 	{
-		if (format[i] == 'o' || format[i] == 'O')
+		mVolumeExtent = extent;
+		mVolumeSpacingM = spacing;
+		mVolumeOrigin = origin;
+
+		mVolumeExtentMin = { mVolumeExtent[0], mVolumeExtent[2], mVolumeExtent[4] };
+		mVolumeExtentMax = { mVolumeExtent[1], mVolumeExtent[3], mVolumeExtent[5] };
+
+		for (auto &volumeCentreElem : mVolumeCentre)
 		{
-			int index = std::atoi(argv[i]);
-			vtkObjectBase *pObject = mNonVolumePropObjects[index];
-			refs.emplace_back(pObject);
+			auto i = &volumeCentreElem - &mVolumeCentre[0];
+			volumeCentreElem = mVolumeSpacingM[i] * -0.5 * (mVolumeExtentMin[i] + mVolumeExtentMax[i]);
 		}
-		else
+
+		// set the origin to be the centre of the volume for rotational niceness, 
+		// if not absolute correctness - at least it is clear we're doing this
+		volumeImageData->SetOrigin(mVolumeCentre.data());
+		volumeImageData->GetOrigin(origin.data());
+		mVolumeOriginCentredM = origin;
+
+		return true;
+	}
+
+	// otherwise check that they match
+	if (mVolumeExtent != extent)
+	{
+		return false;
+	}
+
+	const double maxError(1e-6);
+
+	for (int i = 0; i < 3; ++i)
+	{
+		if (maxError < fabs(mVolumeSpacingM[i] - spacing[i]) ||
+			maxError < fabs(mVolumeOrigin[i] - origin[i]))
 		{
-			vals.emplace_back(argv[i]);
+			return false;
 		}
 	}
+
+	volumeImageData->SetOrigin(mVolumeCentre.data());
+
+	return true;
 }
 
+void VtkToUnityAPI_OpenGLCoreES::ReverseVolumeAlongZ(
+	vtkSmartPointer<vtkImageData> volumeImageData)
+{
+	// flip in place by swapping slice pairs, so no second copy of the volume is needed
+	std::array<int, 3> dimensions;
+	volumeImageData->GetDimensions(dimensions.data());
 
-void VtkToUnityAPI_OpenGLCoreES::VtkArgs_PreparePiped(
-	const int formatc,
-	const char *const *formatv,
-	const char *const *argv,
-	std::vector<vtkObjectBase *>& refs,
-	std::vector<LPCSTR>& vals)
+	const size_t sliceBytes =
+		static_cast<size_t>(dimensions[0]) *
+		static_cast<size_t>(dimensions[1]) *
+		static_cast<size_t>(volumeImageData->GetScalarSize() *
+			volumeImageData->GetNumberOfScalarComponents());
+
+	unsigned char *volumeDataPtr = static_cast<unsigned char*>(volumeImageData->GetScalarPointer());
+	const size_t nSlices = static_cast<size_t>(dimensions[2]);
+
+	if (nullptr == volumeDataPtr)
+	{
+		return;
+	}
+
+	ParallelFor(nSlices / 2, [volumeDataPtr, sliceBytes, nSlices](const size_t z)
+	{
+		unsigned char *frontSlice = volumeDataPtr + (z * sliceBytes);
+		unsigned char *backSlice = volumeDataPtr + ((nSlices - 1 - z) * sliceBytes);
+		std::swap_ranges(frontSlice, frontSlice + sliceBytes, backSlice);
+	});
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::EnforceVolumeMemoryBudget()
 {
-	for (int f = 0; f < formatc; ++f)
+	if (0 == mVolumeMemoryBudgetBytes)
 	{
-		const char *format = formatv[f];
+		return;
+	}
 
-		for (int i = 0; i < std::strlen(format); ++i)
+	unsigned long long residentBytes(0);
+	std::vector<int> evictableIndices;
+	std::set<vtkImageData*> countedVolumes;
+
+	// shared voxels are counted, and evicted, once
+	vtkImageData *currentVolumeData = (mCurrentVolumeIndex >= 0 && mCurrentVolumeIndex < GetNVolumes())
+		? mVolumeDataVector[mCurrentVolumeIndex].GetPointer()
+		: nullptr;
+
+	for (int iVolume = 0; iVolume < GetNVolumes(); ++iVolume)
+	{
+		if (!mVolumeRecords[iVolume].evicted &&
+			countedVolumes.insert(mVolumeDataVector[iVolume].GetPointer()).second)
 		{
-			if (format[i] == 'o' || format[i] == 'O')
-			{
-				int index = std::atoi(argv[i]);
-				vtkObjectBase *pObject = mNonVolumePropObjects[index];
-				refs.emplace_back(pObject);
-			}
-			else
+			residentBytes += ScalarBytes(mVolumeDataVector[iVolume]) + PyramidBytes(mVolumeRecords[iVolume]);
+
+			if (mVolumeDataVector[iVolume].GetPointer() != currentVolumeData)
 			{
-				vals.emplace_back(argv[i]);
+				evictableIndices.push_back(iVolume);
 			}
 		}
 	}
-}
 
+	std::sort(evictableIndices.begin(), evictableIndices.end(),
+		[this](const int a, const int b) { return mVolumeRecords[a].lastShown < mVolumeRecords[b].lastShown; });
 
-void VtkToUnityAPI_OpenGLCoreES::VtkResource_Connect(
-	LPCSTR connectionType,
-	const int sourceRid,
-	const int targetRid)
-{
-	/* Getting VTK objects */
-	auto sourceIter = mNonVolumePropObjects.find(sourceRid);
-	auto targetIter = mNonVolumePropObjects.find(targetRid);
-
-	if (mNonVolumePropObjects.end() != sourceIter && mNonVolumePropObjects.end() != targetIter)
+	for (const int iVolume : evictableIndices)
 	{
-		vtkObjectBase *pSource = sourceIter->second;
-		vtkObjectBase *pTarget = targetIter->second;
-
-		/* Retrieving output port */
-		vtkAlgorithmOutput *pPort = ((vtkAlgorithm *)pSource)->GetOutputPort(0);
+		if (residentBytes <= mVolumeMemoryBudgetBytes)
+		{
+			break;
+		}
 
-		/* Generating call name */
-		std::stringstream methodName;
-		methodName << "Set" << connectionType << "Connection";
+		const unsigned long long volumeBytes =
+			ScalarBytes(mVolumeDataVector[iVolume]) + PyramidBytes(mVolumeRecords[iVolume]);
 
-		/* Connecting the two components */
-		VtkIntrospection::CallMethod_AsVoid(
-			pTarget,
-			methodName.str().c_str(),
-			"o",
-			std::vector<vtkObjectBase *>({ pPort }),
-			std::vector<LPCSTR>());
+		if (EvictVolume(iVolume))
+		{
+			residentBytes -= volumeBytes;
+		}
 	}
 }
 
 
-void VtkToUnityAPI_OpenGLCoreES::VtkResource_AddActor(
-	const int rid,
-	const Float4 &color,
-	const bool wireframe)
+bool VtkToUnityAPI_OpenGLCoreES::EvictVolume(const int index)
 {
-	/* Getting VTK object */
-	auto objectIter = mNonVolumePropObjects.find(rid);
-	if (mNonVolumePropObjects.end() != objectIter)
+	VolumeRecord &record = mVolumeRecords[index];
+	vtkImageData *volumeImageData = mVolumeDataVector[index];
+	vtkDataArray *scalars = volumeImageData->GetPointData()->GetScalars();
+
+	if (nullptr == scalars)
 	{
-		vtkObjectBase *pObject = objectIter->second;
-		vtkNew<vtkPolyDataMapper> mapper;
-		mapper->SetInputConnection(((vtkAlgorithm *)pObject)->GetOutputPort());
+		return false;
+	}
 
-		vtkSmartPointer<vtkActor> actor = vtkSmartPointer<vtkActor>::New();
-		actor->SetMapper(mapper.GetPointer());
-		actor->GetProperty()->SetColor(color.x, color.y, color.z);
-		actor->GetProperty()->SetOpacity(color.w);
+	// a volume with no source to read again from is written out first
+	if (NVolumeFileFormat == record.sourceFormat)
+	{
+		record.spillPath = VolumeSpill::Write(mVolumeLoadOptions.cacheFolder, scalars);
 
-		if (wireframe)
+		if (record.spillPath.empty())
 		{
-			actor->GetProperty()->SetRepresentationToWireframe();
+			LogToDebugLog(DebugLogLevel::DebugLogWarning,
+				std::string("EvictVolume: could not write a spill file in ") + mVolumeLoadOptions.cacheFolder);
+			return false;
 		}
-
-		mNonVolumeProp3Ds.insert(std::make_pair(rid, actor));
-		mRenderer->AddActor(actor);
 	}
-}
 
+	record.evictedScalarType = scalars->GetDataType();
+	record.evictedComponents = scalars->GetNumberOfComponents();
+	record.evicted = true;
 
-LPCSTR VtkToUnityAPI_OpenGLCoreES::VtkError_Get()
-{
-	return VtkIntrospection::ErrorGet();
+	// the geometry stays, the mappers keep their input, the levels are built again once it is shown
+	volumeImageData->GetPointData()->SetScalars(nullptr);
+	record.bricks.reset();
+	record.octree.reset();
+	SyncSharedVolumes(index);
+	ReleaseVolumePyramid(index);
+	return true;
 }
 
 
-bool VtkToUnityAPI_OpenGLCoreES::VtkError_Occurred()
+bool VtkToUnityAPI_OpenGLCoreES::RestoreVolume(const int index)
 {
-	return VtkIntrospection::ErrorOccurred();
-}
-
+	VolumeRecord &record = mVolumeRecords[index];
+	vtkImageData *volumeImageData = mVolumeDataVector[index];
+	const vtkIdType nPoints = volumeImageData->GetNumberOfPoints();
 
-LPCSTR VtkToUnityAPI_OpenGLCoreES::VtkResource_GetAttrAsString(
-	const int rid,
-	LPCSTR propertyName)
-{
-	// Temporary debugging log system as Debug does not seem to work...
-	//ofstream logFile;
-	//logFile.open("log.txt");
-	//logFile << "VtkToUnityAPI_OpenGLCoreES::GetPrimitiveProperty(" << shapeId << ", " << propertyName << ");" << std::endl;
- 
-	auto objectIter = mNonVolumePropObjects.find(rid);
-	auto shapeTypeIter = mNonVolumePropTypes.find(rid);
+	vtkSmartPointer<vtkDataArray> scalars;
 
-	if (mNonVolumePropObjects.end() != objectIter && mNonVolumePropTypes.end() != shapeTypeIter)
+	if (!record.spillPath.empty())
 	{
-		auto object = objectIter->second;
-
-		//logFile << "\tCompare \"height\" against " << propertyName << " yields " << (propertyName == "height") << std::endl;
-		//logFile << "\tCompare \"height\" against " << propertyName << " with std::strcmp yields " << (std::strcmp(propertyName, "height")) << std::endl;
+		scalars = VolumeSpill::Read(
+			record.spillPath, record.evictedScalarType, record.evictedComponents, nPoints);
+		record.spillPath.clear();
+	}
+	else
+	{
+		// read as it was first read, the cache makes this a mapping if it is enabled
+		VolumeLoadOptions options = mVolumeLoadOptions;
+		options.narrowScalarType = record.narrowScalarType;
 
-		// Based on https://stackoverflow.com/questions/54635806/how-to-store-a-double-in-a-void-in-c :: Old, here for future reference in case we revert back to pointers
-		// Based on https://stackoverflow.com/questions/2342162/stdstring-formatting-like-sprintf :: Legacy too
-		// Based on https://stackoverflow.com/questions/7184698/how-do-i-convert-a-int-to-lpctstr-win32 :: Legacy too
-		// Based on https://stackoverflow.com/questions/50710587/convert-double-to-char-array-c?noredirect=1&lq=1
+		VolumeRecord sourceRecord;
+		vtkSmartPointer<vtkImageData> sourceImageData = ReadVolumeFile(
+			record.sourceFormat, record.sourcePath, options, nullptr, sourceRecord);
 
-		vtkAdapter* pAdapter = vtkAdapterUtility::GetAdapter(shapeTypeIter->second);
-		if (pAdapter != NULL)
-		{
-			return pAdapter->GetAttribute(object, propertyName);
-		}
-		else
+		if (nullptr != sourceImageData)
 		{
-			return _strdup(VtkIntrospection::GetProperty(object, propertyName));
+			scalars = sourceImageData->GetPointData()->GetScalars();
+			record.reversePending = sourceRecord.reversePending;
+			record.rescaleSlope = sourceRecord.rescaleSlope;
+			record.rescaleIntercept = sourceRecord.rescaleIntercept;
 		}
 	}
-	else
+
+	// a changed source may no longer fit the volume
+	if (nullptr == scalars ||
+		scalars->GetDataType() != record.evictedScalarType ||
+		scalars->GetNumberOfComponents() != record.evictedComponents ||
+		scalars->GetNumberOfTuples() != nPoints)
 	{
-		return NULL;
+		SyncSharedVolumes(index);
+		return false;
 	}
 
-	//logFile << "\tYielding \"" << retValue << "\"" << std::endl;
-	//logFile.close();
+	volumeImageData->GetPointData()->SetScalars(scalars);
+	record.evicted = false;
+	SyncSharedVolumes(index);
+	return true;
 }
 
 
-void VtkToUnityAPI_OpenGLCoreES::VtkResource_SetAttrFromString(
-	const int rid,
-	LPCSTR propertyName,
-	LPCSTR format,
-	LPCSTR newValue)
+void VtkToUnityAPI_OpenGLCoreES::RemoveVolumesFrom(const int firstIndex)
 {
-	auto objectIter = mNonVolumePropObjects.find(rid);
-	auto shapeTypeIter = mNonVolumePropTypes.find(rid);
-
-	if (mNonVolumePropObjects.end() != objectIter && mNonVolumePropTypes.end() != shapeTypeIter)
+	while (GetNVolumes() > firstIndex)
 	{
-		auto object = objectIter->second;
-
-		vtkAdapter* pAdapter = vtkAdapterUtility::GetAdapter(shapeTypeIter->second);
-		if (pAdapter != NULL)
+		const int index = GetNVolumes() - 1;
+		VolumeRecord &record = mVolumeRecords[index];
+		ReleaseVolumePyramid(index);
+
+		// a spill shared with a volume that stays is kept for it
+		const auto sharingIter = std::find(
+			mVolumeDataVector.begin(), mVolumeDataVector.begin() + firstIndex, mVolumeDataVector[index]);
+		if (!record.spillPath.empty() &&
+			mVolumeDataVector.begin() + firstIndex == sharingIter)
 		{
-			pAdapter->SetAttribute(object, propertyName, newValue);
-		}
-		else
-		{
-			VtkIntrospection::SetProperty(object, propertyName, format, newValue);
+			VolumeSpill::Remove(record.spillPath);
 		}
+
+		mVolumeDataVector.pop_back();
+		mVolumeRecords.pop_back();
 	}
 }
 
 
-LPCSTR VtkToUnityAPI_OpenGLCoreES::VtkResource_GetDescriptor(
-	const int rid)
+void VtkToUnityAPI_OpenGLCoreES::RemoveVolumeSpills()
 {
-	auto objectIter = mNonVolumePropObjects.find(rid);
-	auto shapeTypeIter = mNonVolumePropTypes.find(rid);
-
-	if (mNonVolumePropObjects.end() != objectIter && mNonVolumePropTypes.end() != shapeTypeIter)
+	for (auto &record : mVolumeRecords)
 	{
-		vtkAdapter* pAdapter = vtkAdapterUtility::GetAdapter(shapeTypeIter->second);
-		if (pAdapter != NULL)
-		{
-			 return pAdapter->GetDescriptor();
-		}
-		else
+		if (!record.spillPath.empty())
 		{
-			auto object = vtkActor::SafeDownCast(objectIter->second);
-			return _strdup(VtkIntrospection::GetDescriptor(object));
+			VolumeSpill::Remove(record.spillPath);
+			record.spillPath.clear();
 		}
 	}
-	else
-	{
-		return NULL;
-	}
 }
 
 
-void VtkToUnityAPI_OpenGLCoreES::GetDescriptor(
-	const int shapeId,
-	char* retDescriptor)
+void VtkToUnityAPI_OpenGLCoreES::ShareDuplicateVolume(
+	vtkSmartPointer<vtkImageData> &volumeImageData,
+	VolumeRecord &record)
 {
-	// Dummy implementation for Thomas Thesis
-	// TODO: implement the actual dispatcher
-	retDescriptor = "Height:System.Double,Radius:System.Double,Resolution:System.Int16,Angle:System.Double,Capping:System.Int16,Center:VtkUnityWorkbench.Double3,Direction:VtkUnityWorkbench.Double3";
-}
+	if (!mDeduplicateVolumes)
+	{
+		return;
+	}
 
+	record.contentHash = VolumeHash::Compute(volumeImageData, record.reversePending);
 
-int VtkToUnityAPI_OpenGLCoreES::AddLight()
-{
-	auto light = vtkSmartPointer<vtkLight>::New();
-	light->SetLightTypeToHeadlight();
+	// every volume is on the same grid, so the same voxels in the same units are the same volume
+	for (int iVolume = 0; iVolume < GetNVolumes(); ++iVolume)
+	{
+		const VolumeRecord &existingRecord = mVolumeRecords[iVolume];
+
+		if (0 == record.contentHash ||
+			existingRecord.contentHash != record.contentHash ||
+			existingRecord.evicted ||
+			existingRecord.rescaleSlope != record.rescaleSlope ||
+			existingRecord.rescaleIntercept != record.rescaleIntercept ||
+			!VolumeHash::SameScalars(
+				mVolumeDataVector[iVolume], existingRecord.reversePending,
+				volumeImageData, record.reversePending))
+		{
+			continue;
+		}
 
-	mRenderer->AddLight(light); 
+		// the new copy is dropped here, only its source is kept, for reading it again
+		const VolumeFileFormat sourceFormat = record.sourceFormat;
+		const std::string sourcePath = record.sourcePath;
 
-	mLights.insert(std::make_pair(mNextActorIndex, light));
+		volumeImageData = mVolumeDataVector[iVolume];
+		record = existingRecord;
+		record.sourceFormat = sourceFormat;
+		record.sourcePath = sourcePath;
 
-	return (mNextActorIndex++);
+		LogToDebugLog(DebugLogLevel::DebugLog,
+			"AddVolume: same voxels as an existing volume, sharing them");
+		return;
+	}
 }
 
 
-void VtkToUnityAPI_OpenGLCoreES::SetLightingOn(
-	bool lightingOn)
+void VtkToUnityAPI_OpenGLCoreES::SyncSharedVolumes(const int index)
 {
-	// check we have some lights
-	if (mRenderer->GetLights()->GetNumberOfItems() > 0)
-	{
-		// even if we have, if there has not been one render loop this may still fail
-		// so may need to add a 'first rendrer' flag, and store the desired state
-		mVolumeProperty->SetShade(lightingOn ? 1 : 0);
-
-		//mNonVolumeProp3Ds
-
-		auto nonVolumePropIter = mNonVolumeProp3Ds.begin();
+	const VolumeRecord &record = mVolumeRecords[index];
 
-		while (nonVolumePropIter != mNonVolumeProp3Ds.end())
+	for (int iVolume = 0; iVolume < GetNVolumes(); ++iVolume)
+	{
+		if (iVolume == index ||
+			mVolumeDataVector[iVolume] != mVolumeDataVector[index])
 		{
-			auto actor = vtkActor::SafeDownCast(nonVolumePropIter->second);
-
-			if (NULL != actor)
-			{
-				actor->GetProperty()->SetLighting(lightingOn);
-			}
-
-			++nonVolumePropIter;
+			continue;
 		}
+
+		VolumeRecord &sharedRecord = mVolumeRecords[iVolume];
+		sharedRecord.reversePending = record.reversePending;
+		sharedRecord.rescaleSlope = record.rescaleSlope;
+		sharedRecord.rescaleIntercept = record.rescaleIntercept;
+		sharedRecord.narrowScalarType = record.narrowScalarType;
+		sharedRecord.lastShown = record.lastShown;
+		sharedRecord.evicted = record.evicted;
+		sharedRecord.spillPath = record.spillPath;
+		sharedRecord.evictedScalarType = record.evictedScalarType;
+		sharedRecord.evictedComponents = record.evictedComponents;
+		sharedRecord.paddingMask = record.paddingMask;
+		sharedRecord.bricks = record.bricks;
+		sharedRecord.octree = record.octree;
+		sharedRecord.statistics = record.statistics;
+		sharedRecord.maskedStatistics = record.maskedStatistics;
+		sharedRecord.pyramid = record.pyramid;
 	}
 }
 
 
-void VtkToUnityAPI_OpenGLCoreES::SetLightColor(
-	int id,
-	LightColorType lightColorType,
-	Float4 &rgbColor)
+void VtkToUnityAPI_OpenGLCoreES::QueueVolumePyramid(const int index)
 {
-	// find the light
-	auto lightIter = mLights.find(id);
+	VolumeRecord &record = mVolumeRecords[index];
 
-	if (mLights.end() == lightIter)
+	if (!mVolumePyramidsOn ||
+		nullptr != record.pyramid ||
+		record.evicted ||
+		record.reversePending)
 	{
 		return;
 	}
 
-	auto light = lightIter->second;
+	// the build holds its own reference to the scalars, so evicting or refining
+	// the volume meanwhile does not free them from under it
+	auto volumeSnapshot = vtkSmartPointer<vtkImageData>::New();
+	volumeSnapshot->ShallowCopy(mVolumeDataVector[index]);
 
-	// set that lights colour property
-	if (LightColorAmbient == lightColorType)
-	{
-		light->SetAmbientColor(rgbColor.x, rgbColor.y, rgbColor.z);
-	}
-	else if (LightColorDiffuse == lightColorType)
+	auto pyramid = std::make_shared<VolumePyramid>();
+	mPyramidWorkers.Enqueue([pyramid, volumeSnapshot]()
 	{
-		light->SetDiffuseColor(rgbColor.x, rgbColor.y, rgbColor.z);
-	}
-	else if (LightColorSpecular == lightColorType)
+		pyramid->Build(volumeSnapshot);
+	});
+
+	record.pyramid = pyramid;
+	SyncSharedVolumes(index);
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::QueueVolumePyramids()
+{
+	for (int iVolume = 0; iVolume < GetNVolumes(); ++iVolume)
 	{
-		light->SetSpecularColor(rgbColor.x, rgbColor.y, rgbColor.z);
+		QueueVolumePyramid(iVolume);
 	}
 }
 
 
-void VtkToUnityAPI_OpenGLCoreES::SetLightIntensity(
-	int id,
-	float intensity)
+void VtkToUnityAPI_OpenGLCoreES::ReleaseVolumePyramid(const int index)
 {
-	// find the light
-	auto lightIter = mLights.find(id);
+	std::shared_ptr<VolumePyramid> pyramid = mVolumeRecords[index].pyramid;
 
-	if (mLights.end() == lightIter)
+	if (nullptr == pyramid)
 	{
 		return;
 	}
 
-	auto light = lightIter->second;
+	pyramid->Cancel();
+	mVolumeRecords[index].pyramid.reset();
+	SyncSharedVolumes(index);
 
-	light->SetIntensity(intensity);
+	for (int level = 1; level < VolumePyramid::sNLevels; ++level)
+	{
+		vtkImageData *levelImageData = pyramid->GetLevel(level);
+
+		if (nullptr == levelImageData)
+		{
+			break;
+		}
+
+		for (auto &volumeMapperPair : mVolumeMappers)
+		{
+			for (auto &volumeMapper : volumeMapperPair.second)
+			{
+				if (volumeMapper->GetInput() == levelImageData)
+				{
+					SetVolumeMapperInput(volumeMapper, mVolumeDataVector[index]);
+				}
+			}
+		}
+
+		for (auto &reslicePair : mReslice)
+		{
+			if (reslicePair.second->GetInput() == levelImageData)
+			{
+				reslicePair.second->SetInputData(mCurrentVolumeData);
+			}
+		}
+	}
 }
 
 
-void VtkToUnityAPI_OpenGLCoreES::SetVolumeLighting(
-	VolumeLightType volumeLightType,
-	float lightValue)
+void VtkToUnityAPI_OpenGLCoreES::ApplyPropVolumeLevels()
 {
-	// set the volume properties colour
-	if (VolumeLightAmbient == volumeLightType)
-	{
-		mVolumeProperty->SetAmbient(lightValue);
-	}
-	else if (VolumeLightDiffuse == volumeLightType)
+	bool mapperInputChanged(false);
+
+	for (auto &volumeMapperPair : mVolumeMappers)
 	{
-		mVolumeProperty->SetDiffuse(lightValue);
+		const int level = GetPropVolumeLevel(volumeMapperPair.first);
+		auto &volumeMappersVector = volumeMapperPair.second;
+
+		// a prop has no mappers for the volumes added after it
+		for (int iVolume = 0; iVolume < volumeMappersVector.size() && iVolume < GetNVolumes(); ++iVolume)
+		{
+			auto volumeMapper = volumeMappersVector[iVolume];
+			vtkImageData *mapperImageData = volumeMapper->GetInput();
+
+			// leave mappers of volumes since cleared on what they were given, and
+			// streaming mappers holding another volume
+			vtkImageData *levelImageData = GetVolumeLevel(iVolume, level);
+			if (IsVolumeInput(mapperImageData, iVolume) &&
+				mapperImageData != levelImageData)
+			{
+				SetVolumeMapperInput(volumeMapper, levelImageData);
+				mapperInputChanged = true;
+			}
+		}
 	}
-	else if (VolumeLightSpecular == volumeLightType)
+
+	for (auto &reslicePair : mReslice)
 	{
-		mVolumeProperty->SetSpecular(lightValue);
+		vtkImageData *resliceImageData = GetResliceInput(reslicePair.first);
+		auto resliceColorIter = mResliceColors.find(reslicePair.first);
+
+		if (reslicePair.second->GetInput() != resliceImageData &&
+			mResliceColors.end() != resliceColorIter)
+		{
+			reslicePair.second->SetInputData(resliceImageData);
+			reslicePair.second->Update();
+			resliceColorIter->second->Update();
+		}
 	}
-	else if (VolumeLightSpecularPower == volumeLightType)
+
+	// the mask only fits the full volume
+	if (mapperInputChanged)
 	{
-		mVolumeProperty->SetSpecularPower(lightValue);
+		BindVolumeMasks();
 	}
 }
 
 
-void VtkToUnityAPI_OpenGLCoreES::RemoveProp3D(
-	int id)
+vtkImageData *VtkToUnityAPI_OpenGLCoreES::GetVolumeLevel(const int index, const int level) const
 {
+	const auto &pyramid = mVolumeRecords[index].pyramid;
+
+	for (int iLevel = level; nullptr != pyramid && iLevel > 0; --iLevel)
 	{
-		// was it a non-volume prop, e.g. primitive, mpr
-		auto actorIter = mNonVolumeProp3Ds.find(id);
+		vtkImageData *levelImageData = pyramid->GetLevel(iLevel);
 
-		// We've found it, so destroy it!
-		if (mNonVolumeProp3Ds.end() != actorIter)
+		if (nullptr != levelImageData)
 		{
-			mRenderer->RemoveActor(actorIter->second);
-			VtkIntrospection::DeleteObject((vtkActor::SafeDownCast(actorIter->second))->GetMapper()->GetInputConnection(0, 0)->GetProducer());
-			mNonVolumeProp3Ds.erase(id);
-			mNonVolumePropTypes.erase(id);
+			return levelImageData;
 		}
 	}
 
-	{
-		// was it a volume prop
-		auto actorVectorIter = mVolumeProp3Ds.find(id);
+	return mVolumeDataVector[index];
+}
 
-		// We've found it, so destroy it!
-		if (mVolumeProp3Ds.end() != actorVectorIter)
-		{
-			for (auto actorIter : actorVectorIter->second)
-			{
-				mRenderer->RemoveActor(actorIter);
-			}
 
-			mVolumeProp3Ds.erase(id);
-		}
-	}
+int VtkToUnityAPI_OpenGLCoreES::GetPropVolumeLevel(const int propId) const
+{
+	auto levelIter = mPropVolumeLevels.find(propId);
+	const int level = (mPropVolumeLevels.end() != levelIter) ? levelIter->second : 0;
 
-	// remove any volume mappers
-	auto volumeMapperIter = mVolumeMappers.find(id);
+	return mInMotion ? std::max(level, mMotionVolumeLevel) : level;
+}
 
-	// This was a volume so destory the mapper too
-	if (mVolumeMappers.end() != volumeMapperIter)
+
+bool VtkToUnityAPI_OpenGLCoreES::IsVolumeInput(
+	vtkImageData *inputImageData,
+	const int index) const
+{
+	if (nullptr == inputImageData)
 	{
-		// todo - Hmm, I'm not 100% on how to get rid of the mapper properly
-		//*volumeMapperIter = NULL;
-		mVolumeMappers.erase(id);
+		return false;
 	}
 
-
-	// This was a reslice, so destroy that object too
+	if (inputImageData == mVolumeDataVector[index].GetPointer())
 	{
-		// may need to do some other operations here to properly clean up
-		mReslice.erase(id);
-		mResliceTransforms.erase(id);
-		mResliceColors.erase(id);
+		return true;
 	}
 
+	const auto &pyramid = mVolumeRecords[index].pyramid;
+	for (int iLevel = 1; nullptr != pyramid && iLevel < VolumePyramid::sNLevels; ++iLevel)
 	{
-		// was it a light
-		auto lightIter = mLights.find(id);
-
-		// We've found it, so destroy it!
-		if (mLights.end() != lightIter)
+		if (inputImageData == pyramid->GetLevel(iLevel).GetPointer())
 		{
-			mRenderer->RemoveLight(lightIter->second);
-			mLights.erase(id);
+			return true;
 		}
 	}
 
+	return false;
 }
 
 
-void VtkToUnityAPI_OpenGLCoreES::SetProp3DTransform(
-	int id,
-	Float16 transform)
+void VtkToUnityAPI_OpenGLCoreES::UpdateStreamingVolumeProps()
 {
-	// is it a not-a-volume prop?
+	if (mCurrentVolumeIndex < 0)
 	{
-		auto actorIter = mNonVolumeProp3Ds.find(id);
+		return;
+	}
 
-		if (mNonVolumeProp3Ds.end() != actorIter)
+	for (auto &streamingPropPair : mStreamingVolumeProps)
+	{
+		StreamingVolumeProp &streamingProp = streamingPropPair.second;
+		auto &mappers = streamingProp.mappers;
+
+		// is the current volume, or one sharing its voxels, already in a pool mapper
+		size_t iShowMapper = mappers.size();
+		for (size_t iMapper = 0; iMapper < mappers.size(); ++iMapper)
 		{
-			auto prop3D = actorIter->second;
-			auto vtkMatrix = Float16ToVtkMatrix4x4(transform);
-			prop3D->SetUserMatrix(vtkMatrix);
-			prop3D->Modified();
-			return;
+			if (IsVolumeInput(mappers[iMapper]->GetInput(), mCurrentVolumeIndex))
+			{
+				iShowMapper = iMapper;
+			}
 		}
-	}
 
-	// is it a volume prop?
-	{
-		auto volumeProp3DsIter = mVolumeProp3Ds.find(id);
+		if (mappers.size() == iShowMapper)
+		{
+			iShowMapper = static_cast<size_t>(std::min_element(
+				streamingProp.mapperLastShown.begin(),
+				streamingProp.mapperLastShown.end()) - streamingProp.mapperLastShown.begin());
+
+			// a mapper new to the pool has its sample distance set for the full volume
+			const int level = GetPropVolumeLevel(streamingPropPair.first);
+			auto volumeMapper = mappers[iShowMapper];
+			if (nullptr == volumeMapper->GetInput())
+			{
+				volumeMapper->SetInputData(mVolumeDataVector[mCurrentVolumeIndex]);
+			}
+			SetVolumeMapperInput(volumeMapper, GetVolumeLevel(mCurrentVolumeIndex, level));
+		}
 
-		if (mVolumeProp3Ds.end() != volumeProp3DsIter)
+		streamingProp.mapperLastShown[iShowMapper] = ++streamingProp.showCounter;
+		streamingProp.volumeProp->SetMapper(mappers[iShowMapper]);
+
+		// the volumes added since the prop take entries too
+		auto &volumePropsVector = mVolumeProp3Ds[streamingPropPair.first];
+		auto &volumeMappersVector = mVolumeMappers[streamingPropPair.first];
+		const size_t nVolumes = static_cast<size_t>(GetNVolumes());
+		const size_t nEntries = std::max(nVolumes, mappers.size());
+		volumePropsVector.resize(nEntries, streamingProp.volumeProp);
+		volumeMappersVector.resize(nEntries);
+
+		for (size_t iEntry = 0; iEntry < nEntries; ++iEntry)
 		{
-			auto volumePropsVector = (*volumeProp3DsIter).second;
+			volumeMappersVector[iEntry] = mappers[iEntry % mappers.size()];
 
-			for (auto volumeProp : volumePropsVector)
+			for (size_t iMapper = 0; iEntry < nVolumes && iMapper < mappers.size(); ++iMapper)
 			{
-				//auto prop3D = actorIter->second;
-				auto vtkMatrix = Float16ToVtkMatrix4x4(transform);
-				volumeProp->SetUserMatrix(vtkMatrix);
-				volumeProp->Modified();
+				if (IsVolumeInput(mappers[iMapper]->GetInput(), static_cast<int>(iEntry)))
+				{
+					volumeMappersVector[iEntry] = mappers[iMapper];
+				}
 			}
-			
-			return;
 		}
 	}
+}
+
+
+vtkImageData *VtkToUnityAPI_OpenGLCoreES::GetResliceInput(const int mprId) const
+{
+	auto levelIter = mPropVolumeLevels.find(mprId);
+
+	if (mPropVolumeLevels.end() == levelIter ||
+		mCurrentVolumeIndex < 0)
+	{
+		return mCurrentVolumeData;
+	}
 
-	// is it a plane?
+	// the full volume is resliced through the current volume data, which the scene keeps
+	vtkImageData *levelImageData = GetVolumeLevel(mCurrentVolumeIndex, levelIter->second);
+	return (levelImageData != mVolumeDataVector[mCurrentVolumeIndex].GetPointer())
+		? levelImageData
+		: mCurrentVolumeData.GetPointer();
+}
+
+
+void VtkToUnityAPI_OpenGLCoreES::UpdateVolumeBricks(const int index)
+{
+	VolumeRecord &record = mVolumeRecords[index];
+
+	if (0 == mVolumeBrickSize ||
+		nullptr != record.bricks ||
+		record.evicted ||
+		record.reversePending)
 	{
-		auto planeIter = mVolumeCropPlanes.find(id);
+		return;
+	}
 
-		if (mVolumeCropPlanes.end() != planeIter)
-		{
-			auto vtkMatrix = Float16ToVtkMatrix4x4(transform);
-			vtkNew<vtkTransform> vtkTransform;
-			vtkTransform->SetMatrix(vtkMatrix);
+	record.bricks = VolumeBricks::Build(mVolumeDataVector[index], mVolumeBrickSize);
 
-			auto plane = planeIter->second;
-			plane->SetOrigin(vtkTransform->TransformPoint(0.0, 0.0, 0.0));
-			plane->SetNormal(vtkTransform->TransformNormal(0.0, 1.0, 0.0));
-			plane->Modified();
-			return;
-		}
+	if (nullptr != record.bricks &&
+		mPaddingMaskOn)
+	{
+		record.bricks->SetPaddingValue(
+			(mPaddingMaskValue - record.rescaleIntercept) / record.rescaleSlope);
 	}
 
-	// no it's an unidentified object! Could have an error message here
+	record.octree = (nullptr != record.bricks)
+		? VolumeOctree::Build(*record.bricks)
+		: nullptr;
+
+	SyncSharedVolumes(index);
 }
 
 
-void VtkToUnityAPI_OpenGLCoreES::SetMPRTransform(
-	const int id,
-	Float16 transformVolume)
+void VtkToUnityAPI_OpenGLCoreES::UpdateVolumePaddingMask(const int index)
 {
-	auto resliceTransformIter = mResliceTransforms.find(id);
-	auto resliceColorIter = mResliceColors.find(id);
+	VolumeRecord &record = mVolumeRecords[index];
 
-	if (mResliceTransforms.end() == resliceTransformIter || 
-		mResliceColors.end() == resliceColorIter)
+	if (!mPaddingMaskOn ||
+		nullptr != record.paddingMask ||
+		record.evicted ||
+		record.reversePending)
 	{
 		return;
 	}
 
-	auto resliceTransform = resliceTransformIter->second;
-	auto vtkMatrix = Float16ToVtkMatrix4x4(transformVolume);
-	resliceTransform->SetMatrix(vtkMatrix);
-	resliceTransform->Modified();
+	// the padding value is in source units, each volume may be rescaled differently
+	const double storedPaddingValue =
+		(mPaddingMaskValue - record.rescaleIntercept) / record.rescaleSlope;
 
-	// this should force the image to be updated
-	auto resliceColor = resliceColorIter->second;
-	resliceColor->Update();
+	// bricks wholly in or out of the padding are masked without reading them
+	UpdateVolumeBricks(index);
+	if (nullptr != record.bricks)
+	{
+		record.bricks->SetPaddingValue(storedPaddingValue);
+		record.octree->UpdatePadding(*record.bricks);
+	}
+
+	record.paddingMask = PackedVolumeMask::FromPadding(
+		mVolumeDataVector[index], storedPaddingValue, record.bricks.get());
+	SyncSharedVolumes(index);
 }
 
 
-void VtkToUnityAPI_OpenGLCoreES::UpdateVtkCameraAndRender(
-	const std::array<double, 16> &viewMatrix,
-	const std::array<double, 16> &projectionMatrix)
+void VtkToUnityAPI_OpenGLCoreES::BindVolumeMasks()
 {
-	mRenderer->SetViewMatrix(viewMatrix);
-	mRenderer->SetProjectionMatrix(projectionMatrix);
+	for (auto &volumeMapperPair : mVolumeMappers)
+	{
+		auto &volumeMappersVector = volumeMapperPair.second;
 
-	mRenderer->ResetCameraClippingRange();
+		// a mapper shared by volumes with the same voxels is the current one's if any is current
+		vtkGPUVolumeRayCastMapper *currentMapper = (mCurrentVolumeIndex >= 0 &&
+			mCurrentVolumeIndex < volumeMappersVector.size())
+			? volumeMappersVector[mCurrentVolumeIndex].GetPointer()
+			: nullptr;
 
-	if (mRenderScene)
-	{
-		mExternalVTKWidget->GetRenderWindow()->Render();
+		for (int iVolumeMapper = 0; iVolumeMapper < volumeMappersVector.size(); ++iVolumeMapper)
+		{
+			auto volumeMapper = volumeMappersVector[iVolumeMapper];
+
+			if (volumeMapper == currentMapper &&
+				volumeMapper->GetInput() == mVolumeDataVector[mCurrentVolumeIndex].GetPointer() &&
+				nullptr != mCurrentVolumeMask)
+			{
+				volumeMapper->SetMaskInput(mCurrentVolumeMask);
+				volumeMapper->SetMaskTypeToBinary();
+			}
+			else
+			{
+				// drops the expanded mask, and its texture, of a hidden volume
+				volumeMapper->SetMaskInput(nullptr);
+			}
+		}
 	}
 }
 
 
-void VtkToUnityAPI_OpenGLCoreES::LogToDebugLog(
-	const DebugLogLevel level,
-	const std::string& message)
+void VtkToUnityAPI_OpenGLCoreES::NarrowVolumeScalars(
+	vtkSmartPointer<vtkImageData> volumeImageData,
+	const VolumeLoadOptions &options,
+	VolumeRecord &record)
 {
-	if (nullptr == mDebugLog)
+	if (VTK_VOID == options.narrowScalarType)
 	{
 		return;
 	}
 
-	(*mDebugLog)(level, message);
+	// a pending reverse is done by the same pass
+	double slope;
+	double intercept;
+	if (ScalarNarrowing::Narrow(
+		volumeImageData,
+		options.narrowScalarType,
+		record.reversePending,
+		slope,
+		intercept))
+	{
+		// on top of any rescale the source itself has, as for NIfTI
+		record.rescaleIntercept += record.rescaleSlope * intercept;
+		record.rescaleSlope *= slope;
+		record.reversePending = false;
+		record.narrowScalarType = options.narrowScalarType;
+	}
 }
 
 
-void VtkToUnityAPI_OpenGLCoreES::CreateResources()
+double VtkToUnityAPI_OpenGLCoreES::ToStoredScalar(const double value) const
 {
-	mNextActorIndex = 0;
-	mNonVolumeProp3Ds.clear();
-	mNonVolumePropObjects.clear();
-	mNonVolumePropTypes.clear();
-	mVolumeProp3Ds.clear();
-	mLights.clear();
+	return (value - mRescaleIntercept) / mRescaleSlope;
+}
 
-	// create the VTK external renderer
-	mRenderWindow = vtkSmartPointer<vtkExternalOpenGLRenderWindow>::New();
-	mExternalVTKWidget->SetRenderWindow(mRenderWindow);
-	mExternalVTKWidget->GetRenderWindow()->AddRenderer(mRenderer.GetPointer());
 
-	vtkFrustumCoverageCuller *frustrumCoverageCuller = vtkFrustumCoverageCuller::SafeDownCast(mRenderer->GetCullers()->GetLastItem());
-	frustrumCoverageCuller->SetSortingStyleToBackToFront();
+void VtkToUnityAPI_OpenGLCoreES::UpdateScalarRescale()
+{
+	double rescaleSlope(1.0);
+	double rescaleIntercept(0.0);
 
-	mCurrentVolumeIndex = -1;
+	if (mCurrentVolumeIndex >= 0)
+	{
+		rescaleSlope = mVolumeRecords[mCurrentVolumeIndex].rescaleSlope;
+		rescaleIntercept = mVolumeRecords[mCurrentVolumeIndex].rescaleIntercept;
+	}
 
-	// Set up the Volume transfer functions, mappers, props etc.
-	mWindowWidth = 150.0;
-	mWindowLevel = 100.0;
-	mOpacityFactor = 1.0;
-	mBrightnessFactor = 1.0;
+	// frames with the same rescale leave the transfer function, and its texture, alone
+	if (rescaleSlope == mRescaleSlope &&
+		rescaleIntercept == mRescaleIntercept)
+	{
+		return;
+	}
 
-	ResetTransferFunctions();
+	mRescaleSlope = rescaleSlope;
+	mRescaleIntercept = rescaleIntercept;
 
-	UpdateVolumeColorAndOpacity();
+	mVolumeWindowDirty = true;
+	UpdateMPRLookupTable();
+}
 
-	mVolumeProperty->SetColor(mVolumeColor.GetPointer());
-	mVolumeProperty->SetScalarOpacity(mVolumeOpacity.GetPointer());
-	mVolumeProperty->SetInterpolationTypeToLinear();
-	mVolumeProperty->SetScalarOpacityUnitDistance(0.001); // compensate for m / mm
 
-	mVolumeProperty->SetAmbient(0.1);
-	mVolumeProperty->SetDiffuse(0.9);
-	mVolumeProperty->SetSpecular(0.2);
-	mVolumeProperty->SetSpecularPower(10.0);
+void VtkToUnityAPI_OpenGLCoreES::UpdateVolumeColorAndOpacity()
+{
+	const auto &transferFunction = mTransferFunctions[mTransferFunctionIndex];
 
-	mVolumeMappers.clear();
+	mTransferFunctionNodes.clear();
+	mTransferFunctionNodes.reserve(transferFunction.size());
 
-	// Create a synthetic volume to default to rendering
+	for (const auto &transferFunctionPoint : transferFunction)
 	{
-		//Assigning Values , Allocating Memory
-		const int maxX = 200;
-		const int maxY = 200;
-		const int maxZ = 150;
-		mSyntheticVolumeData->SetDimensions(maxX, maxY, maxZ);
-		mSyntheticVolumeData->AllocateScalars(VTK_INT, 1);
-		vtkTypeInt32 *voxel = static_cast<vtkTypeInt32*>(mSyntheticVolumeData->GetScalarPointer());
-		mSyntheticVolumeData->UpdateCellGhostArrayCache();
+		const auto &colourArray = transferFunctionPoint.second;
 
-		for (int z = 0; z < maxZ; z++)
-		{
-			for (int y = 0; y < maxY; y++)
-			{
-				for (int x = 0; x < maxX; x++)
-				{
-					*voxel++ = z * 3;
-				}
-			}
-		}
-
-		std::array<double, 3> spacing = { {0.001, 0.001, 0.001} };
-		mSyntheticVolumeData->SetSpacing(spacing.data());
+		mTransferFunctionNodes.push_back({ {
+			transferFunctionPoint.first * sWindowFractionIntegerToDouble,
+			clip(0.0, 1.0, colourArray[sRedIndex] * mBrightnessFactor),
+			clip(0.0, 1.0, colourArray[sGreenIndex] * mBrightnessFactor),
+			clip(0.0, 1.0, colourArray[sBlueIndex] * mBrightnessFactor),
+			clip(0.0, 1.0, colourArray[sOpacityIndex] * mOpacityFactor) } });
 	}
 
-	// And set the current volume to point to it
-	mCurrentVolumeData = vtkSmartPointer<vtkImageData>::New();
-	mCurrentVolumeData->ShallowCopy(mSyntheticVolumeData.GetPointer());
-
-	// Initialise the MPR looup table
-	// this is a good default for US images
-	mResliceLookupTable->SetRange(0.0, 350.0); // image intensity range
-	mResliceLookupTable->SetValueRange(0.0, 1.0); // from black to white
-	mResliceLookupTable->SetSaturationRange(0.0, 0.0); // no color saturation
-	mResliceLookupTable->SetRampToLinear();
-	mResliceLookupTable->Build();
-
-	mRenderer->ResetCamera();
-	mRenderer->SetLightFollowCamera(false);
-
-	mRenderScene = true;
+	mTransferFunctionDirty = false;
+	UpdateVolumeWindow(true);
 }
 
-void VtkToUnityAPI_OpenGLCoreES::AddVolume(vtkSmartPointer<vtkImageData> volumeImageData)
-{
-	// LogToDebugLog(DebugLogLevel::DebugLog, "VtkToUnityAPI_OpenGLCoreES: AddVolume: Test Message");
-	ReverseVolumeAlongZ(volumeImageData);
-	mVolumeDataVector.push_back(volumeImageData);
-
-	const int index(static_cast<int>(mVolumeDataVector.size()) - 1);
-	SetVolumeIndex(index);
-}
 
-bool VtkToUnityAPI_OpenGLCoreES::CheckVolumeExtentSpacingOrigin(
-	vtkSmartPointer<vtkImageData> volumeImageData)
+void VtkToUnityAPI_OpenGLCoreES::UpdateVolumeWindow(const bool nodesChanged)
 {
-	// Check that the volume given has the same extents etc. as the others
-	std::array<int, 6> extent;
-	volumeImageData->GetExtent(extent.data());
+	// the window and rescale place every fraction in stored scalars by one shift and scale
+	const double windowShift = ToStoredScalar(mWindowLevel);
+	const double windowScale = mWindowWidth / mRescaleSlope;
+	mVolumeWindowDirty = false;
+
+	// leaves the functions, and so the mapper's textures of them, unmodified
+	if (!nodesChanged &&
+		windowShift == mVolumeWindowShift &&
+		windowScale == mVolumeWindowScale)
+	{
+		return;
+	}
 
-	// origin is in mm? converting to m
-	std::array<double, 3> origin;
-	volumeImageData->GetOrigin(origin.data());
+	mVolumeWindowShift = windowShift;
+	mVolumeWindowScale = windowScale;
 
-	// DICOM (and mhd?) dimensions are in mm, Unity is in m, updating the spacing to be in m
-	std::array<double, 3> spacing;
-	volumeImageData->GetSpacing(spacing.data());
-	std::for_each(spacing.begin(), spacing.end(), [](double &s) { s *= sMmToMConversion; });
-	volumeImageData->SetSpacing(spacing.data());
+	std::vector<double> colorNodes;
+	std::vector<double> opacityNodes;
+	colorNodes.reserve(4 * mTransferFunctionNodes.size());
+	opacityNodes.reserve(2 * mTransferFunctionNodes.size());
+	double lastWindowPoint(-DBL_MAX);
 
-	// if this is the first volume, just remember the values
-	if (mVolumeDataVector.empty())
+	for (const auto &transferFunctionNode : mTransferFunctionNodes)
 	{
-		mVolumeExtent = extent;
-		mVolumeSpacingM = spacing;
-		mVolumeOrigin = origin;
-
-		mVolumeExtentMin = { mVolumeExtent[0], mVolumeExtent[2], mVolumeExtent[4] };
-		mVolumeExtentMax = { mVolumeExtent[1], mVolumeExtent[3], mVolumeExtent[5] };
+		const double windowPoint(mWindowLevel + (transferFunctionNode[0] * mWindowWidth));
 
-		for (auto &volumeCentreElem : mVolumeCentre)
+		if (windowPoint <= (lastWindowPoint + sMinTransferFunctionStep))
 		{
-			auto i = &volumeCentreElem - &mVolumeCentre[0];
-			volumeCentreElem = mVolumeSpacingM[i] * -0.5 * (mVolumeExtentMin[i] + mVolumeExtentMax[i]);
+			continue;
 		}
 
-		// set the origin to be the centre of the volume for rotational niceness, 
-		// if not absolute correctness - at least it is clear we're doing this
-		volumeImageData->SetOrigin(mVolumeCentre.data());
-		volumeImageData->GetOrigin(origin.data());
-		mVolumeOriginCentredM = origin;
+		const double storedPoint(windowShift + (transferFunctionNode[0] * windowScale));
+		colorNodes.insert(colorNodes.end(), {
+			storedPoint,
+			transferFunctionNode[1],
+			transferFunctionNode[2],
+			transferFunctionNode[3] });
+		opacityNodes.insert(opacityNodes.end(), {
+			storedPoint,
+			transferFunctionNode[4] });
 
-		return true;
+		lastWindowPoint = windowPoint;
 	}
 
-	// otherwise check that they match
-	if (mVolumeExtent != extent)
+	// filling from no nodes would leave the old ones
+	mVolumeColor->RemoveAllPoints();
+	mVolumeOpacity->RemoveAllPoints();
+	mVolumeColor->FillFromDataPointer(
+		static_cast<int>(colorNodes.size() / 4), colorNodes.data());
+	mVolumeOpacity->FillFromDataPointer(
+		static_cast<int>(opacityNodes.size() / 2), opacityNodes.data());
+
+	UpdateVolumeCropping();
+}
+
+
+VolumeOctree::ScalarIntervals VtkToUnityAPI_OpenGLCoreES::GetVisibleScalarIntervals()
+{
+	VolumeOctree::ScalarIntervals visibleScalars;
+	const int nNodes = mVolumeOpacity->GetSize();
+
+	if (0 == nNodes)
 	{
-		return false;
+		return visibleScalars;
 	}
 
-	const double maxError(1e-6);
+	std::vector<std::array<double, 4>> nodes(nNodes);
+	for (int iNode = 0; iNode < nNodes; ++iNode)
+	{
+		mVolumeOpacity->GetNodeValue(iNode, nodes[iNode].data());
+	}
 
-	for (int i = 0; i < 3; ++i)
+	// the function is clamped, so the end opacities carry on past the end nodes
+	auto addInterval = [&visibleScalars](const double low, const double high)
 	{
-		if (maxError < fabs(mVolumeSpacingM[i] - spacing[i]) ||
-			maxError < fabs(mVolumeOrigin[i] - origin[i]))
+		if (!visibleScalars.empty() &&
+			low <= visibleScalars.back().second)
 		{
-			return false;
+			visibleScalars.back().second = std::max(visibleScalars.back().second, high);
 		}
-	}
-
-	volumeImageData->SetOrigin(mVolumeCentre.data());
-
-	return true;
-}
-
-void VtkToUnityAPI_OpenGLCoreES::ReverseVolumeAlongZ(
-	vtkSmartPointer<vtkImageData> volumeImageData)
-{
-	auto imageCopy = vtkSmartPointer<vtkImageData>::New();
-	imageCopy->DeepCopy(volumeImageData);
+		else
+		{
+			visibleScalars.push_back(std::make_pair(low, high));
+		}
+	};
 
-	std::array<int, 6> volumeExtent;
-	volumeImageData->GetExtent(volumeExtent.data());
+	if (nodes.front()[1] > 0.0)
+	{
+		addInterval(-DBL_MAX, nodes.front()[0]);
+	}
 
-	int scalarSize = volumeImageData->GetScalarSize();
+	for (int iNode = 0; iNode + 1 < nNodes; ++iNode)
+	{
+		if (nodes[iNode][1] > 0.0 ||
+			nodes[iNode + 1][1] > 0.0)
+		{
+			addInterval(nodes[iNode][0], nodes[iNode + 1][0]);
+		}
+	}
 
-	std::array<vtkIdType, 3> increments;
-	volumeImageData->GetIncrements(increments.data());
+	if (nodes.back()[1] > 0.0)
+	{
+		addInterval(nodes.back()[0], DBL_MAX);
+	}
 
-	int scalarType = volumeImageData->GetScalarType();
+	if (!mPaddingMaskOn)
+	{
+		return visibleScalars;
+	}
 
-	unsigned char* inputDataPtr = static_cast<unsigned char*>(volumeImageData->GetScalarPointer());
-	unsigned char* imageCopyDataPtr = static_cast<unsigned char*>(imageCopy->GetScalarPointer());
-	int sliceSize = increments[2] * scalarSize;
-	imageCopyDataPtr += sliceSize * (volumeExtent[5] - 1);
+	// the padding mask hides the stored values within 0.5 of the padding whatever the opacity
+	const double paddingMin = ToStoredScalar(mPaddingMaskValue) - 0.5;
+	const double paddingMax = ToStoredScalar(mPaddingMaskValue) + 0.5;
+	VolumeOctree::ScalarIntervals unmaskedScalars;
 
-	for (int z = volumeExtent[2]; z < volumeExtent[5]; ++z)
+	for (const auto &interval : visibleScalars)
 	{
-		std::memcpy(inputDataPtr, imageCopyDataPtr, sliceSize);
-		inputDataPtr += sliceSize;
-		imageCopyDataPtr -= sliceSize;
+		if (interval.first < paddingMin)
+		{
+			unmaskedScalars.push_back(std::make_pair(interval.first, std::min(interval.second, paddingMin)));
+		}
+
+		if (interval.second > paddingMax)
+		{
+			unmaskedScalars.push_back(std::make_pair(std::max(interval.first, paddingMax), interval.second));
+		}
 	}
+
+	return unmaskedScalars;
 }
 
 
-void VtkToUnityAPI_OpenGLCoreES::UpdateVolumeColorAndOpacity()
+void VtkToUnityAPI_OpenGLCoreES::UpdateVolumeCropping()
 {
-	auto transferFunction = mTransferFunctions[mTransferFunctionIndex];
-
-	double windowMin(-DBL_MAX);
-	double lastWindowPoint(windowMin);
-
-	mVolumeColor->RemoveAllPoints();
-	mVolumeOpacity->RemoveAllPoints();
-
-	for (auto transferFunctionPoint : transferFunction)
+	std::array<int, 6> visibleExtent;
+	const bool cropped = mEmptySpaceCropping &&
+		mCurrentVolumeIndex >= 0 &&
+		nullptr != mVolumeRecords[mCurrentVolumeIndex].octree &&
+		mVolumeRecords[mCurrentVolumeIndex].octree->GetVisibleExtent(
+			GetVisibleScalarIntervals(), mPaddingMaskOn, visibleExtent);
+
+	// the cropping planes are in the volume's own space, whatever level the mapper is given
+	std::array<double, 6> croppingPlanes;
+	if (cropped)
 	{
-		const double windowPointFromFraction(
-			mWindowLevel
-			+ (transferFunctionPoint.first * sWindowFractionIntegerToDouble * mWindowWidth));
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			for (int side = 0; side < 2; ++side)
+			{
+				croppingPlanes[(2 * axis) + side] = mVolumeCentre[axis] + (mVolumeSpacingM[axis] *
+					(mVolumeExtent[2 * axis] + visibleExtent[(2 * axis) + side]));
+			}
+		}
+	}
 
-		const double windowPoint(
-			std::max(windowMin, windowPointFromFraction));
+	for (auto &volumeMapperPair : mVolumeMappers)
+	{
+		auto &volumeMappersVector = volumeMapperPair.second;
 
-		if (windowPoint <= (lastWindowPoint + sMinTransferFunctionStep))
+		if (mCurrentVolumeIndex < 0 ||
+			mCurrentVolumeIndex >= volumeMappersVector.size())
 		{
 			continue;
 		}
 
-		auto colourArray = transferFunctionPoint.second;
+		// nothing visible is left uncropped, the ray caster finds it transparent anyway
+		auto volumeMapper = volumeMappersVector[mCurrentVolumeIndex];
+		volumeMapper->SetCropping(cropped);
 
-		mVolumeColor->AddRGBPoint(
-			windowPoint,
-			clip(0.0, 1.0, colourArray[sRedIndex] * mBrightnessFactor),
-			clip(0.0, 1.0, colourArray[sGreenIndex] * mBrightnessFactor),
-			clip(0.0, 1.0, colourArray[sBlueIndex] * mBrightnessFactor));
+		if (cropped)
+		{
+			volumeMapper->SetCroppingRegionPlanes(croppingPlanes.data());
+			volumeMapper->SetCroppingRegionFlagsToSubVolume();
+		}
+	}
+}
 
-		mVolumeOpacity->AddPoint(
-			windowPoint,
-			clip(0.0, 1.0, colourArray[sOpacityIndex] * mOpacityFactor));
 
-		lastWindowPoint = windowPoint;
-	}
+void VtkToUnityAPI_OpenGLCoreES::UpdateMPRLookupTable()
+{
+	mResliceLookupTable->SetTableRange(
+		ToStoredScalar(mMPRWindowLevel - (0.5 * mMPRWindowWidth)),
+		ToStoredScalar(mMPRWindowLevel + (0.5 * mMPRWindowWidth))); // image intensity range
+	mResliceLookupTable->Build();
 }
 
 #endif // #if SUPPORT_OPENGL_UNIFIED
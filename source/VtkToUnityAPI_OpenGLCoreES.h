@@ -13,14 +13,20 @@
 #include <vtkImageMapToColors.h>
 #include <vtkImageReslice.h>
 #include <vtkLookupTable.h>
+#include <vtkOpenGLRenderTimer.h>
 #include <vtkPiecewiseFunction.h>
 #include <vtkTransform.h>
 #include <vtkVolumeMapper.h>
 #include <vtkVolumeProperty.h>
+#include <chrono>
 #include <memory>
 
 #include "vtkExternalOpenGLRenderer3dh.h"
 #include "Introspection/vtkIntrospection.h"
+#include "Volumes/VolumeLoadOptions.h"
+#include "Volumes/VolumeLoadQueue.h"
+#include "Volumes/VolumeQualityController.h"
+#include "Volumes/WorkerPool.h"
 
 // Renderer Class Declaraion ======================================================================
 
@@ -47,6 +53,92 @@ public:
 		const std::string &mhdPath);
 	virtual bool LoadNrrdImage(
 		const std::string &nrrdPath);
+	virtual bool LoadNiftiImage(
+		const std::string &niftiPath);
+
+	virtual bool LoadVolumeFromMemory(
+		void *buffer,
+		const std::array<int, 3> &dimensions,
+		const std::array<double, 3> &spacing,
+		const std::array<double, 3> &origin,
+		const int scalarType,
+		const int nComponents,
+		const bool reverseSlices,
+		std::function<void()> release);
+
+	virtual int LoadVolumeSeries(
+		const VolumeFileFormat format,
+		const std::vector<std::string> &paths);
+
+	virtual int AddPhantomVolume(
+		const VolumePhantomType type,
+		const std::array<int, 3> &dimensions,
+		const int scalarType,
+		const int nFrames);
+
+	virtual void SetParallelDicomLoading(const bool parallel);
+	virtual void SetMemoryMappedLoading(const bool memoryMapped);
+	virtual void SetPipelinedInflate(const bool pipelined);
+	virtual void SetProgressiveLoading(const bool progressive, const int previewStride);
+	virtual void SetScalarNarrowing(const int bitsPerVoxel);
+
+	virtual bool BenchmarkVolumeReaders(
+		const VolumeFileFormat format,
+		const std::string &path,
+		const int nRuns);
+	virtual bool BenchmarkVolumeLoadMemory(
+		const std::string &folder,
+		const int sizeMB);
+	virtual bool CheckVolumeSeriesLoading(
+		const std::string &folder);
+
+	virtual void SetVolumeMemoryBudgetMB(const int budgetMB);
+	virtual int GetNResidentVolumes();
+	virtual int GetNEvictedVolumes();
+
+	virtual void SetVolumeDeduplication(const bool deduplicate);
+	virtual int GetNDistinctVolumes();
+
+	virtual void SetVolumePyramids(const bool enabled);
+	virtual int GetNVolumePyramidLevels(const int volumeIndex);
+	virtual void SetPropVolumeLevel(const int propId, const int level);
+
+	virtual void SetVolumeBrickSize(const int brickSize);
+	virtual int GetNVolumeBricks(const int volumeIndex);
+	virtual int GetNPaddingVolumeBricks(const int volumeIndex);
+
+	virtual void SetVolumeStreaming(const int poolSize);
+
+	virtual void SetEmptySpaceCropping(const bool cropping);
+	virtual bool ProbeVolume(
+		const std::array<double, 3> &positionM,
+		double &value,
+		double &opacity);
+	virtual bool CastRayIntoVolume(
+		const std::array<double, 3> &originM,
+		const std::array<double, 3> &directionM,
+		std::array<double, 3> &hitM);
+
+	virtual bool GetVolumeStatistics(
+		const int volumeIndex,
+		const bool maskedOnly,
+		const int nBins,
+		double *statistics,
+		double *histogram);
+
+	virtual void SetVolumeCacheEnabled(const bool enabled);
+	virtual void SetVolumeCacheFolder(const std::string &folder);
+	virtual void SetVolumeCacheSizeLimitMB(const int sizeLimitMB);
+	virtual void ClearVolumeCache();
+
+	virtual int LoadVolumeAsync(
+		const VolumeFileFormat format,
+		const std::string &path);
+	virtual float GetVolumeLoadProgress(const int ticket);
+	virtual VolumeLoadStatus GetVolumeLoadStatus(const int ticket);
+	virtual int GetVolumeLoadIndex(const int ticket);
+	virtual void CancelVolumeLoad(const int ticket);
+	virtual void UpdateVolumeLoads();
 
 	virtual bool CreatePaddingMask(int paddingValue);
 
@@ -77,14 +169,37 @@ public:
 		const double green1,
 		const double blue1,
 		const double opacity1);
+	virtual void SetTransferFunctionPoints(
+		const int transferFunctionIndex,
+		const int nPoints,
+		const double *windowFractions,
+		const double *reds,
+		const double *greens,
+		const double *blues,
+		const double *opacities);
 	virtual void SetVolumeWWWL(const double windowWidth, const double windowLevel);
 	virtual void SetVolumeOpactityFactor(const double opacityFactor);
 	virtual void SetVolumeBrightnessFactor(const double brightnessFactor);
+	virtual void UpdateTransferFunction();
 
 	virtual void SetRenderComposite(const bool composite);
 
 	virtual void SetTargetFrameRateOn(const bool targetOn);
 	virtual void SetTargetFrameRateFps(const int targetFps);
+	virtual void SetAdaptiveSampling(const bool adaptiveOn, const double targetFps);
+	virtual void SetAdaptiveSamplingBounds(
+		const double minSampleDistanceScale,
+		const double maxSampleDistanceScale,
+		const double minImageSampleDistance,
+		const double maxImageSampleDistance);
+	virtual float GetRenderTimeMs();
+	virtual void SetMotionLOD(const bool motionLODOn, const double idleSeconds);
+	virtual void SetMotionLODQuality(
+		const double sampleDistanceScale,
+		const double imageSampleDistance,
+		const int volumeLevel);
+	virtual void SetSkipUnchangedRenders(const bool skipUnchanged);
+	virtual int GetNSkippedRenders();
 
 	virtual int AddMPR(const int existingMprId, const int flipAxis);
 	virtual void SetMPRWWWL(const double windowWidth, const double windowLevel);
@@ -288,7 +403,51 @@ protected:
 
 	void LogToDebugLog(const DebugLogLevel level, const std::string& message);
 
-	void AddVolume(vtkSmartPointer<vtkImageData> volumeImageData);
+	// Reads the volume reversed along z, unless the record says the reverse is
+	// pending, from the cache if it is there. Safe to call from the loader
+	// thread as it does not touch the scene
+	vtkSmartPointer<vtkImageData> ReadVolumeFile(
+		const VolumeFileFormat format,
+		const std::string &path,
+		const VolumeLoadOptions &options,
+		LoadProgress *progress,
+		VolumeRecord &record);
+
+	vtkSmartPointer<vtkImageData> ReadVolumeFromSource(
+		const VolumeFileFormat format,
+		const std::string &path,
+		const VolumeLoadOptions &options,
+		LoadProgress *progress,
+		VolumeRecord &record);
+
+	// deduplicate is false for previews, which are refined in place
+	void AddVolume(
+		vtkSmartPointer<vtkImageData> volumeImageData,
+		const VolumeRecord &record,
+		const bool deduplicate = true);
+
+	// Hashes a volume about to be added, and swaps it for the vtkImageData of
+	// a resident volume with the same voxels if there is one
+	void ShareDuplicateVolume(
+		vtkSmartPointer<vtkImageData> &volumeImageData,
+		VolumeRecord &record);
+	// Copies the state of a volume's voxels to the other volumes sharing them
+	void SyncSharedVolumes(const int index);
+
+	// Starts building the volume's pyramid if it has none, once it is in display order
+	void QueueVolumePyramid(const int index);
+	void QueueVolumePyramids();
+	// Drops the volume's levels, the props and MPRs shown at them go back to the full volume
+	void ReleaseVolumePyramid(const int index);
+	// Sets each prop's mappers, and MPR's reslice, to the level asked for, or the
+	// nearest finer level built so far
+	void ApplyPropVolumeLevels();
+	vtkImageData *GetVolumeLevel(const int index, const int level) const;
+	// The level asked for the volume prop, or the motion level if coarser while moving
+	int GetPropVolumeLevel(const int propId) const;
+	// Whether the image is the volume or one of its levels
+	bool IsVolumeInput(vtkImageData *inputImageData, const int index) const;
+	vtkImageData *GetResliceInput(const int mprId) const;
 
 	bool CheckVolumeExtentSpacingOrigin(
 		vtkSmartPointer<vtkImageData> volumeImageData);
@@ -296,7 +455,60 @@ protected:
 	void ReverseVolumeAlongZ(
 		vtkSmartPointer<vtkImageData> volumeImageData);
 
+	// Drops the scalars of the least recently shown volumes until the rest fit
+	// the memory budget, the current volume is always kept
+	void EnforceVolumeMemoryBudget();
+	bool EvictVolume(const int index);
+	bool RestoreVolume(const int index);
+	void RemoveVolumeSpills();
+	// Drops the volumes from firstIndex on, those of a load failing part way
+	void RemoveVolumesFrom(const int firstIndex);
+
+	// A mapper for a volume prop, inputImageData may be nullptr for one given its input later
+	vtkSmartPointer<vtkGPUVolumeRayCastMapper> CreateVolumeMapper(vtkImageData *inputImageData);
+	int AddStreamingVolumeProp();
+	// Gives every volume mapper the controller's sample distances, or the defaults when it is
+	// off, coarsened further while moving
+	void ApplyVolumeSampleDistances();
+	// Drops the render times not yet read back from the GPU
+	void ResetRenderTimers();
+	// Notes motion if the prop, plane or MPR's transform differs from the one it was last given
+	void NoteTransform(const int id, const Float16 &transform);
+	void NoteMotion();
+	// Back to full quality once nothing has moved for the idle time
+	void UpdateMotionLOD();
+	// The latest modification of anything rendered: props, their mappers, inputs and
+	// properties, the volume property and its transfer functions, lights, planes and reslices
+	vtkMTimeType GetSceneMTime();
+	// Gives each streaming prop's vtkVolume the pool mapper holding the current volume,
+	// loading it into the least recently shown if none does
+	void UpdateStreamingVolumeProps();
+
+	// Builds the volume's bricks if it has none, once it is in display order
+	void UpdateVolumeBricks(const int index);
+	void UpdateVolumePaddingMask(const int index);
+	void BindVolumeMasks();
+
+	// Requantises the volume if the options ask for it, recording the rescale
+	void NarrowVolumeScalars(
+		vtkSmartPointer<vtkImageData> volumeImageData,
+		const VolumeLoadOptions &options,
+		VolumeRecord &record);
+
+	// Window and transfer function values are in the units of the source,
+	// these convert them to those stored in the current volume
+	double ToStoredScalar(const double value) const;
+	void UpdateScalarRescale();
+
+	// Rebuilds the transfer function's nodes, then places them in the window
 	void UpdateVolumeColorAndOpacity();
+	// Places the nodes in stored scalars, only changing the color and opacity
+	// functions if the nodes or where the window puts them changed
+	void UpdateVolumeWindow(const bool nodesChanged);
+	// The stored scalars the opacity function does not leave transparent
+	VolumeOctree::ScalarIntervals GetVisibleScalarIntervals();
+	void UpdateVolumeCropping();
+	void UpdateMPRLookupTable();
 
 protected:
 	UnityGfxRenderer mAPIType;
@@ -322,16 +534,35 @@ protected:
 
 	// Volume data to render
 	std::vector<vtkSmartPointer<vtkImageData>> mVolumeDataVector;
+	std::vector<VolumeRecord> mVolumeRecords;
 	vtkSmartPointer<vtkImageData> mCurrentVolumeData;
 	int mCurrentVolumeIndex;
 
-	vtkSmartPointer<vtkImageData> mVolumeMask;
+	// Each volume has its own packed padding mask, only the current volume's
+	// is expanded and bound to its mappers
+	bool mPaddingMaskOn;
+	double mPaddingMaskValue;
+	vtkSmartPointer<vtkImageData> mCurrentVolumeMask;
 
 	// Synthetic volume to fall back on to rendering
 	vtkNew<vtkImageData> mSyntheticVolumeData;
 
 	// We also require one volume map per volume prop - so these are now a vector too
 	std::map<int, std::vector<vtkSmartPointer<vtkGPUVolumeRayCastMapper>>> mVolumeMappers;
+
+	// A streaming volume prop has one vtkVolume for every volume, and a few mappers, so a few
+	// textures, each holding a volume until the least recently shown is given another. Its
+	// vectors above hold the prop, and each volume's mapper if one holds it, else any from the
+	// pool, so every pool mapper is in them
+	struct StreamingVolumeProp
+	{
+		vtkSmartPointer<vtkVolume> volumeProp;
+		std::vector<vtkSmartPointer<vtkGPUVolumeRayCastMapper>> mappers;
+		std::vector<unsigned long long> mapperLastShown;
+		unsigned long long showCounter;
+	};
+	std::map<int, StreamingVolumeProp> mStreamingVolumeProps;
+
 	vtkNew<vtkColorTransferFunction> mVolumeColor;
 	vtkNew<vtkPiecewiseFunction> mVolumeOpacity;
 	vtkNew<vtkVolumeProperty> mVolumeProperty;
@@ -358,11 +589,90 @@ protected:
 
 	bool mRenderScene;
 
+	VolumeLoadOptions mVolumeLoadOptions;
+
+	// zero for no budget
+	unsigned long long mVolumeMemoryBudgetBytes;
+	unsigned long long mVolumeShowCounter;
+
+	bool mDeduplicateVolumes;
+
+	// zero for no bricks
+	int mVolumeBrickSize;
+	bool mEmptySpaceCropping;
+
+	// zero for a mapper per volume
+	int mVolumeStreamingPoolSize;
+
+	// the controller's sample distances, as last given to the volume mappers
+	bool mAutoAdjustSampleDistances;
+	bool mAdaptiveSamplingOn;
+	VolumeQualityController mVolumeQuality;
+	double mAppliedSampleDistanceScale;
+	double mAppliedImageSampleDistance;
+	// the GPU time of the last two renders, read back once the GPU has finished each,
+	// with their CPU times. The GL functions the timers use are loaded by the first render
+	vtkOpenGLRenderTimer mRenderTimers[2];
+	std::array<double, 2> mRenderCpuSeconds;
+	int mRenderTimerIndex;
+	bool mWindowRendered;
+
+	// while anything moves the volumes render with coarser sampling, and pyramid level
+	bool mMotionLODOn;
+	bool mInMotion;
+	double mMotionIdleSeconds;
+	double mMotionSampleDistanceScale;
+	double mMotionImageSampleDistance;
+	int mMotionVolumeLevel;
+	std::chrono::steady_clock::time_point mLastMotion;
+	// each camera's view when it last moved, by its projection, as the eyes differ in that
+	struct CameraView
+	{
+		std::array<double, 16> projectionMatrix;
+		std::array<double, 16> viewMatrix;
+	};
+	std::vector<CameraView> mCameraViews;
+	std::map<int, std::array<float, 16>> mLastTransforms;
+
+	// each camera's matrices, and the scene as it was, when last rendered, most recent last
+	struct RenderSignature
+	{
+		std::array<double, 16> viewMatrix;
+		std::array<double, 16> projectionMatrix;
+		vtkMTimeType sceneMTime;
+	};
+	bool mSkipUnchangedRenders;
+	std::vector<RenderSignature> mRenderSignatures;
+	int mNSkippedRenders;
+
+	// the level each volume prop and MPR is shown at, by prop id, 0 if not set
+	bool mVolumePyramidsOn;
+	std::map<int, int> mPropVolumeLevels;
+
 	double mWindowWidth;
 	double mWindowLevel;
+	double mMPRWindowWidth;
+	double mMPRWindowLevel;
+	// the rescale of the current volume, as applied to the transfer function and MPR lookup table
+	double mRescaleSlope;
+	double mRescaleIntercept;
 	double mOpacityFactor;
 	double mBrightnessFactor;
 	int mTransferFunctionIndex;
+	// the color and opacity are rebuilt once a frame, if anything they are built from changed
+	bool mTransferFunctionDirty;
+	// the shown transfer function's points as window fraction, red, green, blue and opacity,
+	// with the brightness and opacity factors applied, which the window only moves
+	std::vector<std::array<double, 5>> mTransferFunctionNodes;
+	bool mVolumeWindowDirty;
+	double mVolumeWindowShift;
+	double mVolumeWindowScale;
+
+	// Builds the volume pyramids, one volume at a time so loads keep the other cores
+	WorkerPool mPyramidWorkers;
+
+	// Background volume loads, kept last so its thread is stopped first on destruction
+	VolumeLoadQueue mVolumeLoads;
 
 	// Utility methods
 	virtual void VtkArgs_Prepare(
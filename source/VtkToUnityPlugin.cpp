@@ -3,13 +3,17 @@
 #include "VtkToUnityPlugin.h"
 
 #include "VtkToUnityInternalHelpers.h"
+#include "Volumes/VolumePhantom.h"
+#include "Volumes/VolumeSeries.h"
 
 #include <assert.h>
 #include <math.h>
+#include <atomic>
 #include <map>
 #include <queue>
 #include <vector>
 #include <sstream>
+#include <string>
 
 //#include <queue>
 //#include <mutex>
@@ -28,6 +32,9 @@ static Float4 ZeroFloat4()
 
 static std::weak_ptr<VtkToUnityAPI> sCurrentAPI;
 
+// the number of transfer functions once the queued edits are made, the renderer starts with one
+static std::atomic<int> sNTransferFunctions(1);
+
 // --------------------------------------------------------------------------
 // Connect to the debugging in unity
 
@@ -69,6 +76,12 @@ bool VtkToUnityPlugin::GotVtkToUnityAPI()
 
 void VtkToUnityPlugin::ProcessDeviceEventXYZ(UnityGfxDeviceEventType type, IUnityInterfaces* interfaces)
 {
+	// the renderer's resources, its transfer functions among them, are created afresh
+	if (kUnityGfxDeviceEventInitialize == type)
+	{
+		sNTransferFunctions = 1;
+	}
+
 	if (auto sharedAPI = sCurrentAPI.lock()) {
 		sharedAPI->ProcessDeviceEvent(type, interfaces);
 	}
@@ -175,6 +188,573 @@ extern "C" bool UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API LoadNrrdVolume(
 	return false;
 }
 
+extern "C" bool UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API LoadNiftiVolume(
+	const char *niftiPath)
+{
+	if (niftiPath == NULL) {
+		Debug(
+			DebugLogLevel::DebugLogWarning,
+			"LoadNiftiVolume: NULL string pointer passed in");
+		return false;
+	}
+
+	if (*niftiPath == '\0') {
+		Debug(
+			DebugLogLevel::DebugLogWarning,
+			"LoadNiftiVolume: string with no length passed in");
+		return false;
+	}
+
+	std::string niftiPathStr(niftiPath);
+
+	Debug(
+		DebugLogLevel::DebugLog,
+		std::string("LoadNiftiVolume: Loading NIfTI Data from ") + niftiPathStr);
+
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		return sharedAPI->LoadNiftiImage(niftiPathStr);
+	}
+
+	return false;
+}
+
+
+PLUGINEX(int) LoadVolumeSeries(int format, const char **paths, int nPaths)
+{
+	if (paths == NULL || nPaths <= 0 ||
+		format < 0 || format >= NVolumeFileFormat) {
+		Debug(
+			DebugLogLevel::DebugLogWarning,
+			"LoadVolumeSeries: no paths, or an unknown format, passed in");
+		return -1;
+	}
+
+	std::vector<std::string> pathStrs;
+	for (int iPath = 0; iPath < nPaths; ++iPath) {
+		if (paths[iPath] != NULL) {
+			pathStrs.push_back(std::string(paths[iPath]));
+		}
+	}
+
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		return sharedAPI->LoadVolumeSeries(static_cast<VolumeFileFormat>(format), pathStrs);
+	}
+
+	return -1;
+}
+
+
+PLUGINEX(int) LoadVolumeSeriesMatching(int format, const char *pattern)
+{
+	if (pattern == NULL || *pattern == '\0' ||
+		format < 0 || format >= NVolumeFileFormat) {
+		Debug(
+			DebugLogLevel::DebugLogWarning,
+			"LoadVolumeSeriesMatching: no pattern, or an unknown format, passed in");
+		return -1;
+	}
+
+	const std::vector<std::string> pathStrs = VolumeSeries::FindFrames(std::string(pattern));
+
+	Debug(
+		DebugLogLevel::DebugLog,
+		std::string("LoadVolumeSeriesMatching: ") + std::to_string(pathStrs.size()) + " frames match " + pattern);
+
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		return sharedAPI->LoadVolumeSeries(static_cast<VolumeFileFormat>(format), pathStrs);
+	}
+
+	return -1;
+}
+
+
+PLUGINEX(bool) LoadVolumeFromMemory(void *buffer, const int *dimensions, const double *spacing,
+	const double *origin, int scalarType, int nComponents, bool reverseSlices,
+	VolumeReleaseFuncPtr release, void *releaseUserData)
+{
+	// the buffer is released however the load ends
+	std::function<void()> releaseBuffer;
+	if (release != NULL) {
+		releaseBuffer = [release, buffer, releaseUserData]() { release(buffer, releaseUserData); };
+	}
+
+	if (buffer == NULL || dimensions == NULL || spacing == NULL || origin == NULL) {
+		Debug(
+			DebugLogLevel::DebugLogWarning,
+			"LoadVolumeFromMemory: NULL buffer, dimensions, spacing or origin passed in");
+		if (releaseBuffer) {
+			releaseBuffer();
+		}
+		return false;
+	}
+
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		return sharedAPI->LoadVolumeFromMemory(
+			buffer,
+			{ { dimensions[0], dimensions[1], dimensions[2] } },
+			{ { spacing[0], spacing[1], spacing[2] } },
+			{ { origin[0], origin[1], origin[2] } },
+			scalarType,
+			nComponents,
+			reverseSlices,
+			releaseBuffer);
+	}
+
+	if (releaseBuffer) {
+		releaseBuffer();
+	}
+	return false;
+}
+
+
+PLUGINEX(int) AddPhantomVolume(int type, int dimX, int dimY, int dimZ, int scalarType, int nFrames)
+{
+	if (type < 0 || type >= NVolumePhantomType || nFrames <= 0) {
+		Debug(
+			DebugLogLevel::DebugLogWarning,
+			"AddPhantomVolume: an unknown phantom type, or no frames, passed in");
+		return -1;
+	}
+
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		return sharedAPI->AddPhantomVolume(
+			static_cast<VolumePhantomType>(type), { { dimX, dimY, dimZ } }, scalarType, nFrames);
+	}
+
+	return -1;
+}
+
+
+PLUGINEX(bool) WritePhantomVolume(int type, int dimX, int dimY, int dimZ, int scalarType, int nFrames, int format, const char *path, bool compressed)
+{
+	if (path == NULL || *path == '\0' ||
+		type < 0 || type >= NVolumePhantomType || nFrames <= 0 ||
+		format < 0 || format >= NVolumeFileFormat) {
+		Debug(
+			DebugLogLevel::DebugLogWarning,
+			"WritePhantomVolume: no path, an unknown phantom type or format, or no frames, passed in");
+		return false;
+	}
+
+	const int dimensions[3] = { dimX, dimY, dimZ };
+
+	for (int frame = 0; frame < nFrames; ++frame) {
+		vtkSmartPointer<vtkImageData> volumeImageData = VolumePhantom::Generate(
+			static_cast<VolumePhantomType>(type), dimensions, scalarType, frame, nFrames);
+		const std::string framePath = VolumePhantom::FramePath(path, frame, nFrames);
+
+		if (nullptr == volumeImageData ||
+			!VolumePhantom::Write(volumeImageData, static_cast<VolumeFileFormat>(format), framePath, compressed)) {
+			Debug(
+				DebugLogLevel::DebugLogWarning,
+				std::string("WritePhantomVolume: could not generate or write ") + framePath);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+PLUGINEX(void) SetParallelDicomLoading(bool parallel)
+{
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		sharedAPI->SetParallelDicomLoading(parallel);
+	}
+}
+
+
+PLUGINEX(void) SetMemoryMappedLoading(bool memoryMapped)
+{
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		sharedAPI->SetMemoryMappedLoading(memoryMapped);
+	}
+}
+
+
+PLUGINEX(void) SetPipelinedInflate(bool pipelined)
+{
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		sharedAPI->SetPipelinedInflate(pipelined);
+	}
+}
+
+
+PLUGINEX(bool) BenchmarkVolumeReaders(int format, const char *path, int nRuns)
+{
+	if (path == NULL || *path == '\0' ||
+		format < 0 || format >= NVolumeFileFormat || nRuns <= 0) {
+		Debug(
+			DebugLogLevel::DebugLogWarning,
+			"BenchmarkVolumeReaders: no path, an unknown format, or no runs, passed in");
+		return false;
+	}
+
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		return sharedAPI->BenchmarkVolumeReaders(static_cast<VolumeFileFormat>(format), path, nRuns);
+	}
+
+	return false;
+}
+
+
+PLUGINEX(bool) BenchmarkVolumeLoadMemory(const char *folder, int sizeMB)
+{
+	if (folder == NULL || *folder == '\0' || sizeMB <= 0) {
+		Debug(
+			DebugLogLevel::DebugLogWarning,
+			"BenchmarkVolumeLoadMemory: no folder, or no size, passed in");
+		return false;
+	}
+
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		return sharedAPI->BenchmarkVolumeLoadMemory(folder, sizeMB);
+	}
+
+	return false;
+}
+
+
+PLUGINEX(bool) CheckVolumeSeriesLoading(const char *folder)
+{
+	if (folder == NULL || *folder == '\0') {
+		Debug(
+			DebugLogLevel::DebugLogWarning,
+			"CheckVolumeSeriesLoading: no folder passed in");
+		return false;
+	}
+
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		return sharedAPI->CheckVolumeSeriesLoading(folder);
+	}
+
+	return false;
+}
+
+
+PLUGINEX(void) SetProgressiveLoading(bool progressive, int previewStride)
+{
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		sharedAPI->SetProgressiveLoading(progressive, previewStride);
+	}
+}
+
+
+PLUGINEX(void) SetScalarNarrowing(int bitsPerVoxel)
+{
+	if (0 != bitsPerVoxel &&
+		8 != bitsPerVoxel &&
+		16 != bitsPerVoxel)
+	{
+		Debug(DebugLogLevel::DebugLogWarning, "SetScalarNarrowing: bitsPerVoxel must be 0, 8 or 16");
+		return;
+	}
+
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		sharedAPI->SetScalarNarrowing(bitsPerVoxel);
+	}
+}
+
+
+PLUGINEX(void) SetVolumeMemoryBudgetMB(int budgetMB)
+{
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		sharedAPI->SetVolumeMemoryBudgetMB(budgetMB);
+	}
+}
+
+
+PLUGINEX(int) GetNResidentVolumes()
+{
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		return sharedAPI->GetNResidentVolumes();
+	}
+
+	return -1;
+}
+
+
+PLUGINEX(int) GetNEvictedVolumes()
+{
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		return sharedAPI->GetNEvictedVolumes();
+	}
+
+	return -1;
+}
+
+
+PLUGINEX(void) SetVolumeDeduplication(bool deduplicate)
+{
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		sharedAPI->SetVolumeDeduplication(deduplicate);
+	}
+}
+
+
+PLUGINEX(int) GetNDistinctVolumes()
+{
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		return sharedAPI->GetNDistinctVolumes();
+	}
+
+	return -1;
+}
+
+
+PLUGINEX(void) SetVolumePyramids(bool enabled)
+{
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		sharedAPI->SetVolumePyramids(enabled);
+	}
+}
+
+
+PLUGINEX(int) GetNVolumePyramidLevels(int volumeIndex)
+{
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		return sharedAPI->GetNVolumePyramidLevels(volumeIndex);
+	}
+
+	return -1;
+}
+
+
+PLUGINEX(void) SetPropVolumeLevel(int propId, int level)
+{
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		sharedAPI->SetPropVolumeLevel(propId, level);
+	}
+}
+
+
+PLUGINEX(void) SetVolumeStreaming(int poolSize)
+{
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		sharedAPI->SetVolumeStreaming(poolSize);
+	}
+}
+
+
+PLUGINEX(void) SetEmptySpaceCropping(bool cropping)
+{
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		sharedAPI->SetEmptySpaceCropping(cropping);
+	}
+}
+
+
+PLUGINEX(bool) ProbeVolume(Float4 &positionM, float &value, float &opacity)
+{
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		double probedValue(0.0);
+		double probedOpacity(0.0);
+
+		if (sharedAPI->ProbeVolume(
+			{ { positionM.x, positionM.y, positionM.z } }, probedValue, probedOpacity)) {
+			value = static_cast<float>(probedValue);
+			opacity = static_cast<float>(probedOpacity);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+PLUGINEX(bool) CastRayIntoVolume(Float4 &originM, Float4 &directionM, Float4 &hitM)
+{
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		std::array<double, 3> hit;
+
+		if (sharedAPI->CastRayIntoVolume(
+			{ { originM.x, originM.y, originM.z } },
+			{ { directionM.x, directionM.y, directionM.z } },
+			hit)) {
+			hitM = StdArray3ToFloat4(hit);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+PLUGINEX(bool) GetVolumeStatistics(int volumeIndex, bool maskedOnly, int nBins, double *statistics, double *histogram)
+{
+	if (statistics == NULL || histogram == NULL) {
+		Debug(
+			DebugLogLevel::DebugLogWarning,
+			"GetVolumeStatistics: NULL statistics or histogram passed in");
+		return false;
+	}
+
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		return sharedAPI->GetVolumeStatistics(volumeIndex, maskedOnly, nBins, statistics, histogram);
+	}
+
+	return false;
+}
+
+
+PLUGINEX(void) SetVolumeBrickSize(int brickSize)
+{
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		sharedAPI->SetVolumeBrickSize(brickSize);
+	}
+}
+
+
+PLUGINEX(int) GetNVolumeBricks(int volumeIndex)
+{
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		return sharedAPI->GetNVolumeBricks(volumeIndex);
+	}
+
+	return -1;
+}
+
+
+PLUGINEX(int) GetNPaddingVolumeBricks(int volumeIndex)
+{
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		return sharedAPI->GetNPaddingVolumeBricks(volumeIndex);
+	}
+
+	return -1;
+}
+
+
+PLUGINEX(void) SetVolumeCacheEnabled(bool enabled)
+{
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		sharedAPI->SetVolumeCacheEnabled(enabled);
+	}
+}
+
+
+PLUGINEX(void) SetVolumeCacheFolder(const char *folder)
+{
+	if (folder == NULL || *folder == '\0') {
+		Debug(
+			DebugLogLevel::DebugLogWarning,
+			"SetVolumeCacheFolder: no folder passed in");
+		return;
+	}
+
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		sharedAPI->SetVolumeCacheFolder(std::string(folder));
+	}
+}
+
+
+PLUGINEX(void) SetVolumeCacheSizeLimitMB(int sizeLimitMB)
+{
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		sharedAPI->SetVolumeCacheSizeLimitMB(sizeLimitMB);
+	}
+}
+
+
+PLUGINEX(void) ClearVolumeCache()
+{
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		sharedAPI->ClearVolumeCache();
+	}
+}
+
+
+static int QueueVolumeLoad(
+	const VolumeFileFormat format,
+	const char *path,
+	const std::string &caller)
+{
+	if (path == NULL || *path == '\0') {
+		Debug(
+			DebugLogLevel::DebugLogWarning,
+			caller + ": no path passed in");
+		return -1;
+	}
+
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		return sharedAPI->LoadVolumeAsync(format, std::string(path));
+	}
+
+	return -1;
+}
+
+
+PLUGINEX(int) LoadDicomVolumeAsync(const char *dicomFolder)
+{
+	return QueueVolumeLoad(VolumeFileDicomFolder, dicomFolder, "LoadDicomVolumeAsync");
+}
+
+
+PLUGINEX(int) LoadMhdVolumeAsync(const char *mhdPath)
+{
+	return QueueVolumeLoad(VolumeFileMhd, mhdPath, "LoadMhdVolumeAsync");
+}
+
+
+PLUGINEX(int) LoadNrrdVolumeAsync(const char *nrrdPath)
+{
+	return QueueVolumeLoad(VolumeFileNrrd, nrrdPath, "LoadNrrdVolumeAsync");
+}
+
+
+PLUGINEX(int) LoadNiftiVolumeAsync(const char *niftiPath)
+{
+	return QueueVolumeLoad(VolumeFileNifti, niftiPath, "LoadNiftiVolumeAsync");
+}
+
+
+PLUGINEX(float) GetVolumeLoadProgress(int ticket)
+{
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		return sharedAPI->GetVolumeLoadProgress(ticket);
+	}
+
+	return 0.0f;
+}
+
+
+PLUGINEX(int) GetVolumeLoadStatus(int ticket)
+{
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		return static_cast<int>(sharedAPI->GetVolumeLoadStatus(ticket));
+	}
+
+	return static_cast<int>(VolumeLoadUnknown);
+}
+
+
+PLUGINEX(bool) IsVolumeLoadComplete(int ticket)
+{
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		return VolumeLoadComplete == sharedAPI->GetVolumeLoadStatus(ticket);
+	}
+
+	return false;
+}
+
+
+PLUGINEX(int) GetVolumeLoadIndex(int ticket)
+{
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		return sharedAPI->GetVolumeLoadIndex(ticket);
+	}
+
+	return -1;
+}
+
+
+PLUGINEX(void) CancelVolumeLoad(int ticket)
+{
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		sharedAPI->CancelVolumeLoad(ticket);
+	}
+}
+
 
 extern "C" bool CreatePaddingMask(int paddingValue)
 {
@@ -270,13 +850,35 @@ PLUGINEX(void) SetVolumeIndex(int index)
 }
 
 
+// Transfer function edits, made on the render thread as it reads the transfer functions,
+// in the order they were asked for
+struct TransferFunctionEdit
+{
+	enum EditType
+	{
+		ResetEdit,
+		AddEdit,
+		PointsEdit
+	};
+
+	EditType editType;
+	int transferFunctionIndex;
+	std::vector<double> windowFractions;
+	std::vector<double> reds;
+	std::vector<double> greens;
+	std::vector<double> blues;
+	std::vector<double> opacities;
+};
+static SafeQueue<TransferFunctionEdit> sTransferFunctionEdits;
+
+
 PLUGINEX(int) GetNTransferFunctions()
 {
-	if (auto sharedAPI = sCurrentAPI.lock()) {
-		return sharedAPI->GetNTransferFunctions();
+	if (sCurrentAPI.expired()) {
+		return -1;
 	}
 
-	return -1;
+	return sNTransferFunctions;
 }
 
 
@@ -299,21 +901,33 @@ PLUGINEX(void) SetTransferFunctionIndex(int index)
 
 PLUGINEX(int) AddTransferFunction()
 {
-	if (auto sharedAPI = sCurrentAPI.lock()) {
-		return sharedAPI->AddTransferFunction();
+	if (sCurrentAPI.expired()) {
+		return -1;
 	}
 
-	return -1;
+	TransferFunctionEdit edit;
+	edit.editType = TransferFunctionEdit::AddEdit;
+	edit.transferFunctionIndex = -1;
+	sTransferFunctionEdits.enqueue(edit);
+
+	return sNTransferFunctions++;
 }
 
 
 PLUGINEX(int) ResetTransferFunctions()
 {
-	if (auto sharedAPI = sCurrentAPI.lock()) {
-		return sharedAPI->ResetTransferFunctions();
+	if (sCurrentAPI.expired()) {
+		return -1;
 	}
 
-	return -1;
+	TransferFunctionEdit edit;
+	edit.editType = TransferFunctionEdit::ResetEdit;
+	edit.transferFunctionIndex = -1;
+	sTransferFunctionEdits.enqueue(edit);
+
+	// back to the one grey linear transfer function
+	sNTransferFunctions = 1;
+	return 0;
 }
 
 
@@ -325,15 +939,51 @@ PLUGINEX(void) SetTransferFunctionPoint(
 	double blue1,
 	double opacity1)
 {
-	if (auto sharedAPI = sCurrentAPI.lock()) {
-		sharedAPI->SetTransferFunctionPoint(
-			transferFunctionIndex,
-			windowFraction,
-			red1,
-			green1,
-			blue1,
-			opacity1);
+	SetTransferFunctionPoints(
+		transferFunctionIndex,
+		1,
+		&windowFraction,
+		&red1,
+		&green1,
+		&blue1,
+		&opacity1);
+}
+
+
+PLUGINEX(void) SetTransferFunctionPoints(
+	int transferFunctionIndex,
+	int nPoints,
+	double *windowFractions,
+	double *reds,
+	double *greens,
+	double *blues,
+	double *opacities)
+{
+	if (nPoints <= 0)
+	{
+		return;
 	}
+
+	if (NULL == windowFractions ||
+		NULL == reds ||
+		NULL == greens ||
+		NULL == blues ||
+		NULL == opacities)
+	{
+		Debug(DebugLogLevel::DebugLogWarning, "SetTransferFunctionPoints: NULL point arrays");
+		return;
+	}
+
+	// the arrays are copied, the caller may reuse them as soon as this returns
+	TransferFunctionEdit edit;
+	edit.editType = TransferFunctionEdit::PointsEdit;
+	edit.transferFunctionIndex = transferFunctionIndex;
+	edit.windowFractions.assign(windowFractions, windowFractions + nPoints);
+	edit.reds.assign(reds, reds + nPoints);
+	edit.greens.assign(greens, greens + nPoints);
+	edit.blues.assign(blues, blues + nPoints);
+	edit.opacities.assign(opacities, opacities + nPoints);
+	sTransferFunctionEdits.enqueue(edit);
 }
 
 
@@ -379,6 +1029,78 @@ PLUGINEX(void) SetTargetFrameRateFps(int targetFps)
 }
 
 
+static SafeQueue<std::pair<bool, float>> sNewAdaptiveSampling;
+PLUGINEX(void) SetAdaptiveSampling(bool adaptiveOn, float targetFps)
+{
+	sNewAdaptiveSampling.enqueue(std::make_pair(adaptiveOn, targetFps));
+}
+
+
+static SafeQueue<std::array<float, 4>> sNewAdaptiveSamplingBounds;
+PLUGINEX(void) SetAdaptiveSamplingBounds(
+	float minSampleDistanceScale,
+	float maxSampleDistanceScale,
+	float minImageSampleDistance,
+	float maxImageSampleDistance)
+{
+	sNewAdaptiveSamplingBounds.enqueue({ {
+		minSampleDistanceScale,
+		maxSampleDistanceScale,
+		minImageSampleDistance,
+		maxImageSampleDistance } });
+}
+
+
+PLUGINEX(float) GetRenderTimeMs()
+{
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		return sharedAPI->GetRenderTimeMs();
+	}
+
+	return -1.0f;
+}
+
+
+static SafeQueue<bool> sNewSkipUnchangedRenders;
+PLUGINEX(void) SetSkipUnchangedRenders(bool skipUnchanged)
+{
+	sNewSkipUnchangedRenders.enqueue(skipUnchanged);
+}
+
+
+PLUGINEX(int) GetNSkippedRenders()
+{
+	if (auto sharedAPI = sCurrentAPI.lock()) {
+		return sharedAPI->GetNSkippedRenders();
+	}
+
+	return -1;
+}
+
+
+static SafeQueue<std::pair<bool, float>> sNewMotionLOD;
+PLUGINEX(void) SetMotionLOD(bool motionLODOn, float idleSeconds)
+{
+	sNewMotionLOD.enqueue(std::make_pair(motionLODOn, idleSeconds));
+}
+
+
+struct MotionLODQuality
+{
+	float sampleDistanceScale;
+	float imageSampleDistance;
+	int volumeLevel;
+};
+static SafeQueue<MotionLODQuality> sNewMotionLODQuality;
+PLUGINEX(void) SetMotionLODQuality(
+	float sampleDistanceScale,
+	float imageSampleDistance,
+	int volumeLevel)
+{
+	sNewMotionLODQuality.enqueue({ sampleDistanceScale, imageSampleDistance, volumeLevel });
+}
+
+
 PLUGINEX(int) AddMPR(int existingMprId)
 {
 	if (auto sharedAPI = sCurrentAPI.lock()) {
@@ -815,6 +1537,35 @@ void VtkToUnityPlugin::UpdateCachedData()
 		return;
 	}
 
+	// the transfer function edits, ahead of the index and window changes made against them
+	while (!sTransferFunctionEdits.empty())
+	{
+		const TransferFunctionEdit edit = sTransferFunctionEdits.dequeue();
+
+		switch (edit.editType)
+		{
+		case TransferFunctionEdit::ResetEdit:
+			sharedAPI->ResetTransferFunctions();
+			break;
+		case TransferFunctionEdit::AddEdit:
+			sharedAPI->AddTransferFunction();
+			break;
+		case TransferFunctionEdit::PointsEdit:
+			sharedAPI->SetTransferFunctionPoints(
+				edit.transferFunctionIndex,
+				static_cast<int>(edit.windowFractions.size()),
+				edit.windowFractions.data(),
+				edit.reds.data(),
+				edit.greens.data(),
+				edit.blues.data(),
+				edit.opacities.data());
+			break;
+		}
+	}
+
+	// add any volumes finished by the background loader
+	sharedAPI->UpdateVolumeLoads();
+
 	while (!sPropTransformsWorldM.empty())
 	{
 		std::pair<int, Float16> propTransformWorldM = sPropTransformsWorldM.dequeue();
@@ -900,11 +1651,47 @@ void VtkToUnityPlugin::UpdateCachedData()
 		sharedAPI->SetTargetFrameRateFps(targetFramerateFps);
 	}
 
+	while (!sNewAdaptiveSamplingBounds.empty())
+	{
+		const std::array<float, 4> bounds = sNewAdaptiveSamplingBounds.dequeue();
+		sharedAPI->SetAdaptiveSamplingBounds(bounds[0], bounds[1], bounds[2], bounds[3]);
+	}
+
+	while (!sNewAdaptiveSampling.empty())
+	{
+		const std::pair<bool, float> adaptiveSampling = sNewAdaptiveSampling.dequeue();
+		sharedAPI->SetAdaptiveSampling(adaptiveSampling.first, adaptiveSampling.second);
+	}
+
+	while (!sNewMotionLODQuality.empty())
+	{
+		const MotionLODQuality quality = sNewMotionLODQuality.dequeue();
+		sharedAPI->SetMotionLODQuality(
+			quality.sampleDistanceScale,
+			quality.imageSampleDistance,
+			quality.volumeLevel);
+	}
+
+	while (!sNewMotionLOD.empty())
+	{
+		const std::pair<bool, float> motionLOD = sNewMotionLOD.dequeue();
+		sharedAPI->SetMotionLOD(motionLOD.first, motionLOD.second);
+	}
+
+	while (!sNewSkipUnchangedRenders.empty())
+	{
+		const bool skipUnchanged = sNewSkipUnchangedRenders.dequeue();
+		sharedAPI->SetSkipUnchangedRenders(skipUnchanged);
+	}
+
 	while (!sNewMPRWWWL.empty())
 	{
 		std::pair<float, float> wwwl = sNewMPRWWWL.dequeue();
 		sharedAPI->SetMPRWWWL(wwwl.first, wwwl.second);
 	}
+
+	// one rebuild for all of the transfer function and window changes above
+	sharedAPI->UpdateTransferFunction();
 }
 
 // actually do the render
@@ -36,6 +36,158 @@ PLUGINEX(bool) LoadDicomVolume(const char *dicomFolder);
 PLUGINEX(bool) LoadMhdVolume(const char *mhdPath);
 PLUGINEX(bool) LoadNrrdVolume(const char *nrrdPath);
 
+// NIfTI-1 .nii, .nii.gz or .hdr/.img, mixing with the other formats: spacing is taken in mm
+// and the origin from the sform (else qform) in the LPS space of DICOM, MetaImage and NRRD.
+// Uncompressed data is always memory mapped, gzipped data inflated straight into the volume
+PLUGINEX(bool) LoadNiftiVolume(const char *niftiPath);
+
+// Add a volume whose voxels are already in memory (scalarType a VTK type such as
+// VTK_SHORT = 4, spacing and origin in mm, as read from a file). reverseSlices takes the
+// slices in file order, as the file loaders do. With a release function the buffer is used
+// in place, without a copy, and release(buffer, releaseUserData) is called exactly once, on
+// any thread, when the plugin is done with it (including on failure); the buffer must not
+// change until then. Without one the buffer is copied and the caller may free it on return
+typedef void(*VolumeReleaseFuncPtr)(void*, void*);
+PLUGINEX(bool) LoadVolumeFromMemory(void *buffer, const int *dimensions, const double *spacing,
+	const double *origin, int scalarType, int nComponents, bool reverseSlices,
+	VolumeReleaseFuncPtr release, void *releaseUserData);
+
+// Load every frame of a time series at once (format is a VolumeFileFormat), either from a
+// list of paths in frame order or a wildcard pattern such as "C:/Study/frame_*.mhd", the
+// matches being ordered by the numbers in their names. Returns the number of frames added,
+// or -1 if any frame could not be read or the frames are not all on the same grid
+PLUGINEX(int) LoadVolumeSeries(int format, const char **paths, int nPaths);
+PLUGINEX(int) LoadVolumeSeriesMatching(int format, const char *pattern);
+
+// Procedural test volumes (type is a VolumePhantomType, scalarType a VTK scalar type such as
+// VTK_UNSIGNED_CHAR = 3, VTK_SHORT = 4, VTK_UNSIGNED_SHORT = 5, VTK_INT = 6 or VTK_FLOAT = 10),
+// the same arguments always give the same voxels. nFrames above 1 makes a series, which only
+// VolumePhantomBeatingHeart and VolumePhantomNoise vary over. AddPhantomVolume returns the
+// number of frames added. WritePhantomVolume writes them (format is a VolumeFileFormat) to
+// path, frames having a _000 style suffix, one frame at a time so they need not fit in memory.
+// compressed writes MetaImage and NRRD data deflated, as for BenchmarkVolumeReaders
+PLUGINEX(int) AddPhantomVolume(int type, int dimX, int dimY, int dimZ, int scalarType, int nFrames);
+PLUGINEX(bool) WritePhantomVolume(int type, int dimX, int dimY, int dimZ, int scalarType, int nFrames, int format, const char *path, bool compressed);
+
+// Choose between the multi-threaded DICOM reader (default) and vtkDICOMImageReader,
+// each load logs its read time, and BenchmarkVolumeReaders compares the two on a folder
+PLUGINEX(void) SetParallelDicomLoading(bool parallel);
+
+// Map uncompressed MetaImage and NRRD data read-only rather than reading it (off by default),
+// a mapped volume is only copied, reversed along z, when it is first shown
+PLUGINEX(void) SetMemoryMappedLoading(bool memoryMapped);
+
+// Decode compressed MetaImage (CompressedData = True), gzip NRRD and .nii.gz data with a
+// pipelined inflate (on by default) rather than the VTK readers. BenchmarkVolumeReaders times both on
+// the file at path, nRuns times, and logs the results. Given a DICOM folder it times the parallel
+// DICOM reader against vtkDICOMImageReader instead. See WritePhantomVolume for test files of either
+PLUGINEX(void) SetPipelinedInflate(bool pipelined);
+PLUGINEX(bool) BenchmarkVolumeReaders(int format, const char *path, int nRuns);
+
+// Writes a 16 bit phantom of sizeMB (1024 for a 1 GB volume) to the existing folder as raw and
+// compressed MetaImage and as a DICOM series, left there afterwards, then loads it by each reader
+// path: mapped, pipelined inflate, parallel DICOM and the VTK reader. Logs the peak resident
+// memory of each load over that before it, against the volume size, sampled every millisecond
+PLUGINEX(bool) BenchmarkVolumeLoadMemory(const char *folder, int sizeMB);
+
+// Writes a three frame series of 16 bit phantoms in each format (DICOM, MetaImage, NRRD and
+// .nii.gz) to the existing folder, loads each with LoadVolumeSeries and clears it again.
+// Logs each result and returns whether all loaded. Only runs with no volumes loaded
+PLUGINEX(bool) CheckVolumeSeriesLoading(const char *folder);
+
+// Background loads (off by default) first add a preview taking every previewStride'th voxel,
+// then refine it to the full volume under the same index, the extents are always the full ones.
+// The load's status is VolumeLoadPreviewing while only the preview is shown
+PLUGINEX(void) SetProgressiveLoading(bool progressive, int previewStride);
+
+// Requantise volumes with wider scalars to 8 or 16 bits as they are loaded (0, the default,
+// keeps them as read). Window/level, transfer function and padding values stay in the
+// units of the source, they are rescaled to the stored values for each volume shown
+PLUGINEX(void) SetScalarNarrowing(int bitsPerVoxel);
+
+// Keep the voxels of at most budgetMB in memory (0, the default, for no limit). The least
+// recently shown volumes are dropped and read again from their source, or the volume cache,
+// when they are next shown; volumes with no source are written to a spill file in the cache
+// folder. The volume indices do not change
+PLUGINEX(void) SetVolumeMemoryBudgetMB(int budgetMB);
+PLUGINEX(int) GetNResidentVolumes();
+PLUGINEX(int) GetNEvictedVolumes();
+
+// Volumes added with the same voxels as one already in memory (on by default), such as a
+// study loaded twice, share its copy and, in props added after them, its mapper and texture.
+// Each keeps its own index. GetNDistinctVolumes is the number of copies actually held
+PLUGINEX(void) SetVolumeDeduplication(bool deduplicate);
+PLUGINEX(int) GetNDistinctVolumes();
+
+// Each volume gets 2x, 4x and 8x downsampled levels (on by default), built one volume at a
+// time in the background once it is loaded, or for a mapped volume first shown, and dropped
+// when it is evicted. GetNVolumePyramidLevels counts the full volume and the levels built so
+// far, it is 1 until the first is done. SetPropVolumeLevel shows a volume prop or MPR at a
+// level (0 for the full volume, up to 3), at the nearest finer one until it is built. The
+// padding mask is only applied at the full volume
+PLUGINEX(void) SetVolumePyramids(bool enabled);
+PLUGINEX(int) GetNVolumePyramidLevels(int volumeIndex);
+PLUGINEX(void) SetPropVolumeLevel(int propId, int level);
+
+// Volume props added after SetVolumeStreaming with a pool size above 0 (off by default) show
+// every volume, including those loaded after them, through one vtkVolume and a pool of that
+// many mappers. Each mapper's texture holds a volume until the least recently shown is given
+// the next volume shown that none hold, so the GPU holds at most poolSize volumes per prop
+PLUGINEX(void) SetVolumeStreaming(int poolSize);
+
+// The volume mappers are cropped to the bricks holding voxels the opacity transfer function,
+// and padding mask, leave visible (on by default), so the ray caster skips the empty space
+// around them. Kept up to date as the transfer function, window and volume change
+PLUGINEX(void) SetEmptySpaceCropping(bool cropping);
+
+// Queries of the current volume in its own space, in m, as the volume prop before its
+// transform. ProbeVolume gives the value, in the units of the source, and opacity of the
+// nearest voxel, false outside the volume. CastRayIntoVolume finds the first voxel along the
+// ray that is not transparent, sampling every half voxel and skipping the bricks that cannot
+// be seen, false if there is none
+PLUGINEX(bool) ProbeVolume(Float4 &positionM, float &value, float &opacity);
+PLUGINEX(bool) CastRayIntoVolume(Float4 &originM, Float4 &directionM, Float4 &hitM);
+
+// Statistics of the first component of a volume, of every voxel or only those the padding
+// mask keeps, in the units of the source. statistics takes NVolumeStatistic values, in the
+// order of VolumeStatistic: the voxels counted, min, max, mean, standard deviation and the
+// 1st to 99th percentiles; histogram takes nBins counts evenly spread from min to max. The
+// results are kept per volume, so asking again with the same bins does not read the voxels
+PLUGINEX(bool) GetVolumeStatistics(int volumeIndex, bool maskedOnly, int nBins, double *statistics, double *histogram);
+
+// Volumes are split into bricks of brickSize voxels a side (32 by default, 0 for none) as
+// they are first shown or masked, each with the range of its voxels and whether it is all
+// padding. Bricks decided by their range are masked without reading their voxels. The counts
+// are -1 for a volume with no bricks yet, the padding count is 0 until CreatePaddingMask
+PLUGINEX(void) SetVolumeBrickSize(int brickSize);
+PLUGINEX(int) GetNVolumeBricks(int volumeIndex);
+PLUGINEX(int) GetNPaddingVolumeBricks(int volumeIndex);
+
+// Off by default. Loaded volumes are cached on disk and mapped straight from there when
+// the unchanged source is loaded again. A volume is written to the cache by the thread that
+// loaded it, so a load on the main thread waits for the write, the Load...Async loads do not.
+// The entries hold the voxels unencrypted, so set a folder only the user can read rather than
+// the shared temporary folder
+PLUGINEX(void) SetVolumeCacheEnabled(bool enabled);
+PLUGINEX(void) SetVolumeCacheFolder(const char *folder);
+PLUGINEX(void) SetVolumeCacheSizeLimitMB(int sizeLimitMB);
+PLUGINEX(void) ClearVolumeCache();
+
+// Background loading, each returns a ticket (-1 on error) to poll for progress (0 to 1)
+// and status (VolumeLoadStatus). Loaded volumes are added on the render thread in the
+// order they were requested, GetVolumeLoadIndex then gives the index for SetVolumeIndex
+PLUGINEX(int) LoadDicomVolumeAsync(const char *dicomFolder);
+PLUGINEX(int) LoadMhdVolumeAsync(const char *mhdPath);
+PLUGINEX(int) LoadNrrdVolumeAsync(const char *nrrdPath);
+PLUGINEX(int) LoadNiftiVolumeAsync(const char *niftiPath);
+PLUGINEX(float) GetVolumeLoadProgress(int ticket);
+PLUGINEX(int) GetVolumeLoadStatus(int ticket);
+PLUGINEX(bool) IsVolumeLoadComplete(int ticket);
+PLUGINEX(int) GetVolumeLoadIndex(int ticket);
+PLUGINEX(void) CancelVolumeLoad(int ticket);
+
+// Masks out the voxels equal to paddingValue in every volume, each on its own voxels,
+// volumes loaded later are masked when first shown
 PLUGINEX(bool) CreatePaddingMask(int paddingValue);
 
 PLUGINEX(void) ClearVolumes();
@@ -55,6 +207,9 @@ PLUGINEX(void) SetVolumeIndex(int index);
 PLUGINEX(int) GetNTransferFunctions();
 PLUGINEX(int) GetTransferFunctionIndex();
 PLUGINEX(void) SetTransferFunctionIndex(int index);
+// Adding, resetting and setting points are queued and made on the render thread, in order,
+// at the next render event. The index returned, and GetNTransferFunctions, already count
+// the queued adds and resets
 PLUGINEX(int) AddTransferFunction();
 PLUGINEX(int) ResetTransferFunctions();
 PLUGINEX(void) SetTransferFunctionPoint(
@@ -64,6 +219,16 @@ PLUGINEX(void) SetTransferFunctionPoint(
 	double green1,
 	double blue1,
 	double opacity1);
+// Sets nPoints points, given as arrays of that length, at once. The transfer function, window,
+// opacity and brightness changes are all applied to the volume together before the next render
+PLUGINEX(void) SetTransferFunctionPoints(
+	int transferFunctionIndex,
+	int nPoints,
+	double *windowFractions,
+	double *reds,
+	double *greens,
+	double *blues,
+	double *opacities);
 
 PLUGINEX(void) SetVolumeWWWL(float windowWidth, float windowLevel);
 PLUGINEX(void) SetVolumeOpacityFactor(float opacityFactor);
@@ -74,6 +239,44 @@ PLUGINEX(void) SetRenderComposite(bool composite);
 PLUGINEX(void) SetTargetFrameRateOn(bool targetOn);
 PLUGINEX(void) SetTargetFrameRateFps(int targetFps);
 
+// Measures each render and holds it at targetFps (90 for VR) by coarsening the volume
+// mappers' ray sample distance, then their image sample distance, as soon as it runs over,
+// and refining them slowly once it has stayed well under. It takes over from
+// SetTargetFrameRateOn while on. The sample distance is a scale of each mapper's own
+// (1 to 4 by default), the image sample distance is in pixels (1 to 3 by default), both
+// at least 1. A render's time is the longer of its CPU time and its GPU time, read back a
+// frame later, where the GL has timer queries. GetRenderTimeMs is the smoothed time, in ms
+PLUGINEX(void) SetAdaptiveSampling(bool adaptiveOn, float targetFps);
+PLUGINEX(void) SetAdaptiveSamplingBounds(
+	float minSampleDistanceScale,
+	float maxSampleDistanceScale,
+	float minImageSampleDistance,
+	float maxImageSampleDistance);
+PLUGINEX(float) GetRenderTimeMs();
+
+// While the view matrix, a prop, crop plane or MPR transform changes, the volumes render
+// with their ray sample distance scaled by sampleDistanceScale (2 by default), an image
+// sample distance of imageSampleDistance pixels (2), and at least pyramid level volumeLevel
+// (0, the full volume). They go back to full quality once nothing has moved for idleSeconds
+// (0.3). Off by default. Each camera, told apart by its projection matrix, is compared
+// with its own last view, and changes under a millimetre, or the rotation equivalent, are
+// taken as tracking jitter. In VR the head still moves the view most frames, so there hold
+// the frame rate with SetAdaptiveSampling instead. Works on top of the latter
+PLUGINEX(void) SetMotionLOD(bool motionLODOn, float idleSeconds);
+PLUGINEX(void) SetMotionLODQuality(
+	float sampleDistanceScale,
+	float imageSampleDistance,
+	int volumeLevel);
+
+// Off by default. A render event whose view and projection matrices match one of the last
+// few cameras rendered, with no prop, mapper, volume, transfer function, light, plane or
+// reslice modified since, is skipped rather than ray cast again. The volumes are drawn
+// straight into Unity's target, so only turn it on for targets that keep their contents
+// between frames, e.g. a render texture the camera does not clear. GetNSkippedRenders
+// counts the renders skipped
+PLUGINEX(void) SetSkipUnchangedRenders(bool skipUnchanged);
+PLUGINEX(int) GetNSkippedRenders();
+
 // --------------------------------------------------------------------------
 // Shape primitive methods
 